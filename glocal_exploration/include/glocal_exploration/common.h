@@ -6,6 +6,9 @@
 #include <kindr/minimal/quat-transformation.h>
 #include <voxblox/core/common.h>
 
+#include "glocal_exploration/utils/inline_vector.h"
+#include "glocal_exploration/utils/shared_view.h"
+
 namespace glocal_exploration {
 
 // floating point accuracy
@@ -17,6 +20,12 @@ using Transformation = voxblox::Transformation;
 
 // Submapping related types
 using SubmapId = unsigned int;  // NOTE: This must match cblox's SubmapID type
+// NOTE: Most positions only overlap with a handful of submaps, so lists of
+//       submap IDs are stored inline to avoid heap allocations.
+using SubmapIdList = InlineVector<SubmapId, 16>;
+// NOTE: Maps hand out views of their internal submap ID lists instead of
+//       copying them.
+using SubmapIdListView = SharedView<SubmapIdList>;
 
 }  // namespace glocal_exploration
 
@@ -0,0 +1,121 @@
+#ifndef GLOCAL_EXPLORATION_MAPPING_BLOCK_CHANGE_TRACKER_H_
+#define GLOCAL_EXPLORATION_MAPPING_BLOCK_CHANGE_TRACKER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <voxblox/core/block_hash.h>
+#include <voxblox/core/common.h>
+
+#include "glocal_exploration/mapping/map_base.h"
+
+namespace glocal_exploration {
+/**
+ * Records which blocks of a map changed at which revision, s.t. consumers
+ * that remember the revision they last saw can process only what changed
+ * since. The changes are kept in a log that is ordered by revision and only
+ * reaches back to the oldest revision that a registered consumer still holds.
+ * The log is also capped in the number of blocks it holds, s.t. it does not
+ * grow while a consumer is idle. Consumers whose changes were trimmed that way
+ * are told that everything changed. All methods are thread-safe.
+ */
+class BlockChangeTracker {
+ public:
+  explicit BlockChangeTracker(const FloatingPoint block_size,
+                              const size_t max_num_logged_blocks = 100000u)
+      : block_size_(block_size),
+        max_num_logged_blocks_(max_num_logged_blocks) {}
+
+  // NOTE: Changes should only be marked once they are visible to the readers,
+  //       s.t. a reader that saw a revision also sees the map at that revision.
+  void markChanged(const voxblox::BlockIndexList& block_indices) {
+    if (block_indices.empty()) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    change_log_.emplace_back(++revision_, block_indices);
+    num_logged_blocks_ += block_indices.size();
+    trimChangeLog();
+  }
+  void markEverythingChanged() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    everything_changed_revision_ = ++revision_;
+    // NOTE: Consumers that are older get everything anyway.
+    change_log_.clear();
+    num_logged_blocks_ = 0u;
+    trimmed_revision_ = revision_;
+  }
+
+  // Consumers register once, and then hold the revision that they were last
+  // returned until their next query.
+  int addConsumer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    consumer_revisions_.emplace_back(0u);
+    return static_cast<int>(consumer_revisions_.size()) - 1;
+  }
+  MapBase::ObservedSpaceChanges getChangesSince(const int consumer_id,
+                                                const uint64_t revision) {
+    MapBase::ObservedSpaceChanges changes;
+    changes.block_size = block_size_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    CHECK_GE(consumer_id, 0);
+    CHECK_LT(consumer_id, static_cast<int>(consumer_revisions_.size()));
+    changes.revision = revision_;
+    // NOTE: If the requested changes were already trimmed, everything is
+    //       reported as changed.
+    changes.everything_changed = revision < everything_changed_revision_ ||
+                                 revision < trimmed_revision_;
+    if (!changes.everything_changed) {
+      const auto first_change_it =
+          std::partition_point(change_log_.begin(), change_log_.end(),
+                               [revision](const LogEntry& entry) {
+                                 return entry.first <= revision;
+                               });
+      voxblox::IndexSet changed_blocks;
+      for (auto it = first_change_it; it != change_log_.end(); ++it) {
+        changed_blocks.insert(it->second.begin(), it->second.end());
+      }
+      changes.changed_blocks.assign(changed_blocks.begin(),
+                                    changed_blocks.end());
+    }
+    consumer_revisions_[consumer_id] = revision_;
+    trimChangeLog();
+    return changes;
+  }
+
+ private:
+  const FloatingPoint block_size_;
+  const size_t max_num_logged_blocks_;
+
+  mutable std::mutex mutex_;
+  uint64_t revision_ = 0u;
+  uint64_t everything_changed_revision_ = 0u;
+  using LogEntry = std::pair<uint64_t, voxblox::BlockIndexList>;
+  std::deque<LogEntry> change_log_;  // Ordered by revision.
+  size_t num_logged_blocks_ = 0u;    // Summed over all entries of the log.
+  uint64_t trimmed_revision_ = 0u;   // The last revision that was trimmed.
+  std::vector<uint64_t> consumer_revisions_;
+
+  // Drop the changes that all consumers already saw, and the oldest changes
+  // beyond the log's capacity.
+  void trimChangeLog() {
+    uint64_t oldest_held_revision = revision_;
+    for (const uint64_t consumer_revision : consumer_revisions_) {
+      oldest_held_revision = std::min(oldest_held_revision, consumer_revision);
+    }
+    while (!change_log_.empty() &&
+           (change_log_.front().first <= oldest_held_revision ||
+            max_num_logged_blocks_ < num_logged_blocks_)) {
+      trimmed_revision_ = change_log_.front().first;
+      num_logged_blocks_ -= change_log_.front().second.size();
+      change_log_.pop_front();
+    }
+  }
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_MAPPING_BLOCK_CHANGE_TRACKER_H_
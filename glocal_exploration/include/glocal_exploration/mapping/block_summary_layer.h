@@ -0,0 +1,85 @@
+#ifndef GLOCAL_EXPLORATION_MAPPING_BLOCK_SUMMARY_LAYER_H_
+#define GLOCAL_EXPLORATION_MAPPING_BLOCK_SUMMARY_LAYER_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include <voxblox/core/block_hash.h>
+#include <voxblox/core/layer.h>
+#include <voxblox/core/voxel.h>
+
+#include "glocal_exploration/common.h"
+
+namespace glocal_exploration {
+/**
+ * Coarse statistics of an ESDF layer, which allow planners to prune their
+ * searches at block granularity. Summaries are kept for every allocated block
+ * and for superblocks of kSuperblockWidth^3 blocks. Voxels are classified the
+ * same way as by MapBase::getVoxelStateInLocalArea(...), i.e. observed voxels
+ * are free if their distance exceeds the voxel size. Unallocated blocks have
+ * no summary and are entirely unknown.
+ */
+class BlockSummaryLayer {
+ public:
+  using ConstPtr = std::shared_ptr<const BlockSummaryLayer>;
+  using EsdfLayer = voxblox::Layer<voxblox::EsdfVoxel>;
+  using BlockIndex = voxblox::BlockIndex;
+
+  static constexpr int kSuperblockWidth = 4;
+
+  struct Summary {
+    uint32_t num_unknown = 0u;
+    uint32_t num_free = 0u;
+    uint32_t num_occupied = 0u;
+    // Range of the ESDF distances of the observed voxels.
+    FloatingPoint min_distance = std::numeric_limits<FloatingPoint>::max();
+    FloatingPoint max_distance = std::numeric_limits<FloatingPoint>::lowest();
+
+    bool hasUnknown() const { return num_unknown != 0u; }
+    bool isFree() const { return num_unknown == 0u && num_occupied == 0u; }
+    void add(const Summary& other);
+  };
+
+  BlockSummaryLayer(const FloatingPoint voxel_size,
+                    const size_t voxels_per_side);
+  explicit BlockSummaryLayer(const EsdfLayer& esdf_layer);
+
+  // Recompute the summaries of the updated blocks and their superblocks, and
+  // drop the summaries of blocks that are no longer allocated.
+  void update(const EsdfLayer& esdf_layer,
+              const voxblox::BlockIndexList& updated_blocks);
+
+  // Return nullptr if the (super)block is entirely unknown.
+  const Summary* getBlockSummary(const BlockIndex& block_index) const;
+  const Summary* getSuperblockSummary(const BlockIndex& superblock_index) const;
+
+  BlockIndex getBlockIndex(const Point& position) const {
+    return voxblox::getGridIndexFromPoint<BlockIndex>(position,
+                                                      block_size_inv_);
+  }
+  static BlockIndex getSuperblockIndex(const BlockIndex& block_index);
+
+  // Whether the voxel state at the position is fully determined by a free
+  // block, including the neighbors used to interpolate the ESDF there.
+  bool isInFreeBlock(const Point& position) const;
+
+  FloatingPoint voxel_size() const { return voxel_size_; }
+  FloatingPoint block_size() const { return block_size_; }
+  size_t getNumberOfBlocks() const { return block_summaries_.size(); }
+
+ protected:
+  FloatingPoint voxel_size_;
+  size_t voxels_per_side_;
+  FloatingPoint block_size_;
+  FloatingPoint block_size_inv_;
+
+  voxblox::AnyIndexHashMapType<Summary>::type block_summaries_;
+  voxblox::AnyIndexHashMapType<Summary>::type superblock_summaries_;
+
+  Summary computeBlockSummary(const voxblox::Block<voxblox::EsdfVoxel>& block,
+                              const FloatingPoint free_threshold) const;
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_MAPPING_BLOCK_SUMMARY_LAYER_H_
@@ -0,0 +1,113 @@
+#ifndef GLOCAL_EXPLORATION_MAPPING_COMPACT_SUBMAP_LAYER_H_
+#define GLOCAL_EXPLORATION_MAPPING_COMPACT_SUBMAP_LAYER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <voxblox/core/block_hash.h>
+#include <voxblox/core/layer.h>
+#include <voxblox/core/voxel.h>
+
+#include "glocal_exploration/common.h"
+#include "glocal_exploration/mapping/map_base.h"
+
+namespace glocal_exploration {
+/**
+ * Immutable, compact copy of the parts of a frozen submap's TSDF and ESDF that
+ * the global planner needs. Per voxel, the ESDF distance is quantized to 8 bits
+ * and the ESDF observed flag and TSDF state are stored as bits. Blocks in which
+ * a quantity has the same value for all voxels only store that value, and
+ * blocks without observed voxels are dropped. This makes lookups cheap, the
+ * copy does not replace the submap's layers.
+ */
+class CompactSubmapLayer {
+ public:
+  using ConstPtr = std::shared_ptr<const CompactSubmapLayer>;
+  using GlobalIndex = voxblox::GlobalIndex;
+
+  // Distances beyond max_distance are clamped, which sets the quantization
+  // step to max_distance / 127.
+  CompactSubmapLayer(const voxblox::Layer<voxblox::TsdfVoxel>& tsdf_layer,
+                     const voxblox::Layer<voxblox::EsdfVoxel>& esdf_layer,
+                     const FloatingPoint max_distance);
+
+  FloatingPoint voxel_size() const { return voxel_size_; }
+  size_t voxels_per_side() const { return voxels_per_side_; }
+  FloatingPoint getQuantizationStep() const { return distance_step_; }
+
+  // ESDF lookups at a position in submap frame, matching the semantics of
+  // voxblox::EsdfMap. Interpolated lookups fail unless all 8 neighbors are
+  // observed.
+  bool isObserved(const Point& t_submap_position) const;
+  bool getDistance(const Point& t_submap_position, FloatingPoint* distance,
+                   const bool interpolate = true) const;
+
+  // State of a voxel according to the TSDF, as used for frontier detection.
+  MapBase::VoxelState getVoxelState(
+      const GlobalIndex& global_voxel_index) const;
+  // States of all voxels of a stored block, by linear index.
+  void getBlockVoxelStates(
+      const voxblox::BlockIndex& block_index,
+      std::vector<MapBase::VoxelState>* voxel_states) const;
+
+  voxblox::BlockIndexList getBlockIndices() const;
+
+  size_t getNumberOfBlocks() const { return blocks_.size(); }
+  size_t getMemoryUsage() const;
+
+ protected:
+  // A bit per voxel, which is only stored once if it is the same for all
+  // voxels of the block.
+  struct CompressedBits {
+    bool uniform_value = false;
+    std::vector<uint64_t> words;
+
+    bool get(const size_t linear_index) const {
+      if (words.empty()) {
+        return uniform_value;
+      }
+      return (words[linear_index / 64u] >> (linear_index % 64u)) & 1u;
+    }
+    void compress(const std::vector<bool>& values);
+  };
+
+  // A quantized distance per voxel, which is only stored once if it is the
+  // same for all voxels of the block.
+  struct CompressedDistances {
+    int8_t uniform_value = 0;
+    std::vector<int8_t> values;
+
+    int8_t get(const size_t linear_index) const {
+      return values.empty() ? uniform_value : values[linear_index];
+    }
+    void compress(const std::vector<int8_t>& quantized_distances);
+  };
+
+  struct Block {
+    CompressedBits esdf_observed;
+    CompressedDistances esdf_distances;
+    CompressedBits tsdf_observed;
+    CompressedBits tsdf_free;
+  };
+
+  const FloatingPoint voxel_size_;
+  const FloatingPoint voxel_size_inv_;
+  const size_t voxels_per_side_;
+  const FloatingPoint distance_step_;
+  voxblox::AnyIndexHashMapType<Block>::type blocks_;
+
+  // Returns nullptr if the voxel's block is not stored.
+  const Block* getBlockAndLinearIndex(const GlobalIndex& global_voxel_index,
+                                      size_t* linear_index) const;
+  bool getObservedDistance(const GlobalIndex& global_voxel_index,
+                           FloatingPoint* distance) const;
+
+  int8_t quantize(const FloatingPoint distance) const;
+  FloatingPoint dequantize(const int8_t quantized_distance) const {
+    return quantized_distance * distance_step_;
+  }
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_MAPPING_COMPACT_SUBMAP_LAYER_H_
@@ -0,0 +1,81 @@
+#ifndef GLOCAL_EXPLORATION_MAPPING_ESDF_INTERPOLATOR_H_
+#define GLOCAL_EXPLORATION_MAPPING_ESDF_INTERPOLATOR_H_
+
+#include <voxblox/core/layer.h>
+#include <voxblox/core/voxel.h>
+
+#include "glocal_exploration/common.h"
+
+namespace glocal_exploration {
+/**
+ * Helpers for trilinear interpolation between the centers of the 8 voxels
+ * surrounding a point. Corner c has the offset (c & 1, (c >> 1) & 1,
+ * (c >> 2) & 1) w.r.t. the base voxel, and q is the position of the point
+ * relative to the base voxel's center, in units of voxels (in [0, 1)^3).
+ */
+namespace trilinear {
+using CornerValues = Eigen::Matrix<FloatingPoint, 8, 1>;
+
+inline CornerValues getWeights(const Point& q) {
+  CornerValues weights;
+  for (int corner = 0; corner < 8; ++corner) {
+    weights[corner] = ((corner & 1) ? q.x() : 1.f - q.x()) *
+                      ((corner & 2) ? q.y() : 1.f - q.y()) *
+                      ((corner & 4) ? q.z() : 1.f - q.z());
+  }
+  return weights;
+}
+
+// Analytic gradient of the interpolated function, in units per voxel.
+inline Point getGradient(const CornerValues& corner_values, const Point& q) {
+  CornerValues dx, dy, dz;
+  for (int corner = 0; corner < 8; ++corner) {
+    const FloatingPoint wx = (corner & 1) ? q.x() : 1.f - q.x();
+    const FloatingPoint wy = (corner & 2) ? q.y() : 1.f - q.y();
+    const FloatingPoint wz = (corner & 4) ? q.z() : 1.f - q.z();
+    dx[corner] = ((corner & 1) ? 1.f : -1.f) * wy * wz;
+    dy[corner] = ((corner & 2) ? 1.f : -1.f) * wx * wz;
+    dz[corner] = ((corner & 4) ? 1.f : -1.f) * wx * wy;
+  }
+  return Point(dx.dot(corner_values), dy.dot(corner_values),
+               dz.dot(corner_values));
+}
+}  // namespace trilinear
+
+/**
+ * Single precision ESDF lookups on a voxblox layer, used for the queries the
+ * planners issue at high rates. Matches the semantics of voxblox::EsdfMap
+ * without the round trips through double precision: interpolated distances
+ * fail unless all 8 neighbors are observed, and distance and gradient lookups
+ * fall back to the nearest voxel like voxblox's adaptive interpolator.
+ */
+class EsdfInterpolator {
+ public:
+  using EsdfLayer = voxblox::Layer<voxblox::EsdfVoxel>;
+
+  // NOTE: The interpolator only stores a pointer to the layer, so it is cheap
+  //       to construct per query and must not outlive the layer.
+  explicit EsdfInterpolator(const EsdfLayer& esdf_layer);
+
+  bool isObserved(const Point& position) const;
+  bool getDistance(const Point& position, FloatingPoint* distance) const;
+  bool getDistanceAndGradient(const Point& position, FloatingPoint* distance,
+                              Point* gradient) const;
+
+ protected:
+  const EsdfLayer& esdf_layer_;
+  const FloatingPoint voxel_size_;
+  const FloatingPoint voxel_size_inv_;
+  const voxblox::IndexElement voxels_per_side_;
+
+  // Gather the distances of the 8 voxels surrounding the position. Returns
+  // false if any of them is unobserved.
+  bool getCornerDistances(const Point& position,
+                          trilinear::CornerValues* corner_distances,
+                          Point* q) const;
+  bool getObservedDistance(const voxblox::GlobalIndex& global_voxel_index,
+                           FloatingPoint* distance) const;
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_MAPPING_ESDF_INTERPOLATOR_H_
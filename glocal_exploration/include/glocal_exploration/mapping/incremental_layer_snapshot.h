@@ -0,0 +1,77 @@
+#ifndef GLOCAL_EXPLORATION_MAPPING_INCREMENTAL_LAYER_SNAPSHOT_H_
+#define GLOCAL_EXPLORATION_MAPPING_INCREMENTAL_LAYER_SNAPSHOT_H_
+
+#include <memory>
+#include <utility>
+
+#include <voxblox/core/block_hash.h>
+#include <voxblox/core/layer.h>
+
+namespace glocal_exploration {
+/**
+ * Maintains an immutable copy of a layer that is being written to by another
+ * thread. Snapshots share all blocks that did not change with their
+ * predecessor, such that refreshing a snapshot only copies the updated blocks.
+ */
+template <typename VoxelType>
+class IncrementalLayerSnapshot {
+ public:
+  using Layer = voxblox::Layer<VoxelType>;
+  using Block = voxblox::Block<VoxelType>;
+  using LayerConstPtr = std::shared_ptr<const Layer>;
+
+  // Refresh the snapshot. Must be called from the thread that owns the layer.
+  // NOTE: Blocks that are not in updated_blocks are assumed to be unchanged
+  //       since the last call and will be shared with the previous snapshot.
+  void update(const Layer& layer, const voxblox::BlockIndexList& updated_blocks,
+              int* num_copied_blocks = nullptr) {
+    auto new_snapshot =
+        std::make_shared<Layer>(layer.voxel_size(), layer.voxels_per_side());
+    const voxblox::IndexSet updated_block_set(updated_blocks.begin(),
+                                              updated_blocks.end());
+    int num_copies = 0;
+
+    voxblox::BlockIndexList allocated_blocks;
+    layer.getAllAllocatedBlocks(&allocated_blocks);
+    for (const voxblox::BlockIndex& block_index : allocated_blocks) {
+      typename Block::Ptr block;
+      if (snapshot_ && !updated_block_set.count(block_index)) {
+        block = snapshot_->getBlockPtrByIndex(block_index);
+      }
+      if (!block) {
+        block = copyBlock(layer.getBlockByIndex(block_index));
+        ++num_copies;
+      }
+      new_snapshot->insertBlock(std::make_pair(block_index, std::move(block)));
+    }
+
+    std::atomic_store(&snapshot_, std::move(new_snapshot));
+    if (num_copied_blocks) {
+      *num_copied_blocks = num_copies;
+    }
+  }
+
+  // Get the latest snapshot. Safe to call from any thread. Returns nullptr if
+  // no snapshot has been taken yet.
+  LayerConstPtr get() const { return std::atomic_load(&snapshot_); }
+
+  static typename Block::Ptr copyBlock(const Block& block) {
+    auto block_copy = std::make_shared<Block>(
+        block.voxels_per_side(), block.voxel_size(), block.origin());
+    for (size_t linear_index = 0u; linear_index < block.num_voxels();
+         ++linear_index) {
+      block_copy->getVoxelByLinearIndex(linear_index) =
+          block.getVoxelByLinearIndex(linear_index);
+    }
+    block_copy->has_data() = block.has_data();
+    return block_copy;
+  }
+
+ private:
+  // NOTE: The pointer itself is only exchanged atomically. Published layers
+  //       and their blocks are never modified again.
+  std::shared_ptr<Layer> snapshot_;
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_MAPPING_INCREMENTAL_LAYER_SNAPSHOT_H_
@@ -2,6 +2,7 @@
 #define GLOCAL_EXPLORATION_MAPPING_MAP_BASE_H_
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -9,24 +10,51 @@
 #include <voxblox/core/layer.h>
 
 #include "glocal_exploration/common.h"
+#include "glocal_exploration/mapping/block_summary_layer.h"
 #include "glocal_exploration/mapping/neighborhood_offsets.h"
 #include "glocal_exploration/state/waypoint.h"
 
 namespace glocal_exploration {
 
 class Communicator;
+class CompactSubmapLayer;
+class FrontierVoxelList;
 
 /**
  * Defines the interface of a map module that is needed by the planner.
+ *
+ * Concurrency contract: All queries may be called concurrently from any
+ * thread, e.g. by the planners, the collision avoidance and the frontier
+ * computation. Implementations update their maps on their own threads and
+ * expose them either through immutable snapshots, which are swapped atomically,
+ * or behind reader-writer locks that the queries hold for their duration.
+ * Everything handed out by pointer (layers, summaries) stays immutable for as
+ * long as it is held. Consecutive queries may however see different versions
+ * of the map.
  */
 class MapBase {
  public:
   enum class VoxelState { kUnknown, kOccupied, kFree };
 
+  // NOTE: Layers handed out through this pointer are immutable. They either
+  //       alias a frozen submap, which they keep alive, or are a snapshot of
+  //       the active map.
+  using TsdfLayerConstPtr =
+      std::shared_ptr<const voxblox::Layer<voxblox::TsdfVoxel>>;
+
   struct SubmapData {
     int id;
     Transformation T_M_S;
-    std::shared_ptr<const voxblox::Layer<voxblox::TsdfVoxel>> tsdf_layer;
+    TsdfLayerConstPtr tsdf_layer;
+    // Optional compact copy of a frozen submap, which is used instead of the
+    // TSDF layer if set.
+    std::shared_ptr<const CompactSubmapLayer> compact_layer;
+    // Optional summary of the submap's ESDF blocks.
+    BlockSummaryLayer::ConstPtr block_summary;
+    // Optional frontier candidates in submap frame, which the map tracks
+    // itself, e.g. for the submap that is still being integrated into. If set,
+    // they are used instead of extracting the candidates from the layers.
+    std::shared_ptr<const FrontierVoxelList> frontier_candidates;
   };
 
   explicit MapBase(std::shared_ptr<Communicator> communicator)
@@ -79,8 +107,37 @@ class MapBase {
 
   virtual VoxelState getVoxelStateInLocalArea(const Point& position) = 0;
 
+  // Summary of the active submap's ESDF blocks, or nullptr if the map does not
+  // maintain one. Since observed voxels of the active submap take precedence,
+  // voxels in its fully observed blocks have the same state in the local area.
+  virtual BlockSummaryLayer::ConstPtr getBlockSummaryOfActiveSubmap() const {
+    return nullptr;
+  }
+
   /* Global planner */
   virtual bool isObservedInGlobalMap(const Point& position) = 0;
+  // Batched version of the above, which maps can override to share the work
+  // between nearby positions.
+  virtual void areObservedInGlobalMap(const std::vector<Point>& positions,
+                                      std::vector<bool>* is_observed);
+
+  // Blocks of the mission frame in which isObservedInGlobalMap() may have
+  // changed since a given revision, s.t. the global planner can be updated
+  // incrementally. Maps that do not track their changes report that
+  // everything changed.
+  // NOTE: Consumers register once, s.t. the maps only keep the changes that a
+  //       consumer did not query yet.
+  struct ObservedSpaceChanges {
+    uint64_t revision = 0u;  // The current revision, to query the next changes.
+    bool everything_changed = true;  // If set, changed_blocks is empty.
+    FloatingPoint block_size = 0.f;
+    voxblox::BlockIndexList changed_blocks;
+  };
+  virtual int addObservedSpaceChangesConsumer() { return 0; }
+  virtual ObservedSpaceChanges getBlocksChangedSince(const int consumer_id,
+                                                     const uint64_t revision) {
+    return ObservedSpaceChanges();
+  }
 
   bool isTraversableInGlobalMap(const Point& position) {
     return isTraversableInGlobalMap(position, getTraversabilityRadius());
@@ -105,7 +162,7 @@ class MapBase {
   virtual bool getDistanceInGlobalMap(const Point& position,
                                       FloatingPoint* distance) = 0;
 
-  virtual std::vector<SubmapId> getSubmapIdsAtPosition(
+  virtual SubmapIdListView getSubmapIdsAtPosition(
       const Point& position) const = 0;
   virtual std::vector<SubmapData> getAllSubmapData() = 0;
 
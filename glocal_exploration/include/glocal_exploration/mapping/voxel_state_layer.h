@@ -0,0 +1,93 @@
+#ifndef GLOCAL_EXPLORATION_MAPPING_VOXEL_STATE_LAYER_H_
+#define GLOCAL_EXPLORATION_MAPPING_VOXEL_STATE_LAYER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <voxblox/core/block_hash.h>
+#include <voxblox/core/layer.h>
+#include <voxblox/core/voxel.h>
+
+#include "glocal_exploration/common.h"
+#include "glocal_exploration/mapping/map_base.h"
+
+namespace glocal_exploration {
+/**
+ * Stores the VoxelState of every voxel of a layer in 2 bits, such that state
+ * lookups only need a single block lookup and touch 1KB per 16^3 block. Blocks
+ * are immutable and shared between copies of the layer, so a copy can cheaply
+ * be published to other threads after every update.
+ */
+class VoxelStateLayer {
+ public:
+  using ConstPtr = std::shared_ptr<const VoxelStateLayer>;
+  using VoxelState = MapBase::VoxelState;
+  using BlockIndex = voxblox::BlockIndex;
+
+  class PackedBlock {
+   public:
+    explicit PackedBlock(const size_t num_voxels)
+        : words_((num_voxels + kVoxelsPerWord - 1u) / kVoxelsPerWord, 0u) {}
+
+    VoxelState get(const size_t linear_index) const {
+      return static_cast<VoxelState>(
+          (words_[linear_index / kVoxelsPerWord] >>
+           (2u * (linear_index % kVoxelsPerWord))) &
+          3u);
+    }
+    void set(const size_t linear_index, const VoxelState state) {
+      const size_t shift = 2u * (linear_index % kVoxelsPerWord);
+      uint64_t& word = words_[linear_index / kVoxelsPerWord];
+      word = (word & ~(uint64_t{3u} << shift)) |
+             (static_cast<uint64_t>(state) << shift);
+    }
+    size_t getMemoryUsage() const {
+      return sizeof(PackedBlock) + words_.capacity() * sizeof(uint64_t);
+    }
+
+   private:
+    static constexpr size_t kVoxelsPerWord = 32u;
+    std::vector<uint64_t> words_;
+  };
+  using PackedBlockConstPtr = std::shared_ptr<const PackedBlock>;
+
+  VoxelStateLayer(const FloatingPoint voxel_size, const size_t voxels_per_side);
+
+  // Observed voxels are free if their distance exceeds the free threshold,
+  // which matches MapBase::getVoxelStateInLocalArea(...) if set to the voxel
+  // size. TSDF voxels are observed if their weight exceeds min_weight.
+  static PackedBlockConstPtr packBlock(
+      const voxblox::Block<voxblox::EsdfVoxel>& esdf_block,
+      const FloatingPoint free_threshold);
+  static PackedBlockConstPtr packBlock(
+      const voxblox::Block<voxblox::TsdfVoxel>& tsdf_block,
+      const FloatingPoint free_threshold, const FloatingPoint min_weight);
+
+  void setBlock(const BlockIndex& block_index, PackedBlockConstPtr block) {
+    blocks_[block_index] = std::move(block);
+  }
+  void removeBlock(const BlockIndex& block_index) {
+    blocks_.erase(block_index);
+  }
+
+  // Repack the updated blocks of an ESDF layer and drop the blocks that are no
+  // longer allocated.
+  void update(const voxblox::Layer<voxblox::EsdfVoxel>& esdf_layer,
+              const voxblox::BlockIndexList& updated_blocks);
+
+  // Voxels in blocks that are not stored are unknown.
+  VoxelState getVoxelState(const Point& position) const;
+
+  size_t getNumberOfBlocks() const { return blocks_.size(); }
+  size_t getMemoryUsage() const;
+
+ protected:
+  const FloatingPoint voxel_size_;
+  const FloatingPoint voxel_size_inv_;
+  const size_t voxels_per_side_;
+  voxblox::AnyIndexHashMapType<PackedBlockConstPtr>::type blocks_;
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_MAPPING_VOXEL_STATE_LAYER_H_
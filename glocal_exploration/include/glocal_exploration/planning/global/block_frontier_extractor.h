@@ -0,0 +1,88 @@
+#ifndef GLOCAL_EXPLORATION_PLANNING_GLOBAL_BLOCK_FRONTIER_EXTRACTOR_H_
+#define GLOCAL_EXPLORATION_PLANNING_GLOBAL_BLOCK_FRONTIER_EXTRACTOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <voxblox/core/block_hash.h>
+#include <voxblox/core/common.h>
+
+#include "glocal_exploration/common.h"
+#include "glocal_exploration/mapping/map_base.h"
+
+namespace glocal_exploration {
+/**
+ * Extracts frontier candidates, i.e. unknown voxels that are adjacent to free
+ * space, by sweeping over a submap's blocks instead of flood-filling it voxel
+ * by voxel. The voxel states of each block are classified into bit masks that
+ * hold one row of voxels along x per word, and adjacencies are found with
+ * bitwise shifts that also reach across block faces, edges and corners.
+ */
+class BlockFrontierExtractor {
+ public:
+  using BlockIndex = voxblox::BlockIndex;
+  using GlobalIndex = voxblox::GlobalIndex;
+
+  // A row, including the voxels of both neighboring blocks, must fit a word.
+  static constexpr size_t kMaxVoxelsPerSide = 62u;
+
+  explicit BlockFrontierExtractor(const size_t voxels_per_side);
+
+  // Add an allocated block, given the states of its voxels by linear index.
+  void addBlock(const BlockIndex& block_index,
+                const std::vector<MapBase::VoxelState>& voxel_states);
+  // Remove a block, s.t. its voxels are unknown again.
+  void removeBlock(const BlockIndex& block_index) {
+    blocks_.erase(block_index);
+  }
+
+  // Get all unknown voxels that are 26-connected to a free voxel, including
+  // those in unallocated blocks. If a seed is given, only the free space that
+  // is 26-connected to the seed voxel is considered, as for a flood fill.
+  std::vector<GlobalIndex> extractFrontiers(
+      const GlobalIndex* seed_voxel_index = nullptr);
+
+  // Append the unknown voxels of a single block that are 26-connected to any
+  // free voxel, s.t. the frontiers can be maintained block by block.
+  void extractFrontiersInBlock(const BlockIndex& block_index,
+                               std::vector<GlobalIndex>* frontiers);
+
+ protected:
+  // One word per row of voxels along x, with rows indexed by y + z * n.
+  using Mask = std::vector<uint64_t>;
+  struct BlockMasks {
+    Mask free;
+    Mask observed;
+    Mask reached;  // Free space from which frontiers are detected.
+  };
+
+  const size_t voxels_per_side_;
+  const size_t padded_side_;
+  const uint64_t row_mask_;
+  voxblox::AnyIndexHashMapType<BlockMasks>::type blocks_;
+
+  // Scratch buffers of size padded_side_^2, and voxels_per_side_^2.
+  Mask padded_;
+  Mask x_dilated_;
+  Mask y_dilated_;
+  Mask cropped_;
+
+  // Copy a block's mask and the adjacent voxels of its neighbors into a grid
+  // that is padded by one voxel on each side.
+  void gatherPadded(const BlockIndex& block_index, Mask BlockMasks::*mask);
+  // Dilate the padded grid by one voxel in all 26 directions and crop it to
+  // the block.
+  void dilateAndCrop(Mask* output);
+  // Append the unknown voxels of the block that are adjacent to the mask.
+  void appendFrontiersInBlock(const BlockIndex& block_index,
+                              Mask BlockMasks::*reached,
+                              std::vector<GlobalIndex>* frontiers);
+
+  void floodFillFrom(const GlobalIndex& seed_voxel_index);
+  bool isReached(const GlobalIndex& voxel_index) const;
+  // Whether any of the voxel's 26 neighbors is reached.
+  bool hasReachedNeighbor(const GlobalIndex& voxel_index) const;
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_PLANNING_GLOBAL_BLOCK_FRONTIER_EXTRACTOR_H_
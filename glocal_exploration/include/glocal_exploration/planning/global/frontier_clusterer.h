@@ -0,0 +1,52 @@
+#ifndef GLOCAL_EXPLORATION_PLANNING_GLOBAL_FRONTIER_CLUSTERER_H_
+#define GLOCAL_EXPLORATION_PLANNING_GLOBAL_FRONTIER_CLUSTERER_H_
+
+#include <array>
+#include <vector>
+
+#include <voxblox/core/block_hash.h>
+#include <voxblox/core/common.h>
+
+#include "glocal_exploration/common.h"
+
+namespace glocal_exploration {
+/**
+ * Groups frontier voxels into 26-connected clusters. The voxels are scattered
+ * into sparse blocks of dense voxel grids, s.t. neighbors are found by array
+ * lookups instead of hashing, and connected voxels are joined with union-find.
+ * Runs in time and memory linear in the number of voxels.
+ */
+class FrontierClusterer {
+ public:
+  using GlobalIndex = voxblox::GlobalIndex;
+
+  // Label each voxel with the cluster it belongs to. The labels are
+  // consecutive, starting at 0. Returns the number of clusters.
+  // NOTE: The buffers are reused between calls, so this is not thread-safe.
+  int cluster(const std::vector<GlobalIndex>& voxels, std::vector<int>* labels);
+
+ protected:
+  static constexpr int kBlockSideBits = 3;
+  static constexpr int kBlockSide = 1 << kBlockSideBits;
+  static constexpr int kBlockVolume = kBlockSide * kBlockSide * kBlockSide;
+
+  // Position of each voxel in the input, or -1 if the voxel is not present.
+  struct Block {
+    voxblox::BlockIndex index;
+    std::array<int, kBlockVolume> voxels;
+  };
+  static int voxelLinearIndex(const int x, const int y, const int z) {
+    return x + (y + z * kBlockSide) * kBlockSide;
+  }
+  std::vector<Block> blocks_;
+  voxblox::AnyIndexHashMapType<int>::type block_ids_;
+
+  // Union-find forest over the input voxels, with union by size.
+  std::vector<int> parents_;
+  std::vector<int> sizes_;
+  int findRoot(int voxel);
+  void unite(int voxel_a, int voxel_b);
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_PLANNING_GLOBAL_FRONTIER_CLUSTERER_H_
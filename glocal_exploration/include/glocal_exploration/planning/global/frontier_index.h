@@ -0,0 +1,89 @@
+#ifndef GLOCAL_EXPLORATION_PLANNING_GLOBAL_FRONTIER_INDEX_H_
+#define GLOCAL_EXPLORATION_PLANNING_GLOBAL_FRONTIER_INDEX_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "glocal_exploration/3rd_party/nanoflann.hpp"
+#include "glocal_exploration/common.h"
+#include "glocal_exploration/planning/global/frontier_voxel_list.h"
+
+namespace glocal_exploration {
+/**
+ * KD-trees over the centroids and the points of a set of frontiers, s.t. the
+ * global planner can look up frontiers by proximity instead of comparing
+ * against all of them. Frontiers are referred to by their position in the
+ * vector they were built from.
+ */
+class FrontierIndex {
+ public:
+  // Frontier id and its centroid's euclidean distance to the query.
+  using FrontierDistance = std::pair<size_t, FloatingPoint>;
+
+  FrontierIndex() = default;
+  FrontierIndex(const FrontierIndex&) = delete;
+  FrontierIndex& operator=(const FrontierIndex&) = delete;
+
+  // Rebuild the index. The points are optional, s.t. an index can also be
+  // built over centroids only.
+  void build(std::vector<Point> centroids,
+             const std::vector<FrontierVoxelList::PointSpan>& frontiers = {});
+  void clear();
+
+  size_t size() const { return centroids_.points.size(); }
+  bool empty() const { return centroids_.points.empty(); }
+  size_t getNumPoints() const { return points_.points.size(); }
+  const Point& getCentroid(const size_t frontier_id) const {
+    return centroids_.points[frontier_id];
+  }
+
+  // Centroid queries. Results are sorted by increasing distance.
+  std::vector<FrontierDistance> getNearestFrontiers(const Point& position,
+                                                    const size_t k) const;
+  std::vector<FrontierDistance> getFrontiersWithinRadius(
+      const Point& position, const FloatingPoint radius) const;
+
+  // Point queries, e.g. which frontiers lie within sensor range of a vertex.
+  std::vector<size_t> getFrontiersWithPointsWithinRadius(
+      const Point& position, const FloatingPoint radius) const;
+  // NOTE: Only returns points of the given frontier, in no specific order.
+  std::vector<Point> getFrontierPointsWithinRadius(
+      const Point& position, const FloatingPoint radius,
+      const size_t frontier_id) const;
+
+ private:
+  struct PointData {
+    std::vector<Point> points;
+
+    // Nanoflann functionality (this is required s.t. nanoflann can run).
+    inline std::size_t kdtree_get_point_count() const { return points.size(); }
+
+    inline FloatingPoint kdtree_get_pt(const size_t idx,
+                                       const size_t dim) const {
+      return points[idx][dim];
+    }
+
+    template <class BBOX>
+    bool kdtree_get_bbox(BBOX& /* bb */) const {
+      return false;
+    }
+  };
+  typedef nanoflann::KDTreeSingleIndexAdaptor<
+      nanoflann::L2_Simple_Adaptor<FloatingPoint, PointData>, PointData, 3>
+      KDTree;
+  using RadiusResult = std::vector<std::pair<size_t, FloatingPoint>>;
+
+  PointData centroids_;
+  std::unique_ptr<KDTree> centroid_kdtree_;
+  PointData points_;
+  std::vector<size_t> point_frontier_ids_;
+  std::unique_ptr<KDTree> point_kdtree_;
+
+  static void radiusSearch(const KDTree& kdtree, const Point& position,
+                           const FloatingPoint radius, const bool sorted,
+                           RadiusResult* result);
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_PLANNING_GLOBAL_FRONTIER_INDEX_H_
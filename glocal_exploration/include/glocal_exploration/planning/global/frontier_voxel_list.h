@@ -0,0 +1,158 @@
+#ifndef GLOCAL_EXPLORATION_PLANNING_GLOBAL_FRONTIER_VOXEL_LIST_H_
+#define GLOCAL_EXPLORATION_PLANNING_GLOBAL_FRONTIER_VOXEL_LIST_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include <voxblox/core/common.h>
+
+#include "glocal_exploration/common.h"
+
+namespace glocal_exploration {
+/**
+ * List of frontier voxels that stores each voxel as three 16-bit grid
+ * coordinates in the frame of the list, e.g. a submap, instead of as a point.
+ * The coordinates are relative to the list's origin voxel, which lists that
+ * cover a large map should place near their voxels. Points are only computed
+ * when they are accessed, and ranges of the list are handed out as views
+ * instead of copies. Lists with voxels beyond the 16-bit range around their
+ * origin fall back to storing full grid indices.
+ */
+class FrontierVoxelList {
+ public:
+  using Index = voxblox::GlobalIndex;
+
+  // Read-only view of a range of the list, which yields the voxel centers.
+  // NOTE: Views must not outlive the list and are invalidated if it changes.
+  class PointSpan {
+   public:
+    class Iterator {
+     public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = Point;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = Point;
+
+      Iterator(const FrontierVoxelList* list, const size_t position)
+          : list_(list), position_(position) {}
+      Point operator*() const { return list_->getPoint(position_); }
+      Iterator& operator++() {
+        ++position_;
+        return *this;
+      }
+      bool operator==(const Iterator& other) const {
+        return position_ == other.position_;
+      }
+      bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+     private:
+      const FrontierVoxelList* list_;
+      size_t position_;
+    };
+
+    PointSpan() : list_(nullptr), begin_(0u), end_(0u) {}
+    PointSpan(const FrontierVoxelList* list, const size_t begin,
+              const size_t end)
+        : list_(list), begin_(begin), end_(end) {}
+
+    size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+    Point operator[](const size_t i) const {
+      return list_->getPoint(begin_ + i);
+    }
+    Iterator begin() const { return Iterator(list_, begin_); }
+    Iterator end() const { return Iterator(list_, end_); }
+
+   private:
+    const FrontierVoxelList* list_;
+    size_t begin_;
+    size_t end_;
+  };
+
+  explicit FrontierVoxelList(const FloatingPoint voxel_size = 0.f,
+                             const Index& origin = Index::Zero())
+      : voxel_size_(voxel_size), origin_(origin) {}
+
+  void push_back(const Index& index) {
+    const Index offset = index - origin_;
+    if (!is_wide_ && !isInPackedRange(offset)) {
+      convertToWide();
+    }
+    if (is_wide_) {
+      wide_voxels_.push_back(index);
+    } else {
+      voxels_.push_back({static_cast<int16_t>(offset.x()),
+                         static_cast<int16_t>(offset.y()),
+                         static_cast<int16_t>(offset.z())});
+    }
+  }
+  void reserve(const size_t size) {
+    if (is_wide_) {
+      wide_voxels_.reserve(size);
+    } else {
+      voxels_.reserve(size);
+    }
+  }
+  void clear() {
+    voxels_.clear();
+    wide_voxels_.clear();
+    is_wide_ = false;
+  }
+
+  size_t size() const {
+    return is_wide_ ? wide_voxels_.size() : voxels_.size();
+  }
+  bool empty() const { return size() == 0u; }
+  FloatingPoint voxel_size() const { return voxel_size_; }
+  const Index& origin() const { return origin_; }
+
+  Index getIndex(const size_t i) const {
+    if (is_wide_) {
+      return wide_voxels_[i];
+    }
+    const PackedIndex& voxel = voxels_[i];
+    return origin_ + Index(voxel[0], voxel[1], voxel[2]);
+  }
+  Point getPoint(const size_t i) const {
+    return voxblox::getCenterPointFromGridIndex(getIndex(i), voxel_size_);
+  }
+
+  PointSpan points() const { return PointSpan(this, 0u, size()); }
+  PointSpan points(const size_t begin, const size_t end) const {
+    return PointSpan(this, begin, end);
+  }
+
+ private:
+  using PackedIndex = std::array<int16_t, 3>;
+
+  FloatingPoint voxel_size_;
+  Index origin_;
+  std::vector<PackedIndex> voxels_;
+  // Only used once a voxel did not fit the packed coordinates.
+  bool is_wide_ = false;
+  std::vector<Index> wide_voxels_;
+
+  static bool isInPackedRange(const Index& offset) {
+    constexpr int64_t kMin = std::numeric_limits<int16_t>::min();
+    constexpr int64_t kMax = std::numeric_limits<int16_t>::max();
+    return kMin <= offset.minCoeff() && offset.maxCoeff() <= kMax;
+  }
+  void convertToWide() {
+    wide_voxels_.reserve(std::max(voxels_.capacity(), voxels_.size() + 1u));
+    for (size_t i = 0u; i < voxels_.size(); ++i) {
+      wide_voxels_.emplace_back(getIndex(i));
+    }
+    voxels_.clear();
+    voxels_.shrink_to_fit();
+    is_wide_ = true;
+  }
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_PLANNING_GLOBAL_FRONTIER_VOXEL_LIST_H_
@@ -0,0 +1,55 @@
+#ifndef GLOCAL_EXPLORATION_PLANNING_GLOBAL_INCREMENTAL_FRONTIER_TRACKER_H_
+#define GLOCAL_EXPLORATION_PLANNING_GLOBAL_INCREMENTAL_FRONTIER_TRACKER_H_
+
+#include <vector>
+
+#include <voxblox/core/block_hash.h>
+#include <voxblox/core/common.h>
+#include <voxblox/core/layer.h>
+#include <voxblox/core/voxel.h>
+
+#include "glocal_exploration/common.h"
+#include "glocal_exploration/planning/global/block_frontier_extractor.h"
+#include "glocal_exploration/planning/global/frontier_voxel_list.h"
+
+namespace glocal_exploration {
+/**
+ * Keeps track of the frontier candidates of a map that is still being
+ * integrated into, e.g. the active submap, by only reclassifying the blocks
+ * that changed and recomputing the frontiers in and around them. Unlike the
+ * extraction on finished submaps, all free space is considered, since there is
+ * no flood fill that could be updated incrementally.
+ */
+class IncrementalFrontierTracker {
+ public:
+  using BlockIndex = voxblox::BlockIndex;
+  using GlobalIndex = voxblox::GlobalIndex;
+
+  IncrementalFrontierTracker(const FloatingPoint voxel_size,
+                             const size_t voxels_per_side);
+
+  // Reclassify the updated blocks of the layer, forget the removed ones and
+  // update the frontiers that they affect. Updated blocks that are no longer
+  // allocated are removed as well.
+  void update(const voxblox::Layer<voxblox::TsdfVoxel>& tsdf_layer,
+              const voxblox::BlockIndexList& updated_blocks,
+              const voxblox::BlockIndexList& removed_blocks);
+
+  // Frontier candidates in the frame of the layer, stored relative to an
+  // origin near their center.
+  FrontierVoxelList getFrontiers() const;
+  size_t getNumberOfFrontiers() const { return num_frontiers_; }
+
+ protected:
+  const FloatingPoint voxel_size_;
+  const size_t voxels_per_side_;
+  BlockFrontierExtractor extractor_;
+
+  // Frontier voxels by block, s.t. only affected blocks are recomputed.
+  voxblox::AnyIndexHashMapType<std::vector<GlobalIndex>>::type
+      block_frontiers_;
+  size_t num_frontiers_ = 0u;
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_PLANNING_GLOBAL_INCREMENTAL_FRONTIER_TRACKER_H_
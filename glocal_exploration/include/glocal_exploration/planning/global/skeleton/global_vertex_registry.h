@@ -0,0 +1,90 @@
+#ifndef GLOCAL_EXPLORATION_PLANNING_GLOBAL_SKELETON_GLOBAL_VERTEX_REGISTRY_H_
+#define GLOCAL_EXPLORATION_PLANNING_GLOBAL_SKELETON_GLOBAL_VERTEX_REGISTRY_H_
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "glocal_exploration/common.h"
+#include "glocal_exploration/planning/global/skeleton/global_vertex_id.h"
+#include "glocal_exploration/planning/global/skeleton/skeleton_submap.h"
+
+namespace glocal_exploration {
+/**
+ * Assigns contiguous indices to the vertices of all skeleton submaps, s.t.
+ * graph searches can store their state in flat arrays, and caches the
+ * vertices' positions in mission frame. The vertices of each submap are kept
+ * in an immutable block that is shared by all copies of the registry, s.t.
+ * copying the registry to add or move a submap only copies the blocks that
+ * change. Global vertex IDs are translated into indices in O(1), and indices
+ * into vertex IDs and positions in O(log(number of submaps)).
+ */
+class GlobalVertexRegistry {
+ public:
+  static constexpr size_t kInvalidIndex = std::numeric_limits<size_t>::max();
+
+  // Assign the next range of indices to the vertices of the submap.
+  // NOTE: Each submap can only be added once.
+  void addSubmap(SkeletonSubmap::ConstPtr submap_ptr);
+
+  // Refresh the cached positions of the submaps whose pose changed. Returns
+  // true if any submap moved.
+  bool updatePoses();
+  bool hasOutdatedPoses() const;
+
+  // NOTE: Vertices that were removed from a submap's graph keep their index
+  //       but are not returned by getIndex().
+  size_t size() const { return num_indices_; }
+  size_t getIndex(const GlobalVertexId& vertex_id) const;
+  const GlobalVertexId& getVertexId(const size_t index) const {
+    const SubmapVertices& vertices = getSubmapVerticesByIndex(index);
+    return vertices.vertex_ids[index - vertices.offset];
+  }
+  const Point& getPosition(const size_t index) const {
+    const SubmapVertices& vertices = getSubmapVerticesByIndex(index);
+    return vertices.positions[index - vertices.offset];
+  }
+
+  bool hasSubmap(const SubmapId submap_id) const {
+    return submap_id < submap_vertices_.size() &&
+           submap_vertices_[submap_id];
+  }
+  // NOTE: These return nullptr or an identity pose for unknown submaps.
+  const SkeletonSubmap::ConstPtr& getSubmap(const SubmapId submap_id) const;
+  const Transformation& getSubmapPose(const SubmapId submap_id) const;
+  const std::vector<SkeletonSubmap::ConstPtr>& getSubmaps() const {
+    return submaps_;
+  }
+
+ protected:
+  // The vertices of one submap, by index relative to the submap's offset.
+  struct SubmapVertices {
+    SkeletonSubmap::ConstPtr submap_ptr;
+    Transformation T_M_S;  // Pose the cached positions were computed with.
+    size_t offset = 0u;
+    std::vector<GlobalVertexId> vertex_ids;
+    std::vector<Point> positions;
+  };
+  // NOTE: Voxgraph assigns consecutive submap IDs, so the blocks can be stored
+  //       in a vector that is indexed by submap ID.
+  std::vector<std::shared_ptr<const SubmapVertices>> submap_vertices_;
+  std::vector<SkeletonSubmap::ConstPtr> submaps_;  // In order of addition.
+
+  // The first index of each submap in order of addition, which increases
+  // monotonically, s.t. the submap of an index can be found by bisection.
+  struct SubmapOffset {
+    size_t offset;
+    SubmapId submap_id;
+  };
+  std::vector<SubmapOffset> submap_offsets_;
+  size_t num_indices_ = 0u;
+
+  // NOTE: The index must be valid, i.e. smaller than size().
+  const SubmapVertices& getSubmapVerticesByIndex(const size_t index) const;
+
+  static bool poseChanged(const SubmapVertices& vertices);
+  static void updatePositions(SubmapVertices* vertices);
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_PLANNING_GLOBAL_SKELETON_GLOBAL_VERTEX_REGISTRY_H_
@@ -1,20 +1,24 @@
 #ifndef GLOCAL_EXPLORATION_PLANNING_GLOBAL_SKELETON_SKELETON_A_STAR_H_
 #define GLOCAL_EXPLORATION_PLANNING_GLOBAL_SKELETON_SKELETON_A_STAR_H_
 
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
-#include <set>
+#include <mutex>
 #include <utility>
 #include <vector>
 
 #include <cblox/core/tsdf_esdf_submap.h>
 
 #include "glocal_exploration/planning/global/skeleton/global_vertex_id.h"
+#include "glocal_exploration/planning/global/skeleton/global_vertex_registry.h"
 #include "glocal_exploration/planning/global/skeleton/relative_waypoint.h"
 #include "glocal_exploration/planning/global/skeleton/skeleton_submap_collection.h"
 #include "glocal_exploration/state/communicator.h"
 #include "glocal_exploration/state/waypoint.h"
+#include "glocal_exploration/utils/indexed_min_heap.h"
 
 namespace glocal_exploration {
 class SkeletonAStar {
@@ -44,6 +48,16 @@ class SkeletonAStar {
     }
   };
 
+  // Performance of a search, e.g. to compare search implementations.
+  struct SearchStatistics {
+    size_t num_expansions = 0u;
+    size_t num_vertices_reached = 0u;
+    double duration_s = 0.0;
+    double getExpansionsPerSecond() const {
+      return 0.0 < duration_s ? num_expansions / duration_s : 0.0;
+    }
+  };
+
   SkeletonAStar(const Config& config,
                 std::shared_ptr<Communicator> communicator)
       : config_(config.checkValid()), comm_(std::move(communicator)) {}
@@ -78,11 +92,20 @@ class SkeletonAStar {
     skeleton_submap_collection_.addSubmap(std::move(submap_ptr),
                                           traversability_radius);
   }
+  // Refresh the cached vertex positions of the submaps that moved. Called by
+  // planPath(), other users of the search should call it before searching.
+  void updateSubmapPoses() {
+    skeleton_submap_collection_.updateSubmapPoses();
+  }
 
   VisualizationEdges getVisualizationEdges() const {
     std::lock_guard<std::mutex> lock_guard(visualization_data_mutex_);
     return visualization_edges_;
   }
+  SearchStatistics getLastSearchStatistics() const {
+    std::lock_guard<std::mutex> lock_guard(visualization_data_mutex_);
+    return last_search_statistics_;
+  }
 
  protected:
   const Config config_;
@@ -92,18 +115,37 @@ class SkeletonAStar {
 
   const GlobalVertexId kGoalVertexId{RelativeWayPoint::kOdomFrameId, -1u};
 
-  static void getSolutionVertexPath(
-      GlobalVertexId end_vertex_id,
-      const std::map<GlobalVertexId, GlobalVertexId>& parent_map,
-      std::vector<GlobalVertexId>* vertex_path);
-
-  static GlobalVertexId popSmallestFromOpen(
-      const std::map<GlobalVertexId, FloatingPoint>& f_score_map,
-      std::set<GlobalVertexId>* open_set);
-
-  // Persistent only for visualization purposes.
+  // Parents of the search are stored by vertex registry index, the goal
+  // vertex has the index after the registry's last vertex.
+  static constexpr size_t kNoParent = std::numeric_limits<size_t>::max();
+  static constexpr FloatingPoint kUnreached =
+      std::numeric_limits<FloatingPoint>::max();
+  void getSolutionVertexPath(const size_t end_vertex_index,
+                             const GlobalVertexRegistry& registry,
+                             std::vector<GlobalVertexId>* vertex_path) const;
+
+  // The search state is kept across searches s.t. it is only allocated when
+  // the registry grows. Each search stamps the entries it touches with its
+  // generation, entries with an older stamp read as unreached.
+  struct VertexSearchState {
+    uint32_t generation = 0u;
+    FloatingPoint g_score = kUnreached;
+    size_t parent = kNoParent;
+    bool is_closed = false;
+    bool is_end_vertex_candidate = false;
+  };
+  void resetSearchState(const size_t num_indices) const;
+  VertexSearchState& getSearchState(const size_t vertex_index) const;
+  mutable std::vector<VertexSearchState> search_states_;  // By index.
+  mutable std::vector<size_t> touched_indices_;
+  mutable uint32_t search_generation_ = 0u;
+  mutable IndexedMinHeap<FloatingPoint> open_set_;  // Keyed by f-score.
+  mutable std::mutex search_mutex_;
+
+  // Persistent only for visualization and statistics purposes.
   // Only used within getPathBetweenVertices().
   mutable VisualizationEdges visualization_edges_;
+  mutable SearchStatistics last_search_statistics_;
   mutable std::mutex visualization_data_mutex_;
 };
 }  // namespace glocal_exploration
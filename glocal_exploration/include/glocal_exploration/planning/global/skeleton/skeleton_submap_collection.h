@@ -1,50 +1,79 @@
 #ifndef GLOCAL_EXPLORATION_PLANNING_GLOBAL_SKELETON_SKELETON_SUBMAP_COLLECTION_H_
 #define GLOCAL_EXPLORATION_PLANNING_GLOBAL_SKELETON_SKELETON_SUBMAP_COLLECTION_H_
 
-#include <list>
-#include <map>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
+#include "glocal_exploration/planning/global/skeleton/global_vertex_registry.h"
 #include "glocal_exploration/planning/global/skeleton/skeleton_submap.h"
 
 namespace glocal_exploration {
+// NOTE: The submaps are stored in an immutable vertex registry that is replaced
+//       whenever a submap is added or moved, s.t. the planner can keep reading
+//       a consistent version while new submaps arrive from other threads. The
+//       new versions share the vertices of all unchanged submaps.
 class SkeletonSubmapCollection {
  public:
+  using VertexRegistryConstPtr = std::shared_ptr<const GlobalVertexRegistry>;
+
+  SkeletonSubmapCollection()
+      : vertex_registry_(std::make_shared<GlobalVertexRegistry>()) {}
+
   void addSubmap(cblox::TsdfEsdfSubmap::ConstPtr submap_ptr,
                  const float traversability_radius) {
     CHECK_NOTNULL(submap_ptr);
-    skeleton_submaps_.emplace(
-        submap_ptr->getID(),
-        std::make_shared<SkeletonSubmap>(submap_ptr, traversability_radius));
+    auto skeleton_submap =
+        std::make_shared<SkeletonSubmap>(submap_ptr, traversability_radius);
+    std::lock_guard<std::mutex> lock(registry_update_mutex_);
+    auto new_registry =
+        std::make_shared<GlobalVertexRegistry>(*getVertexRegistry());
+    new_registry->updatePoses();
+    new_registry->addSubmap(std::move(skeleton_submap));
+    std::atomic_store(&vertex_registry_,
+                      VertexRegistryConstPtr(std::move(new_registry)));
+  }
+
+  // Refresh the cached vertex positions if any submap moved since the last
+  // update, e.g. before planning.
+  void updateSubmapPoses() {
+    std::lock_guard<std::mutex> lock(registry_update_mutex_);
+    VertexRegistryConstPtr registry = getVertexRegistry();
+    if (!registry->hasOutdatedPoses()) {
+      return;
+    }
+    auto new_registry = std::make_shared<GlobalVertexRegistry>(*registry);
+    new_registry->updatePoses();
+    std::atomic_store(&vertex_registry_,
+                      VertexRegistryConstPtr(std::move(new_registry)));
+  }
+
+  VertexRegistryConstPtr getVertexRegistry() const {
+    return std::atomic_load(&vertex_registry_);
   }
 
   const SkeletonSubmap& getSubmapById(const SubmapId submap_id) const {
-    auto it = skeleton_submaps_.find(submap_id);
-    CHECK(it != skeleton_submaps_.end())
-        << "Could not find skeleton submap with ID " << submap_id;
-    return *it->second;
+    const SkeletonSubmap::ConstPtr& submap_ptr =
+        getVertexRegistry()->getSubmap(submap_id);
+    CHECK(submap_ptr) << "Could not find skeleton submap with ID "
+                      << submap_id;
+    // NOTE: Submaps are never removed, so the registry keeps it alive.
+    return *submap_ptr;
   }
 
   SkeletonSubmap::ConstPtr getSubmapConstPtrById(
       const SubmapId submap_id) const {
-    auto it = skeleton_submaps_.find(submap_id);
-    if (it == skeleton_submaps_.end()) {
-      return nullptr;
-    } else {
-      return it->second;
-    }
+    return getVertexRegistry()->getSubmap(submap_id);
   }
 
-  std::list<SkeletonSubmap::ConstPtr> getSubmapConstPtrs() const {
-    std::list<SkeletonSubmap::ConstPtr> submap_list;
-    for (const auto& submap_kv : skeleton_submaps_) {
-      submap_list.emplace_back(submap_kv.second);
-    }
-    return submap_list;
+  std::vector<SkeletonSubmap::ConstPtr> getSubmapConstPtrs() const {
+    return getVertexRegistry()->getSubmaps();
   }
 
  private:
-  std::map<SubmapId, SkeletonSubmap::Ptr> skeleton_submaps_;
+  VertexRegistryConstPtr vertex_registry_;
+  std::mutex registry_update_mutex_;
 };
 }  // namespace glocal_exploration
 
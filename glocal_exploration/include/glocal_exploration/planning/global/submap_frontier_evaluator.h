@@ -1,14 +1,20 @@
 #ifndef GLOCAL_EXPLORATION_PLANNING_GLOBAL_SUBMAP_FRONTIER_EVALUATOR_H_
 #define GLOCAL_EXPLORATION_PLANNING_GLOBAL_SUBMAP_FRONTIER_EVALUATOR_H_
 
+#include <cstdint>
+#include <future>
 #include <memory>
-#include <thread>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "glocal_exploration/3rd_party/config_utilities.hpp"
+#include "glocal_exploration/planning/global/frontier_clusterer.h"
+#include "glocal_exploration/planning/global/frontier_index.h"
+#include "glocal_exploration/planning/global/frontier_voxel_list.h"
 #include "glocal_exploration/planning/global/global_planner_base.h"
+#include "glocal_exploration/utils/thread_pool.h"
 
 namespace glocal_exploration {
 /**
@@ -23,6 +29,13 @@ class SubmapFrontierEvaluator : public GlobalPlannerBase {
     bool submaps_are_frozen = true;  // false: submap frontiers will be
                                      // recomputed and overwritten.
     int min_num_visible_frontier_points = 1;
+    int num_threads = 0;  // Frontier candidate extraction, 0: one per core.
+    bool use_block_frontier_extraction = true;  // false: voxel flood fill.
+    bool only_connected_frontiers = true;  // Only use free space connected
+                                           // to the submap origin.
+    // Submaps that moved less than this keep their global frontiers.
+    FloatingPoint submap_pose_translation_threshold = 0.1f;  // m
+    FloatingPoint submap_pose_rotation_threshold = 0.0523599f;  // rad
 
     Config();
     void checkParams() const override;
@@ -40,28 +53,43 @@ class SubmapFrontierEvaluator : public GlobalPlannerBase {
   ~SubmapFrontierEvaluator() override = default;
 
   // Methods.
+  // Queue the frontier candidate extraction for a submap, which runs in the
+  // background on the worker pool.
   void computeFrontiersForSubmap(const MapBase::SubmapData& data,
                                  const Point& initial_point);
 
   void updateFrontiers(const std::vector<MapBase::SubmapData>& data);
 
   // Access.
-  const std::unordered_map<int, std::vector<Point>>& getFrontierCandidates()
-      const {
-    return frontier_candidates_;
-  }
-  const std::vector<std::vector<Point>>& getActiveFrontiers() const {
-    return active_frontiers_;
-  }
-  const std::vector<Point>& getInactiveFrontiers() const {
-    return inactive_frontiers_;
+  // Waits for all queued frontier candidate extractions to finish.
+  std::unordered_map<int, FrontierVoxelList> getFrontierCandidates();
+  // NOTE: The views are valid until the next call to updateFrontiers().
+  std::vector<FrontierVoxelList::PointSpan> getActiveFrontiers() const;
+  FrontierVoxelList::PointSpan getInactiveFrontiers() const;
+  // Spatial index over the active frontiers, whose ids are their positions in
+  // getActiveFrontiers(). Valid until the next call to updateFrontiers().
+  const FrontierIndex& getActiveFrontierIndex() const {
+    return active_frontier_index_;
   }
 
+  // Classification of TSDF voxels for the frontier computation.
+  static MapBase::VoxelState tsdfVoxelState(const voxblox::TsdfVoxel& voxel,
+                                            const FloatingPoint voxel_size);
+
  protected:
-  void computeFrontierCandidates(
-      const voxblox::Layer<voxblox::TsdfVoxel>& layer,
-      const Point& initial_point,
-      std::pair<const int, std::vector<Point>>* output);
+  // The voxel_state functor maps a global voxel index to a VoxelState.
+  template <typename VoxelStateFunctor>
+  void computeFrontierCandidates(const VoxelStateFunctor& voxel_state,
+                                 const FloatingPoint voxel_size,
+                                 const Point& initial_point,
+                                 const int submap_id,
+                                 FrontierVoxelList* output) const;
+
+  // Sweeps the submap's blocks instead. Returns false if its blocks are too
+  // large for the bit masks.
+  bool computeFrontierCandidatesBlockwise(const MapBase::SubmapData& data,
+                                          const Point& initial_point,
+                                          FrontierVoxelList* output) const;
 
   Index indexFromPoint(const Point& point, FloatingPoint voxel_size_inv) const;
   Point centerPointFromIndex(const Index& index,
@@ -73,15 +101,81 @@ class SubmapFrontierEvaluator : public GlobalPlannerBase {
  protected:
   const Config config_;
 
-  // Aloow frontier computation in the background, although not in parallel.
-  std::unique_ptr<std::thread> frontier_computation_thread_;
-
   // Store for each submap id (first) all candidates (second) in submap frame.
-  std::unordered_map<int, std::vector<Point>> frontier_candidates_;
-
-  // Active frontiers (set of connected active candidates) in mission frame.
-  std::vector<std::vector<Point>> active_frontiers_;
-  std::vector<Point> inactive_frontiers_;
+  // Each slot is only written by the worker that computes it, and read once
+  // its computation has finished.
+  struct FrontierCandidateSlot {
+    FrontierVoxelList candidates;
+    std::shared_future<void> computation;
+    size_t version = 0u;  // Incremented whenever they are recomputed.
+    // Candidates that the map tracks itself and that were taken over.
+    std::shared_ptr<const FrontierVoxelList> tracked_candidates;
+  };
+  std::unordered_map<int, FrontierCandidateSlot> frontier_candidates_;
+  // Only guards insertions into the map and the slots' futures.
+  std::mutex frontier_candidates_mutex_;
+  // Returns nullptr if no candidates were computed for the submap.
+  const FrontierVoxelList* waitForFrontierCandidates(
+      const int submap_id, size_t* version = nullptr);
+
+  // The global frontier state in mission frame is kept between rounds, s.t.
+  // updateFrontiers() only processes what changed since the last round.
+  struct SubmapContribution {
+    Transformation T_M_S;
+    size_t candidates_version;
+    std::vector<Index> global_indices;  // May contain duplicates.
+  };
+  std::unordered_map<int, SubmapContribution> submap_contributions_;
+  struct GlobalCandidate {
+    int num_references = 0;  // Number of contributions that contain it.
+    bool is_checked = false;
+    bool is_observed = false;
+    bool isActive() const { return is_checked && !is_observed; }
+  };
+  voxblox::LongIndexHashMapType<GlobalCandidate>::type global_candidates_;
+  int map_changes_consumer_id_ = -1;
+  uint64_t map_revision_ = 0u;
+  // The checked candidates by the blocks of the map's change tracking that
+  // their observedness depends on, s.t. only those in changed blocks are
+  // rechecked.
+  FloatingPoint candidate_block_size_ = 0.f;  // Not tracked if zero.
+  FloatingPoint candidate_voxel_size_ = 0.f;
+  voxblox::AnyIndexHashMapType<IndexSet>::type candidate_blocks_;
+  // Active candidates grouped by connectivity, and the group of each.
+  std::unordered_map<int, IndexSet> frontiers_;
+  voxblox::LongIndexHashMapType<int>::type frontier_ids_;
+  int next_frontier_id_ = 0;
+
+  bool submapPoseChanged(const Transformation& T_M_S_old,
+                         const Transformation& T_M_S_new) const;
+  void addGlobalCandidates(const std::vector<Index>& indices,
+                           std::vector<Index>* new_candidates);
+  void removeGlobalCandidates(const std::vector<Index>& indices,
+                              std::vector<Index>* removed_active_candidates);
+  void getCandidateBlocks(const Index& index,
+                          voxblox::BlockIndexList* block_indices) const;
+  void addToCandidateBlocks(const Index& index);
+  void removeFromCandidateBlocks(const Index& index);
+  void rebuildCandidateBlocks(const FloatingPoint block_size,
+                              const FloatingPoint voxel_size);
+  // Removing candidates splits the frontiers they belonged to if needed,
+  // adding candidates merges the frontiers they connect.
+  void removeFromFrontiers(const std::vector<Index>& indices);
+  void addToFrontiers(const std::vector<Index>& indices);
+  // Add the connected parts of the points as new frontiers.
+  void addFrontiers(const std::vector<Index>& points, std::vector<int>* labels);
+  void rebuildFrontiers();
+  FrontierClusterer frontier_clusterer_;
+
+  // Active frontiers (set of connected active candidates) in mission frame,
+  // stored back to back.
+  FrontierVoxelList active_frontier_voxels_;
+  std::vector<std::pair<size_t, size_t>> active_frontier_ranges_;
+  // The inactive frontiers are only collected once they are requested.
+  std::vector<int> small_frontier_ids_;
+  mutable FrontierVoxelList inactive_frontier_voxels_;
+  mutable bool inactive_frontier_voxels_outdated_ = true;
+  FrontierIndex active_frontier_index_;
 
   // Neighbor lookup.
   const Index kNeighborOffsets[26] = {
@@ -92,6 +186,10 @@ class SubmapFrontierEvaluator : public GlobalPlannerBase {
       Index(0, -1, -1), Index(-1, 0, 0),  Index(-1, 1, 0),  Index(-1, -1, 0),
       Index(-1, 0, 1),  Index(-1, 1, 1),  Index(-1, -1, 1), Index(-1, 0, -1),
       Index(-1, 1, -1), Index(-1, -1, -1)};
+
+  // NOTE: Declared last s.t. the workers finish before the slots are
+  //       destroyed.
+  ThreadPool frontier_thread_pool_;
 };
 
 }  // namespace glocal_exploration
@@ -20,8 +20,11 @@ class FrameTransformer {
       const Transformation& T_O_i) const {
     return T_F_O_ * T_O_i;
   }
+  Point transformFromFixedToOdomFrame(const Point& t_F_position) const {
+    return T_F_O_.inverse() * t_F_position;
+  }
 
-  const std::string& getFixedFrameId() { return fixed_frame_id_; }
+  const std::string& getFixedFrameId() const { return fixed_frame_id_; }
 
  private:
   Transformation T_F_O_;
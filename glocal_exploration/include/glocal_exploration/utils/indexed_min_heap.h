@@ -0,0 +1,124 @@
+#ifndef GLOCAL_EXPLORATION_UTILS_INDEXED_MIN_HEAP_H_
+#define GLOCAL_EXPLORATION_UTILS_INDEXED_MIN_HEAP_H_
+
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace glocal_exploration {
+
+/**
+ * Binary min-heap over dense indices, e.g. the open set of a graph search.
+ * The position of every index in the heap is stored in a flat array, s.t. the
+ * key of an index that is already queued can be updated in O(log n).
+ */
+template <typename KeyType>
+class IndexedMinHeap {
+ public:
+  bool empty() const { return heap_.empty(); }
+  size_t size() const { return heap_.size(); }
+  bool contains(const size_t index) const {
+    return index < positions_.size() && positions_[index] != kNotQueued;
+  }
+
+  // Queue the index, or update its key if it is already queued.
+  void push(const size_t index, const KeyType key) {
+    if (positions_.size() <= index) {
+      positions_.resize(index + 1u, kNotQueued);
+    }
+    size_t position = positions_[index];
+    if (position == kNotQueued) {
+      position = heap_.size();
+      heap_.push_back(Element{key, index});
+      positions_[index] = position;
+      siftUp(position);
+    } else if (key < heap_[position].key) {
+      heap_[position].key = key;
+      siftUp(position);
+    } else {
+      heap_[position].key = key;
+      siftDown(position);
+    }
+  }
+
+  // NOTE: The heap must not be empty.
+  size_t top() const { return heap_.front().index; }
+  const KeyType& topKey() const { return heap_.front().key; }
+  size_t pop() {
+    const size_t index = heap_.front().index;
+    positions_[index] = kNotQueued;
+    if (1u < heap_.size()) {
+      heap_.front() = heap_.back();
+      positions_[heap_.front().index] = 0u;
+      heap_.pop_back();
+      siftDown(0u);
+    } else {
+      heap_.pop_back();
+    }
+    return index;
+  }
+
+  // NOTE: Only the queued indices are reset, s.t. clearing a heap that is
+  //       reused across searches does not scale with the largest index.
+  void clear() {
+    for (const Element& element : heap_) {
+      positions_[element.index] = kNotQueued;
+    }
+    heap_.clear();
+  }
+  void reserve(const size_t size) {
+    heap_.reserve(size);
+    positions_.reserve(size);
+  }
+
+ private:
+  static constexpr size_t kNotQueued = std::numeric_limits<size_t>::max();
+
+  struct Element {
+    KeyType key;
+    size_t index;
+  };
+  std::vector<Element> heap_;
+  std::vector<size_t> positions_;  // By index.
+
+  void siftUp(size_t position) {
+    const Element element = heap_[position];
+    while (0u < position) {
+      const size_t parent = (position - 1u) / 2u;
+      if (!(element.key < heap_[parent].key)) {
+        break;
+      }
+      place(position, heap_[parent]);
+      position = parent;
+    }
+    place(position, element);
+  }
+  void siftDown(size_t position) {
+    const Element element = heap_[position];
+    const size_t size = heap_.size();
+    while (true) {
+      size_t child = 2u * position + 1u;
+      if (size <= child) {
+        break;
+      }
+      if (child + 1u < size && heap_[child + 1u].key < heap_[child].key) {
+        ++child;
+      }
+      if (!(heap_[child].key < element.key)) {
+        break;
+      }
+      place(position, heap_[child]);
+      position = child;
+    }
+    place(position, element);
+  }
+  void place(const size_t position, const Element& element) {
+    heap_[position] = element;
+    positions_[element.index] = position;
+  }
+};
+
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_UTILS_INDEXED_MIN_HEAP_H_
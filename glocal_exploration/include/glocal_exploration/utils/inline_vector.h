@@ -0,0 +1,67 @@
+#ifndef GLOCAL_EXPLORATION_UTILS_INLINE_VECTOR_H_
+#define GLOCAL_EXPLORATION_UTILS_INLINE_VECTOR_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+namespace glocal_exploration {
+
+// Append-only vector that stores up to N elements without heap allocations
+// and only falls back to the heap if it grows beyond that.
+template <typename T, size_t N>
+class InlineVector {
+ public:
+  using value_type = T;
+  using const_iterator = const T*;
+
+  InlineVector() = default;
+  InlineVector(std::initializer_list<T> values) {
+    for (const T& value : values) {
+      push_back(value);
+    }
+  }
+
+  void push_back(const T& value) {
+    if (size_ < N) {
+      inline_storage_[size_] = value;
+    } else {
+      if (size_ == N) {
+        overflow_storage_.assign(inline_storage_.begin(),
+                                 inline_storage_.end());
+      }
+      overflow_storage_.push_back(value);
+    }
+    ++size_;
+  }
+  void clear() {
+    overflow_storage_.clear();
+    size_ = 0u;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0u; }
+  bool isInline() const { return size_ <= N; }
+
+  const T* data() const {
+    return isInline() ? inline_storage_.data() : overflow_storage_.data();
+  }
+  const T& operator[](size_t index) const { return data()[index]; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size_; }
+
+  bool contains(const T& value) const {
+    return std::find(begin(), end(), value) != end();
+  }
+
+ private:
+  std::array<T, N> inline_storage_;
+  std::vector<T> overflow_storage_;
+  size_t size_ = 0u;
+};
+
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_UTILS_INLINE_VECTOR_H_
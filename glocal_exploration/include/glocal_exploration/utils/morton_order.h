@@ -0,0 +1,64 @@
+#ifndef GLOCAL_EXPLORATION_UTILS_MORTON_ORDER_H_
+#define GLOCAL_EXPLORATION_UTILS_MORTON_ORDER_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include <glog/logging.h>
+#include <voxblox/core/block_hash.h>
+#include <voxblox/core/common.h>
+
+namespace glocal_exploration::morton_order {
+/**
+ * Utilities to visit blocks in Z-order (Morton order) instead of hash map
+ * order, such that blocks that are close in space are also processed and
+ * allocated close in time and memory.
+ */
+
+// Interleave the lowest 21 bits of a value with two zero bits each.
+inline uint64_t spreadBits(uint64_t value) {
+  value &= 0x1fffffu;
+  value = (value | value << 32u) & 0x1f00000000ffffu;
+  value = (value | value << 16u) & 0x1f0000ff0000ffu;
+  value = (value | value << 8u) & 0x100f00f00f00f00fu;
+  value = (value | value << 4u) & 0x10c30c30c30c30c3u;
+  value = (value | value << 2u) & 0x1249249249249249u;
+  return value;
+}
+
+// NOTE: Indices are offset by 2^20, s.t. all indices in [-2^20, 2^20) map to
+//       unique codes and negative indices are ordered before positive ones.
+inline uint64_t encode(const voxblox::BlockIndex& index) {
+  constexpr int64_t kOffset = int64_t{1} << 20;
+  return spreadBits(static_cast<uint64_t>(index.x() + kOffset)) |
+         spreadBits(static_cast<uint64_t>(index.y() + kOffset)) << 1u |
+         spreadBits(static_cast<uint64_t>(index.z() + kOffset)) << 2u;
+}
+
+inline void sort(voxblox::BlockIndexList* block_indices) {
+  CHECK_NOTNULL(block_indices);
+  std::sort(block_indices->begin(), block_indices->end(),
+            [](const voxblox::BlockIndex& lhs, const voxblox::BlockIndex& rhs) {
+              return encode(lhs) < encode(rhs);
+            });
+}
+
+inline voxblox::BlockIndexList getSortedBlockIndices(
+    const voxblox::IndexSet& block_indices) {
+  voxblox::BlockIndexList sorted_block_indices(block_indices.begin(),
+                                               block_indices.end());
+  sort(&sorted_block_indices);
+  return sorted_block_indices;
+}
+
+template <typename LayerType>
+inline voxblox::BlockIndexList getAllAllocatedBlocks(const LayerType& layer) {
+  voxblox::BlockIndexList block_indices;
+  layer.getAllAllocatedBlocks(&block_indices);
+  sort(&block_indices);
+  return block_indices;
+}
+
+}  // namespace glocal_exploration::morton_order
+
+#endif  // GLOCAL_EXPLORATION_UTILS_MORTON_ORDER_H_
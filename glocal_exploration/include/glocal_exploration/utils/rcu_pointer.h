@@ -0,0 +1,110 @@
+#ifndef GLOCAL_EXPLORATION_UTILS_RCU_POINTER_H_
+#define GLOCAL_EXPLORATION_UTILS_RCU_POINTER_H_
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace glocal_exploration {
+
+/**
+ * Read-copy-update pointer to an immutable object. Readers never lock or
+ * allocate, they just register in the current epoch while they hold a
+ * ReadGuard. Writers publish a new version and wait for all readers that could
+ * still see the previous version to leave before destroying it.
+ */
+template <typename T>
+class RcuPointer {
+ public:
+  class ReadGuard {
+   public:
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+    ReadGuard(ReadGuard&& other) noexcept
+        : reader_count_(other.reader_count_), value_(other.value_) {
+      other.reader_count_ = nullptr;
+    }
+    ~ReadGuard() {
+      if (reader_count_) {
+        reader_count_->fetch_sub(1);
+      }
+    }
+
+    // NOTE: Returns nullptr if no value has been published yet.
+    const T* get() const { return value_; }
+    const T* operator->() const { return value_; }
+    const T& operator*() const { return *value_; }
+    explicit operator bool() const { return value_ != nullptr; }
+
+   private:
+    friend class RcuPointer;
+    ReadGuard(std::atomic<int>* reader_count, const T* value)
+        : reader_count_(reader_count), value_(value) {}
+
+    std::atomic<int>* reader_count_;
+    const T* value_;
+  };
+
+  RcuPointer() : value_(nullptr), epoch_(0u), reader_counts_{{{0}, {0}}} {}
+  explicit RcuPointer(std::unique_ptr<T> initial_value) : RcuPointer() {
+    value_ = initial_value.release();
+  }
+  ~RcuPointer() { delete value_.load(); }
+
+  RcuPointer(const RcuPointer&) = delete;
+  RcuPointer& operator=(const RcuPointer&) = delete;
+
+  // Lock-free, safe to call from any thread.
+  ReadGuard read() const {
+    while (true) {
+      const unsigned int epoch = epoch_.load();
+      std::atomic<int>& reader_count = reader_counts_[epoch & 1u];
+      reader_count.fetch_add(1);
+      // Only proceed if the writer did not flip the epoch in the meantime,
+      // otherwise it might not be waiting for us
+      if (epoch_.load() == epoch) {
+        return ReadGuard(&reader_count, value_.load());
+      }
+      reader_count.fetch_sub(1);
+    }
+  }
+
+  // Replace the current version. Blocks until no reader can still access the
+  // previous version, which is then destroyed.
+  void publish(std::unique_ptr<T> new_value) {
+    exchange(std::move(new_value));
+  }
+
+  // Replace the current version and return the previous one, once no reader
+  // can still access it. This allows writers to recycle old versions, e.g. for
+  // double buffering.
+  std::unique_ptr<T> exchange(std::unique_ptr<T> new_value) {
+    std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+    T* old_value = value_.exchange(new_value.release());
+    synchronize();
+    return std::unique_ptr<T>(old_value);
+  }
+
+ private:
+  std::atomic<T*> value_;
+
+  // Readers register in the counter that corresponds to the parity of the
+  // current epoch
+  mutable std::atomic<unsigned int> epoch_;
+  mutable std::array<std::atomic<int>, 2> reader_counts_;
+  std::mutex writer_mutex_;
+
+  void synchronize() {
+    const unsigned int old_epoch = epoch_.fetch_add(1u);
+    const std::atomic<int>& old_reader_count = reader_counts_[old_epoch & 1u];
+    while (old_reader_count.load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+};
+
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_UTILS_RCU_POINTER_H_
@@ -0,0 +1,43 @@
+#ifndef GLOCAL_EXPLORATION_UTILS_SHARED_VIEW_H_
+#define GLOCAL_EXPLORATION_UTILS_SHARED_VIEW_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace glocal_exploration {
+
+/**
+ * Read-only view of an immutable container that is shared with its owner,
+ * e.g. a published snapshot. The view keeps the container alive, s.t. handing
+ * it out only costs a reference count increment instead of a copy.
+ */
+template <typename ContainerT>
+class SharedView {
+ public:
+  using value_type = typename ContainerT::value_type;
+  using const_iterator = typename ContainerT::const_iterator;
+
+  // NOTE: Default constructed views are empty.
+  SharedView() = default;
+  explicit SharedView(std::shared_ptr<const ContainerT> container)
+      : container_(std::move(container)) {}
+
+  size_t size() const { return get().size(); }
+  bool empty() const { return get().empty(); }
+  const_iterator begin() const { return get().begin(); }
+  const_iterator end() const { return get().end(); }
+  const value_type& operator[](size_t index) const { return get()[index]; }
+
+  const ContainerT& get() const {
+    static const ContainerT kEmptyContainer{};
+    return container_ ? *container_ : kEmptyContainer;
+  }
+
+ private:
+  std::shared_ptr<const ContainerT> container_;
+};
+
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_UTILS_SHARED_VIEW_H_
@@ -0,0 +1,89 @@
+#ifndef GLOCAL_EXPLORATION_UTILS_THREAD_POOL_H_
+#define GLOCAL_EXPLORATION_UTILS_THREAD_POOL_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace glocal_exploration {
+/**
+ * A fixed set of persistent worker threads that execute tasks from a shared
+ * queue in the order they were submitted.
+ */
+class ThreadPool {
+ public:
+  // Uses one thread per core if num_threads is 0.
+  explicit ThreadPool(size_t num_threads = 0u) : shutdown_(false) {
+    if (num_threads == 0u) {
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(num_threads);
+    for (size_t i = 0u; i < num_threads; ++i) {
+      workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+  }
+
+  // Finishes all queued tasks before returning.
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutdown_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Queue a task. The returned future becomes ready once it has been executed.
+  template <typename Task>
+  std::future<void> submit(Task&& task) {
+    auto packaged_task =
+        std::make_shared<std::packaged_task<void()>>(std::forward<Task>(task));
+    std::future<void> result = packaged_task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace([packaged_task] { (*packaged_task)(); });
+    }
+    cv_.notify_one();
+    return result;
+  }
+
+  size_t getNumThreads() const { return workers_.size(); }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::queue<std::function<void()>> tasks_;
+  bool shutdown_;
+  std::vector<std::thread> workers_;
+
+  void workerLoop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return shutdown_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_UTILS_THREAD_POOL_H_
@@ -0,0 +1,144 @@
+#include "glocal_exploration/mapping/block_summary_layer.h"
+
+#include <algorithm>
+
+#include "glocal_exploration/utils/morton_order.h"
+
+namespace glocal_exploration {
+
+void BlockSummaryLayer::Summary::add(const Summary& other) {
+  num_unknown += other.num_unknown;
+  num_free += other.num_free;
+  num_occupied += other.num_occupied;
+  min_distance = std::min(min_distance, other.min_distance);
+  max_distance = std::max(max_distance, other.max_distance);
+}
+
+BlockSummaryLayer::BlockSummaryLayer(const FloatingPoint voxel_size,
+                                     const size_t voxels_per_side)
+    : voxel_size_(voxel_size),
+      voxels_per_side_(voxels_per_side),
+      block_size_(voxel_size * voxels_per_side),
+      block_size_inv_(1.f / block_size_) {}
+
+BlockSummaryLayer::BlockSummaryLayer(const EsdfLayer& esdf_layer)
+    : BlockSummaryLayer(esdf_layer.voxel_size(),
+                        esdf_layer.voxels_per_side()) {
+  update(esdf_layer, morton_order::getAllAllocatedBlocks(esdf_layer));
+}
+
+void BlockSummaryLayer::update(const EsdfLayer& esdf_layer,
+                               const voxblox::BlockIndexList& updated_blocks) {
+  CHECK_EQ(esdf_layer.voxels_per_side(), voxels_per_side_);
+  voxblox::IndexSet updated_superblocks;
+
+  // Drop the blocks that were released, e.g. when the map was reset
+  for (auto it = block_summaries_.begin(); it != block_summaries_.end();) {
+    if (esdf_layer.hasBlock(it->first)) {
+      ++it;
+    } else {
+      updated_superblocks.insert(getSuperblockIndex(it->first));
+      it = block_summaries_.erase(it);
+    }
+  }
+
+  const FloatingPoint free_threshold = voxel_size_;
+  for (const BlockIndex& block_index : updated_blocks) {
+    const auto block_ptr = esdf_layer.getBlockPtrByIndex(block_index);
+    if (block_ptr) {
+      block_summaries_[block_index] =
+          computeBlockSummary(*block_ptr, free_threshold);
+    } else {
+      block_summaries_.erase(block_index);
+    }
+    updated_superblocks.insert(getSuperblockIndex(block_index));
+  }
+
+  // Aggregate the superblocks from their blocks
+  for (const BlockIndex& superblock_index : updated_superblocks) {
+    Summary superblock_summary;
+    bool has_blocks = false;
+    BlockIndex block_index;
+    for (int x = 0; x < kSuperblockWidth; ++x) {
+      for (int y = 0; y < kSuperblockWidth; ++y) {
+        for (int z = 0; z < kSuperblockWidth; ++z) {
+          block_index =
+              superblock_index * kSuperblockWidth + BlockIndex(x, y, z);
+          const Summary* block_summary = getBlockSummary(block_index);
+          if (block_summary) {
+            superblock_summary.add(*block_summary);
+            has_blocks = true;
+          }
+        }
+      }
+    }
+    if (has_blocks) {
+      superblock_summaries_[superblock_index] = superblock_summary;
+    } else {
+      superblock_summaries_.erase(superblock_index);
+    }
+  }
+}
+
+const BlockSummaryLayer::Summary* BlockSummaryLayer::getBlockSummary(
+    const BlockIndex& block_index) const {
+  const auto it = block_summaries_.find(block_index);
+  return it != block_summaries_.end() ? &it->second : nullptr;
+}
+
+const BlockSummaryLayer::Summary* BlockSummaryLayer::getSuperblockSummary(
+    const BlockIndex& superblock_index) const {
+  const auto it = superblock_summaries_.find(superblock_index);
+  return it != superblock_summaries_.end() ? &it->second : nullptr;
+}
+
+BlockSummaryLayer::BlockIndex BlockSummaryLayer::getSuperblockIndex(
+    const BlockIndex& block_index) {
+  // Round towards negative infinity, s.t. superblocks don't straddle zero
+  BlockIndex superblock_index;
+  for (int axis = 0; axis < 3; ++axis) {
+    const int index = block_index[axis];
+    superblock_index[axis] =
+        (index < 0 ? index - kSuperblockWidth + 1 : index) / kSuperblockWidth;
+  }
+  return superblock_index;
+}
+
+bool BlockSummaryLayer::isInFreeBlock(const Point& position) const {
+  const BlockIndex block_index = getBlockIndex(position);
+  const Summary* summary = getBlockSummary(block_index);
+  if (!summary || !summary->isFree()) {
+    return false;
+  }
+  // The ESDF is interpolated between the 8 nearest voxel centers, which must
+  // all lie in the block
+  const Point t_block_position =
+      position - block_index.cast<FloatingPoint>() * block_size_;
+  const FloatingPoint half_voxel_size = 0.5f * voxel_size_;
+  return (t_block_position.array() >= half_voxel_size).all() &&
+         (t_block_position.array() < block_size_ - half_voxel_size).all();
+}
+
+BlockSummaryLayer::Summary BlockSummaryLayer::computeBlockSummary(
+    const voxblox::Block<voxblox::EsdfVoxel>& block,
+    const FloatingPoint free_threshold) const {
+  Summary summary;
+  for (size_t linear_index = 0u; linear_index < block.num_voxels();
+       ++linear_index) {
+    const voxblox::EsdfVoxel& voxel = block.getVoxelByLinearIndex(linear_index);
+    if (!voxel.observed) {
+      ++summary.num_unknown;
+      continue;
+    }
+    if (voxel.distance > free_threshold) {
+      ++summary.num_free;
+    } else {
+      ++summary.num_occupied;
+    }
+    summary.min_distance = std::min(summary.min_distance, voxel.distance);
+    summary.max_distance = std::max(summary.max_distance, voxel.distance);
+  }
+  return summary;
+}
+
+}  // namespace glocal_exploration
@@ -0,0 +1,245 @@
+#include "glocal_exploration/mapping/compact_submap_layer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "glocal_exploration/mapping/esdf_interpolator.h"
+#include "glocal_exploration/utils/morton_order.h"
+
+namespace glocal_exploration {
+
+CompactSubmapLayer::CompactSubmapLayer(
+    const voxblox::Layer<voxblox::TsdfVoxel>& tsdf_layer,
+    const voxblox::Layer<voxblox::EsdfVoxel>& esdf_layer,
+    const FloatingPoint max_distance)
+    : voxel_size_(tsdf_layer.voxel_size()),
+      voxel_size_inv_(1.f / tsdf_layer.voxel_size()),
+      voxels_per_side_(tsdf_layer.voxels_per_side()),
+      distance_step_(max_distance / 127.f) {
+  CHECK_GT(max_distance, 0.f);
+  CHECK_EQ(esdf_layer.voxels_per_side(), voxels_per_side_);
+  CHECK_NEAR(esdf_layer.voxel_size(), voxel_size_, voxblox::kFloatEpsilon);
+
+  // NOTE: The TSDF state is classified the same way as in the
+  //       SubmapFrontierEvaluator, where the surface is slightly inflated.
+  constexpr FloatingPoint kTsdfMinWeight = 1e-6;
+  const FloatingPoint tsdf_free_threshold = voxel_size_;
+
+  voxblox::BlockIndexList tsdf_blocks;
+  voxblox::BlockIndexList esdf_blocks;
+  tsdf_layer.getAllAllocatedBlocks(&tsdf_blocks);
+  esdf_layer.getAllAllocatedBlocks(&esdf_blocks);
+  voxblox::IndexSet block_indices(tsdf_blocks.begin(), tsdf_blocks.end());
+  block_indices.insert(esdf_blocks.begin(), esdf_blocks.end());
+  blocks_.reserve(block_indices.size());
+
+  const size_t num_voxels_per_block =
+      voxels_per_side_ * voxels_per_side_ * voxels_per_side_;
+  std::vector<bool> esdf_observed(num_voxels_per_block);
+  std::vector<int8_t> esdf_distances(num_voxels_per_block);
+  std::vector<bool> tsdf_observed(num_voxels_per_block);
+  std::vector<bool> tsdf_free(num_voxels_per_block);
+  // NOTE: Blocks are inserted in Morton order, s.t. neighboring blocks also
+  //       tend to be allocated close to each other.
+  for (const voxblox::BlockIndex& block_index :
+       morton_order::getSortedBlockIndices(block_indices)) {
+    const auto tsdf_block = tsdf_layer.getBlockPtrByIndex(block_index);
+    const auto esdf_block = esdf_layer.getBlockPtrByIndex(block_index);
+    bool block_is_observed = false;
+    for (size_t linear_index = 0u; linear_index < num_voxels_per_block;
+         ++linear_index) {
+      // NOTE: Unobserved voxels are set to zero, s.t. they don't prevent
+      //       blocks from being stored as uniform.
+      esdf_observed[linear_index] = false;
+      esdf_distances[linear_index] = 0;
+      tsdf_observed[linear_index] = false;
+      tsdf_free[linear_index] = false;
+      if (esdf_block) {
+        const voxblox::EsdfVoxel& voxel =
+            esdf_block->getVoxelByLinearIndex(linear_index);
+        if (voxel.observed) {
+          esdf_observed[linear_index] = true;
+          esdf_distances[linear_index] = quantize(voxel.distance);
+          block_is_observed = true;
+        }
+      }
+      if (tsdf_block) {
+        const voxblox::TsdfVoxel& voxel =
+            tsdf_block->getVoxelByLinearIndex(linear_index);
+        if (voxel.weight > kTsdfMinWeight) {
+          tsdf_observed[linear_index] = true;
+          tsdf_free[linear_index] = voxel.distance > tsdf_free_threshold;
+          block_is_observed = true;
+        }
+      }
+    }
+    if (!block_is_observed) {
+      continue;
+    }
+
+    Block& block = blocks_[block_index];
+    block.esdf_observed.compress(esdf_observed);
+    block.esdf_distances.compress(esdf_distances);
+    block.tsdf_observed.compress(tsdf_observed);
+    block.tsdf_free.compress(tsdf_free);
+  }
+}
+
+bool CompactSubmapLayer::isObserved(const Point& t_submap_position) const {
+  size_t linear_index;
+  const Block* block = getBlockAndLinearIndex(
+      voxblox::getGridIndexFromPoint<GlobalIndex>(t_submap_position,
+                                                  voxel_size_inv_),
+      &linear_index);
+  return block && block->esdf_observed.get(linear_index);
+}
+
+bool CompactSubmapLayer::getDistance(const Point& t_submap_position,
+                                     FloatingPoint* distance,
+                                     const bool interpolate) const {
+  CHECK_NOTNULL(distance);
+  if (!interpolate) {
+    return getObservedDistance(voxblox::getGridIndexFromPoint<GlobalIndex>(
+                                   t_submap_position, voxel_size_inv_),
+                               distance);
+  }
+
+  // Interpolate trilinearly between the centers of the 8 surrounding voxels
+  const GlobalIndex base_index = voxblox::getGridIndexFromPoint<GlobalIndex>(
+      t_submap_position - Point::Constant(0.5f * voxel_size_), voxel_size_inv_);
+  const Point q = t_submap_position * voxel_size_inv_ -
+                  Point::Constant(0.5f) - base_index.cast<FloatingPoint>();
+  trilinear::CornerValues corner_distances;
+  for (int corner = 0; corner < 8; ++corner) {
+    const GlobalIndex offset(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+    if (!getObservedDistance(base_index + offset, &corner_distances[corner])) {
+      return false;
+    }
+  }
+  *distance = trilinear::getWeights(q).dot(corner_distances);
+  return true;
+}
+
+MapBase::VoxelState CompactSubmapLayer::getVoxelState(
+    const GlobalIndex& global_voxel_index) const {
+  size_t linear_index;
+  const Block* block =
+      getBlockAndLinearIndex(global_voxel_index, &linear_index);
+  if (block && block->tsdf_observed.get(linear_index)) {
+    return block->tsdf_free.get(linear_index) ? MapBase::VoxelState::kFree
+                                              : MapBase::VoxelState::kOccupied;
+  }
+  return MapBase::VoxelState::kUnknown;
+}
+
+void CompactSubmapLayer::getBlockVoxelStates(
+    const voxblox::BlockIndex& block_index,
+    std::vector<MapBase::VoxelState>* voxel_states) const {
+  CHECK_NOTNULL(voxel_states);
+  const size_t num_voxels_per_block =
+      voxels_per_side_ * voxels_per_side_ * voxels_per_side_;
+  voxel_states->assign(num_voxels_per_block, MapBase::VoxelState::kUnknown);
+  const auto block_it = blocks_.find(block_index);
+  if (block_it == blocks_.end()) {
+    return;
+  }
+  const Block& block = block_it->second;
+  for (size_t linear_index = 0u; linear_index < num_voxels_per_block;
+       ++linear_index) {
+    if (block.tsdf_observed.get(linear_index)) {
+      (*voxel_states)[linear_index] = block.tsdf_free.get(linear_index)
+                                          ? MapBase::VoxelState::kFree
+                                          : MapBase::VoxelState::kOccupied;
+    }
+  }
+}
+
+voxblox::BlockIndexList CompactSubmapLayer::getBlockIndices() const {
+  voxblox::BlockIndexList block_indices;
+  block_indices.reserve(blocks_.size());
+  for (const auto& block_kv : blocks_) {
+    block_indices.emplace_back(block_kv.first);
+  }
+  return block_indices;
+}
+
+size_t CompactSubmapLayer::getMemoryUsage() const {
+  size_t num_bytes = sizeof(CompactSubmapLayer) +
+                     blocks_.bucket_count() * sizeof(void*) +
+                     blocks_.size() * sizeof(*blocks_.begin());
+  for (const auto& block_kv : blocks_) {
+    const Block& block = block_kv.second;
+    num_bytes += sizeof(uint64_t) * (block.esdf_observed.words.capacity() +
+                                     block.tsdf_observed.words.capacity() +
+                                     block.tsdf_free.words.capacity());
+    num_bytes += block.esdf_distances.values.capacity();
+  }
+  return num_bytes;
+}
+
+void CompactSubmapLayer::CompressedBits::compress(
+    const std::vector<bool>& values) {
+  CHECK(!values.empty());
+  uniform_value = values.front();
+  if (std::all_of(values.begin(), values.end(),
+                  [&](const bool value) { return value == uniform_value; })) {
+    words.clear();
+    return;
+  }
+  words.assign((values.size() + 63u) / 64u, 0u);
+  for (size_t linear_index = 0u; linear_index < values.size();
+       ++linear_index) {
+    if (values[linear_index]) {
+      words[linear_index / 64u] |= uint64_t{1u} << (linear_index % 64u);
+    }
+  }
+}
+
+void CompactSubmapLayer::CompressedDistances::compress(
+    const std::vector<int8_t>& quantized_distances) {
+  CHECK(!quantized_distances.empty());
+  uniform_value = quantized_distances.front();
+  if (std::all_of(quantized_distances.begin(), quantized_distances.end(),
+                  [&](const int8_t value) { return value == uniform_value; })) {
+    values.clear();
+    return;
+  }
+  values = quantized_distances;
+}
+
+const CompactSubmapLayer::Block* CompactSubmapLayer::getBlockAndLinearIndex(
+    const GlobalIndex& global_voxel_index, size_t* linear_index) const {
+  CHECK_NOTNULL(linear_index);
+  voxblox::BlockIndex block_index;
+  voxblox::VoxelIndex voxel_index;
+  voxblox::getBlockAndVoxelIndexFromGlobalVoxelIndex(
+      global_voxel_index, voxels_per_side_, &block_index, &voxel_index);
+  const auto block_it = blocks_.find(block_index);
+  if (block_it == blocks_.end()) {
+    return nullptr;
+  }
+  *linear_index =
+      voxel_index.x() +
+      voxels_per_side_ * (voxel_index.y() + voxel_index.z() * voxels_per_side_);
+  return &block_it->second;
+}
+
+bool CompactSubmapLayer::getObservedDistance(
+    const GlobalIndex& global_voxel_index, FloatingPoint* distance) const {
+  size_t linear_index;
+  const Block* block =
+      getBlockAndLinearIndex(global_voxel_index, &linear_index);
+  if (block && block->esdf_observed.get(linear_index)) {
+    *distance = dequantize(block->esdf_distances.get(linear_index));
+    return true;
+  }
+  return false;
+}
+
+int8_t CompactSubmapLayer::quantize(const FloatingPoint distance) const {
+  const FloatingPoint num_steps = std::round(distance / distance_step_);
+  return static_cast<int8_t>(std::max(-127.f, std::min(127.f, num_steps)));
+}
+
+}  // namespace glocal_exploration
@@ -0,0 +1,126 @@
+#include "glocal_exploration/mapping/esdf_interpolator.h"
+
+namespace glocal_exploration {
+
+EsdfInterpolator::EsdfInterpolator(const EsdfLayer& esdf_layer)
+    : esdf_layer_(esdf_layer),
+      voxel_size_(esdf_layer.voxel_size()),
+      voxel_size_inv_(esdf_layer.voxel_size_inv()),
+      voxels_per_side_(esdf_layer.voxels_per_side()) {}
+
+bool EsdfInterpolator::isObserved(const Point& position) const {
+  const voxblox::EsdfVoxel* voxel =
+      esdf_layer_.getVoxelPtrByCoordinates(position);
+  return voxel && voxel->observed;
+}
+
+bool EsdfInterpolator::getDistance(const Point& position,
+                                   FloatingPoint* distance) const {
+  CHECK_NOTNULL(distance);
+  trilinear::CornerValues corner_distances;
+  Point q;
+  if (!getCornerDistances(position, &corner_distances, &q)) {
+    return false;
+  }
+  *distance = trilinear::getWeights(q).dot(corner_distances);
+  return true;
+}
+
+bool EsdfInterpolator::getDistanceAndGradient(const Point& position,
+                                              FloatingPoint* distance,
+                                              Point* gradient) const {
+  CHECK_NOTNULL(distance);
+  CHECK_NOTNULL(gradient);
+  trilinear::CornerValues corner_distances;
+  Point q;
+  if (getCornerDistances(position, &corner_distances, &q)) {
+    *distance = trilinear::getWeights(q).dot(corner_distances);
+    *gradient = trilinear::getGradient(corner_distances, q) * voxel_size_inv_;
+    return true;
+  }
+
+  // Fall back to the nearest voxel and central differences between its
+  // observed neighbors, or one-sided differences if only one is observed.
+  const voxblox::GlobalIndex nearest_index =
+      voxblox::getGridIndexFromPoint<voxblox::GlobalIndex>(position,
+                                                           voxel_size_inv_);
+  if (!getObservedDistance(nearest_index, distance)) {
+    return false;
+  }
+  for (int axis = 0; axis < 3; ++axis) {
+    voxblox::GlobalIndex offset = voxblox::GlobalIndex::Zero();
+    offset[axis] = 1;
+    FloatingPoint next_distance, previous_distance;
+    const bool has_next =
+        getObservedDistance(nearest_index + offset, &next_distance);
+    const bool has_previous =
+        getObservedDistance(nearest_index - offset, &previous_distance);
+    if (has_next && has_previous) {
+      (*gradient)[axis] =
+          (next_distance - previous_distance) * 0.5f * voxel_size_inv_;
+    } else if (has_next) {
+      (*gradient)[axis] = (next_distance - *distance) * voxel_size_inv_;
+    } else if (has_previous) {
+      (*gradient)[axis] = (*distance - previous_distance) * voxel_size_inv_;
+    } else {
+      (*gradient)[axis] = 0.f;
+    }
+  }
+  return true;
+}
+
+bool EsdfInterpolator::getCornerDistances(
+    const Point& position, trilinear::CornerValues* corner_distances,
+    Point* q) const {
+  const voxblox::GlobalIndex base_index =
+      voxblox::getGridIndexFromPoint<voxblox::GlobalIndex>(
+          position - Point::Constant(0.5f * voxel_size_), voxel_size_inv_);
+  *q = position * voxel_size_inv_ - Point::Constant(0.5f) -
+       base_index.cast<FloatingPoint>();
+
+  voxblox::BlockIndex block_index;
+  voxblox::VoxelIndex voxel_index;
+  voxblox::getBlockAndVoxelIndexFromGlobalVoxelIndex(
+      base_index, voxels_per_side_, &block_index, &voxel_index);
+  if ((voxel_index.array() < voxels_per_side_ - 1).all()) {
+    // All corners lie in the same block, so it only needs to be looked up once
+    const auto block_ptr = esdf_layer_.getBlockPtrByIndex(block_index);
+    if (!block_ptr) {
+      return false;
+    }
+    for (int corner = 0; corner < 8; ++corner) {
+      const voxblox::EsdfVoxel& voxel = block_ptr->getVoxelByVoxelIndex(
+          voxel_index + voxblox::VoxelIndex(corner & 1, (corner >> 1) & 1,
+                                            (corner >> 2) & 1));
+      if (!voxel.observed) {
+        return false;
+      }
+      (*corner_distances)[corner] = voxel.distance;
+    }
+    return true;
+  }
+
+  for (int corner = 0; corner < 8; ++corner) {
+    const voxblox::GlobalIndex offset(corner & 1, (corner >> 1) & 1,
+                                      (corner >> 2) & 1);
+    if (!getObservedDistance(base_index + offset,
+                             &(*corner_distances)[corner])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EsdfInterpolator::getObservedDistance(
+    const voxblox::GlobalIndex& global_voxel_index,
+    FloatingPoint* distance) const {
+  const voxblox::EsdfVoxel* voxel =
+      esdf_layer_.getVoxelPtrByGlobalIndex(global_voxel_index);
+  if (voxel && voxel->observed) {
+    *distance = voxel->distance;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace glocal_exploration
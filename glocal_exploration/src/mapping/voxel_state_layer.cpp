@@ -0,0 +1,98 @@
+#include "glocal_exploration/mapping/voxel_state_layer.h"
+
+#include <memory>
+#include <utility>
+
+namespace glocal_exploration {
+
+VoxelStateLayer::VoxelStateLayer(const FloatingPoint voxel_size,
+                                 const size_t voxels_per_side)
+    : voxel_size_(voxel_size),
+      voxel_size_inv_(1.f / voxel_size),
+      voxels_per_side_(voxels_per_side) {}
+
+VoxelStateLayer::PackedBlockConstPtr VoxelStateLayer::packBlock(
+    const voxblox::Block<voxblox::EsdfVoxel>& esdf_block,
+    const FloatingPoint free_threshold) {
+  auto packed_block = std::make_shared<PackedBlock>(esdf_block.num_voxels());
+  for (size_t linear_index = 0u; linear_index < esdf_block.num_voxels();
+       ++linear_index) {
+    const voxblox::EsdfVoxel& voxel =
+        esdf_block.getVoxelByLinearIndex(linear_index);
+    if (voxel.observed) {
+      packed_block->set(linear_index, voxel.distance > free_threshold
+                                          ? VoxelState::kFree
+                                          : VoxelState::kOccupied);
+    }
+  }
+  return packed_block;
+}
+
+VoxelStateLayer::PackedBlockConstPtr VoxelStateLayer::packBlock(
+    const voxblox::Block<voxblox::TsdfVoxel>& tsdf_block,
+    const FloatingPoint free_threshold, const FloatingPoint min_weight) {
+  auto packed_block = std::make_shared<PackedBlock>(tsdf_block.num_voxels());
+  for (size_t linear_index = 0u; linear_index < tsdf_block.num_voxels();
+       ++linear_index) {
+    const voxblox::TsdfVoxel& voxel =
+        tsdf_block.getVoxelByLinearIndex(linear_index);
+    if (voxel.weight > min_weight) {
+      packed_block->set(linear_index, voxel.distance > free_threshold
+                                          ? VoxelState::kFree
+                                          : VoxelState::kOccupied);
+    }
+  }
+  return packed_block;
+}
+
+void VoxelStateLayer::update(
+    const voxblox::Layer<voxblox::EsdfVoxel>& esdf_layer,
+    const voxblox::BlockIndexList& updated_blocks) {
+  CHECK_EQ(esdf_layer.voxels_per_side(), voxels_per_side_);
+  // Drop the blocks that were released, e.g. when the map was reset
+  for (auto it = blocks_.begin(); it != blocks_.end();) {
+    if (esdf_layer.hasBlock(it->first)) {
+      ++it;
+    } else {
+      it = blocks_.erase(it);
+    }
+  }
+  for (const BlockIndex& block_index : updated_blocks) {
+    const auto block_ptr = esdf_layer.getBlockPtrByIndex(block_index);
+    if (block_ptr) {
+      setBlock(block_index, packBlock(*block_ptr, voxel_size_));
+    } else {
+      removeBlock(block_index);
+    }
+  }
+}
+
+VoxelStateLayer::VoxelState VoxelStateLayer::getVoxelState(
+    const Point& position) const {
+  BlockIndex block_index;
+  voxblox::VoxelIndex voxel_index;
+  voxblox::getBlockAndVoxelIndexFromGlobalVoxelIndex(
+      voxblox::getGridIndexFromPoint<voxblox::GlobalIndex>(position,
+                                                           voxel_size_inv_),
+      voxels_per_side_, &block_index, &voxel_index);
+  const auto block_it = blocks_.find(block_index);
+  if (block_it == blocks_.end()) {
+    return VoxelState::kUnknown;
+  }
+  const size_t linear_index =
+      voxel_index.x() +
+      voxels_per_side_ * (voxel_index.y() + voxel_index.z() * voxels_per_side_);
+  return block_it->second->get(linear_index);
+}
+
+size_t VoxelStateLayer::getMemoryUsage() const {
+  size_t num_bytes = sizeof(VoxelStateLayer) +
+                     blocks_.bucket_count() * sizeof(void*) +
+                     blocks_.size() * sizeof(*blocks_.begin());
+  for (const auto& block_kv : blocks_) {
+    num_bytes += block_kv.second->getMemoryUsage();
+  }
+  return num_bytes;
+}
+
+}  // namespace glocal_exploration
@@ -0,0 +1,273 @@
+#include "glocal_exploration/planning/global/block_frontier_extractor.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "glocal_exploration/utils/morton_order.h"
+
+namespace glocal_exploration {
+
+BlockFrontierExtractor::BlockFrontierExtractor(const size_t voxels_per_side)
+    : voxels_per_side_(voxels_per_side),
+      padded_side_(voxels_per_side + 2u),
+      row_mask_((uint64_t{1u} << voxels_per_side) - 1u) {
+  CHECK_GT(voxels_per_side_, 0u);
+  CHECK_LE(voxels_per_side_, kMaxVoxelsPerSide);
+}
+
+void BlockFrontierExtractor::addBlock(
+    const BlockIndex& block_index,
+    const std::vector<MapBase::VoxelState>& voxel_states) {
+  const size_t n = voxels_per_side_;
+  CHECK_EQ(voxel_states.size(), n * n * n);
+  BlockMasks& masks = blocks_[block_index];
+  masks.free.assign(n * n, 0u);
+  masks.observed.assign(n * n, 0u);
+  // NOTE: Voxblox's linear index is x + n * (y + z * n), so each row of
+  //       voxels along x is contiguous.
+  for (size_t row = 0u; row < n * n; ++row) {
+    for (size_t x = 0u; x < n; ++x) {
+      const MapBase::VoxelState state = voxel_states[x + row * n];
+      const uint64_t bit = uint64_t{1u} << x;
+      if (state != MapBase::VoxelState::kUnknown) {
+        masks.observed[row] |= bit;
+      }
+      if (state == MapBase::VoxelState::kFree) {
+        masks.free[row] |= bit;
+      }
+    }
+  }
+}
+
+std::vector<BlockFrontierExtractor::GlobalIndex>
+BlockFrontierExtractor::extractFrontiers(const GlobalIndex* seed_voxel_index) {
+  if (seed_voxel_index) {
+    floodFillFrom(*seed_voxel_index);
+  } else {
+    for (auto& block_kv : blocks_) {
+      block_kv.second.reached = block_kv.second.free;
+    }
+  }
+
+  // Frontiers can only lie in the blocks that contain reached free space and
+  // in their neighbors, which may also be unallocated.
+  voxblox::IndexSet target_blocks;
+  for (const auto& block_kv : blocks_) {
+    const Mask& reached = block_kv.second.reached;
+    if (std::any_of(reached.begin(), reached.end(),
+                    [](const uint64_t row) { return row != 0u; })) {
+      for (int i = 0; i < 27; ++i) {
+        target_blocks.insert(block_kv.first +
+                             BlockIndex(i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1));
+      }
+    }
+  }
+
+  // Frontiers are the unknown voxels within one voxel of reached free space.
+  std::vector<GlobalIndex> frontiers;
+  for (const BlockIndex& block_index :
+       morton_order::getSortedBlockIndices(target_blocks)) {
+    appendFrontiersInBlock(block_index, &BlockMasks::reached, &frontiers);
+  }
+
+  // NOTE: The seed is reached even if it is unknown, but as for the flood fill
+  //       it is only a frontier if reached free space is adjacent to it.
+  if (seed_voxel_index && !hasReachedNeighbor(*seed_voxel_index)) {
+    frontiers.erase(
+        std::remove(frontiers.begin(), frontiers.end(), *seed_voxel_index),
+        frontiers.end());
+  }
+  return frontiers;
+}
+
+void BlockFrontierExtractor::extractFrontiersInBlock(
+    const BlockIndex& block_index, std::vector<GlobalIndex>* frontiers) {
+  CHECK_NOTNULL(frontiers);
+  appendFrontiersInBlock(block_index, &BlockMasks::free, frontiers);
+}
+
+void BlockFrontierExtractor::appendFrontiersInBlock(
+    const BlockIndex& block_index, Mask BlockMasks::*reached,
+    std::vector<GlobalIndex>* frontiers) {
+  const size_t n = voxels_per_side_;
+  gatherPadded(block_index, reached);
+  dilateAndCrop(&cropped_);
+  const auto block_it = blocks_.find(block_index);
+  for (size_t row = 0u; row < n * n; ++row) {
+    uint64_t frontier_row = cropped_[row];
+    if (block_it != blocks_.end()) {
+      frontier_row &= ~block_it->second.observed[row];
+    }
+    while (frontier_row) {
+      const int x = __builtin_ctzll(frontier_row);
+      frontier_row &= frontier_row - 1u;
+      frontiers->emplace_back(
+          voxblox::getGlobalVoxelIndexFromBlockAndVoxelIndex(
+              block_index, voxblox::VoxelIndex(x, row % n, row / n), n));
+    }
+  }
+}
+
+void BlockFrontierExtractor::floodFillFrom(
+    const GlobalIndex& seed_voxel_index) {
+  const size_t n = voxels_per_side_;
+  for (auto& block_kv : blocks_) {
+    block_kv.second.reached.assign(n * n, 0u);
+  }
+  BlockIndex seed_block_index;
+  voxblox::VoxelIndex seed_voxel;
+  voxblox::getBlockAndVoxelIndexFromGlobalVoxelIndex(
+      seed_voxel_index, n, &seed_block_index, &seed_voxel);
+  // NOTE: As for the flood fill, the search starts from the seed even if it
+  //       is not observed free. An unallocated seed block is added as unknown.
+  BlockMasks& seed_masks = blocks_[seed_block_index];
+  if (seed_masks.reached.empty()) {
+    seed_masks.free.assign(n * n, 0u);
+    seed_masks.observed.assign(n * n, 0u);
+    seed_masks.reached.assign(n * n, 0u);
+  }
+  seed_masks.reached[seed_voxel.y() + seed_voxel.z() * n] =
+      uint64_t{1u} << seed_voxel.x();
+
+  // Grow the reached free space block by block until it no longer changes.
+  std::vector<BlockIndex> open_blocks;
+  voxblox::IndexSet open_block_set;
+  const auto open_neighbors = [&](const BlockIndex& block_index) {
+    for (int i = 0; i < 27; ++i) {
+      const BlockIndex neighbor_index =
+          block_index + BlockIndex(i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1);
+      if (blocks_.count(neighbor_index) &&
+          open_block_set.insert(neighbor_index).second) {
+        open_blocks.emplace_back(neighbor_index);
+      }
+    }
+  };
+  open_neighbors(seed_block_index);
+
+  const size_t padded_side = padded_side_;
+  Mask dilated;
+  while (!open_blocks.empty()) {
+    const BlockIndex block_index = open_blocks.back();
+    open_blocks.pop_back();
+    open_block_set.erase(block_index);
+    BlockMasks& masks = blocks_.at(block_index);
+
+    // Iterate within the block, since the neighbors' voxels stay the same.
+    gatherPadded(block_index, &BlockMasks::reached);
+    bool changed = false;
+    while (true) {
+      dilateAndCrop(&dilated);
+      bool grew = false;
+      for (size_t row = 0u; row < n * n; ++row) {
+        const uint64_t reached_row =
+            masks.reached[row] | (dilated[row] & masks.free[row]);
+        if (reached_row != masks.reached[row]) {
+          masks.reached[row] = reached_row;
+          uint64_t& padded_row =
+              padded_[(row % n + 1u) + (row / n + 1u) * padded_side];
+          padded_row |= reached_row << 1;
+          grew = true;
+        }
+      }
+      if (!grew) {
+        break;
+      }
+      changed = true;
+    }
+    if (changed) {
+      open_neighbors(block_index);
+    }
+  }
+}
+
+bool BlockFrontierExtractor::isReached(const GlobalIndex& voxel_index) const {
+  const size_t n = voxels_per_side_;
+  BlockIndex block_index;
+  voxblox::VoxelIndex voxel;
+  voxblox::getBlockAndVoxelIndexFromGlobalVoxelIndex(voxel_index, n,
+                                                     &block_index, &voxel);
+  const auto block_it = blocks_.find(block_index);
+  if (block_it == blocks_.end() || block_it->second.reached.empty()) {
+    return false;
+  }
+  return (block_it->second.reached[voxel.y() + voxel.z() * n] >> voxel.x()) &
+         1u;
+}
+
+bool BlockFrontierExtractor::hasReachedNeighbor(
+    const GlobalIndex& voxel_index) const {
+  for (int i = 0; i < 27; ++i) {
+    if (i != 13 &&
+        isReached(voxel_index +
+                  GlobalIndex(i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void BlockFrontierExtractor::gatherPadded(const BlockIndex& block_index,
+                                          Mask BlockMasks::*mask) {
+  const int n = static_cast<int>(voxels_per_side_);
+  const int padded_side = static_cast<int>(padded_side_);
+  const BlockMasks* neighbors[27];
+  for (int i = 0; i < 27; ++i) {
+    const auto it = blocks_.find(
+        block_index + BlockIndex(i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1));
+    neighbors[i] = it != blocks_.end() ? &it->second : nullptr;
+  }
+
+  padded_.assign(padded_side * padded_side, 0u);
+  for (int pz = 0; pz < padded_side; ++pz) {
+    const int oz = pz == 0 ? -1 : (pz == padded_side - 1 ? 1 : 0);
+    const int z = pz - 1 - oz * n;
+    for (int py = 0; py < padded_side; ++py) {
+      const int oy = py == 0 ? -1 : (py == padded_side - 1 ? 1 : 0);
+      const int y = py - 1 - oy * n;
+      const int row = y + z * n;
+      const int neighbor_offset = 3 * (oy + 1) + 9 * (oz + 1);
+      uint64_t padded_row = 0u;
+      if (const BlockMasks* left = neighbors[neighbor_offset]) {
+        padded_row |= ((left->*mask)[row] >> (n - 1)) & 1u;
+      }
+      if (const BlockMasks* center = neighbors[neighbor_offset + 1]) {
+        padded_row |= (center->*mask)[row] << 1;
+      }
+      if (const BlockMasks* right = neighbors[neighbor_offset + 2]) {
+        padded_row |= ((right->*mask)[row] & 1u) << (n + 1);
+      }
+      padded_[py + pz * padded_side] = padded_row;
+    }
+  }
+}
+
+void BlockFrontierExtractor::dilateAndCrop(Mask* output) {
+  CHECK_NOTNULL(output);
+  // The 26-neighborhood is a 3x3x3 box, so the dilation is separable.
+  const size_t n = voxels_per_side_;
+  const size_t padded_side = padded_side_;
+  x_dilated_.resize(padded_.size());
+  y_dilated_.resize(padded_.size());
+  for (size_t i = 0u; i < padded_.size(); ++i) {
+    const uint64_t row = padded_[i];
+    x_dilated_[i] = row | (row << 1) | (row >> 1);
+  }
+  for (size_t pz = 0u; pz < padded_side; ++pz) {
+    for (size_t py = 1u; py <= n; ++py) {
+      const size_t i = py + pz * padded_side;
+      y_dilated_[i] = x_dilated_[i - 1u] | x_dilated_[i] | x_dilated_[i + 1u];
+    }
+  }
+  output->resize(n * n);
+  for (size_t z = 0u; z < n; ++z) {
+    for (size_t y = 0u; y < n; ++y) {
+      const size_t i = (y + 1u) + (z + 1u) * padded_side;
+      (*output)[y + z * n] = ((y_dilated_[i - padded_side] | y_dilated_[i] |
+                               y_dilated_[i + padded_side]) >>
+                              1) &
+                             row_mask_;
+    }
+  }
+}
+
+}  // namespace glocal_exploration
@@ -0,0 +1,122 @@
+#include "glocal_exploration/planning/global/frontier_clusterer.h"
+
+#include <utility>
+#include <vector>
+
+namespace glocal_exploration {
+
+int FrontierClusterer::cluster(const std::vector<GlobalIndex>& voxels,
+                               std::vector<int>* labels) {
+  CHECK_NOTNULL(labels);
+  const int num_voxels = static_cast<int>(voxels.size());
+  parents_.resize(num_voxels);
+  sizes_.assign(num_voxels, 1);
+  for (int i = 0; i < num_voxels; ++i) {
+    parents_[i] = i;
+  }
+
+  // Scatter the voxels into their blocks.
+  // NOTE: Arithmetic shifts round towards negative infinity, as required.
+  blocks_.clear();
+  block_ids_.clear();
+  for (int i = 0; i < num_voxels; ++i) {
+    const GlobalIndex& voxel = voxels[i];
+    const voxblox::BlockIndex block_index(
+        static_cast<int>(voxel.x() >> kBlockSideBits),
+        static_cast<int>(voxel.y() >> kBlockSideBits),
+        static_cast<int>(voxel.z() >> kBlockSideBits));
+    auto block_it = block_ids_.find(block_index);
+    if (block_it == block_ids_.end()) {
+      block_it = block_ids_.emplace(block_index, blocks_.size()).first;
+      Block& new_block = blocks_.emplace_back();
+      new_block.index = block_index;
+      new_block.voxels.fill(-1);
+    }
+    constexpr int kMask = kBlockSide - 1;
+    int& slot = blocks_[block_it->second].voxels[voxelLinearIndex(
+        voxel.x() & kMask, voxel.y() & kMask, voxel.z() & kMask)];
+    if (slot < 0) {
+      slot = i;
+    } else {
+      // Duplicates belong to the same cluster.
+      unite(slot, i);
+    }
+  }
+
+  // Join each voxel with its neighbors. Visiting half of the 26-neighborhood
+  // suffices, since the other half visits the voxel in turn.
+  for (const Block& block : blocks_) {
+    const Block* neighbor_blocks[27];
+    for (int i = 0; i < 27; ++i) {
+      const auto it = block_ids_.find(
+          block.index +
+          voxblox::BlockIndex(i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1));
+      neighbor_blocks[i] = it != block_ids_.end() ? &blocks_[it->second]
+                                                  : nullptr;
+    }
+    for (int z = 0; z < kBlockSide; ++z) {
+      for (int y = 0; y < kBlockSide; ++y) {
+        for (int x = 0; x < kBlockSide; ++x) {
+          const int voxel = block.voxels[voxelLinearIndex(x, y, z)];
+          if (voxel < 0) {
+            continue;
+          }
+          for (int offset = 14; offset < 27; ++offset) {
+            const int nx = x + offset % 3 - 1;
+            const int ny = y + offset / 3 % 3 - 1;
+            const int nz = z + offset / 9 - 1;
+            const int bx = nx < 0 ? 0 : (nx < kBlockSide ? 1 : 2);
+            const int by = ny < 0 ? 0 : (ny < kBlockSide ? 1 : 2);
+            const int bz = nz < 0 ? 0 : (nz < kBlockSide ? 1 : 2);
+            const Block* neighbor_block = neighbor_blocks[bx + 3 * by + 9 * bz];
+            if (!neighbor_block) {
+              continue;
+            }
+            const int neighbor = neighbor_block->voxels[voxelLinearIndex(
+                nx - (bx - 1) * kBlockSide, ny - (by - 1) * kBlockSide,
+                nz - (bz - 1) * kBlockSide)];
+            if (0 <= neighbor) {
+              unite(voxel, neighbor);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Assign consecutive labels to the roots.
+  labels->assign(num_voxels, -1);
+  int num_clusters = 0;
+  for (int i = 0; i < num_voxels; ++i) {
+    const int root = findRoot(i);
+    if ((*labels)[root] < 0) {
+      (*labels)[root] = num_clusters++;
+    }
+    (*labels)[i] = (*labels)[root];
+  }
+  return num_clusters;
+}
+
+int FrontierClusterer::findRoot(int voxel) {
+  // Path halving.
+  while (parents_[voxel] != voxel) {
+    parents_[voxel] = parents_[parents_[voxel]];
+    voxel = parents_[voxel];
+  }
+  return voxel;
+}
+
+void FrontierClusterer::unite(const int voxel_a, const int voxel_b) {
+  int root_a = findRoot(voxel_a);
+  int root_b = findRoot(voxel_b);
+  if (root_a == root_b) {
+    return;
+  }
+  if (sizes_[root_a] < sizes_[root_b]) {
+    std::swap(root_a, root_b);
+  }
+  parents_[root_b] = root_a;
+  sizes_[root_a] += sizes_[root_b];
+}
+
+}  // namespace glocal_exploration
@@ -0,0 +1,124 @@
+#include "glocal_exploration/planning/global/frontier_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace glocal_exploration {
+
+void FrontierIndex::build(
+    std::vector<Point> centroids,
+    const std::vector<FrontierVoxelList::PointSpan>& frontiers) {
+  CHECK(frontiers.empty() || frontiers.size() == centroids.size())
+      << "The frontier points need to match their centroids.";
+  clear();
+  centroids_.points = std::move(centroids);
+  centroid_kdtree_ = std::make_unique<KDTree>(
+      3, centroids_, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+  centroid_kdtree_->buildIndex();
+
+  size_t num_points = 0u;
+  for (const FrontierVoxelList::PointSpan& frontier : frontiers) {
+    num_points += frontier.size();
+  }
+  points_.points.reserve(num_points);
+  point_frontier_ids_.reserve(num_points);
+  for (size_t frontier_id = 0u; frontier_id < frontiers.size();
+       ++frontier_id) {
+    for (const Point& point : frontiers[frontier_id]) {
+      points_.points.emplace_back(point);
+      point_frontier_ids_.emplace_back(frontier_id);
+    }
+  }
+  point_kdtree_ = std::make_unique<KDTree>(
+      3, points_, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+  point_kdtree_->buildIndex();
+}
+
+void FrontierIndex::clear() {
+  // NOTE: The trees refer to the data, so they are reset first.
+  centroid_kdtree_.reset();
+  point_kdtree_.reset();
+  centroids_.points.clear();
+  points_.points.clear();
+  point_frontier_ids_.clear();
+}
+
+std::vector<FrontierIndex::FrontierDistance> FrontierIndex::getNearestFrontiers(
+    const Point& position, const size_t k) const {
+  std::vector<FrontierDistance> result;
+  const size_t num_closest = std::min(k, size());
+  if (num_closest == 0u) {
+    return result;
+  }
+  std::vector<size_t> indices(num_closest);
+  std::vector<FloatingPoint> squared_distances(num_closest);
+  const size_t num_found = centroid_kdtree_->knnSearch(
+      position.data(), num_closest, indices.data(), squared_distances.data());
+  result.reserve(num_found);
+  for (size_t i = 0u; i < num_found; ++i) {
+    result.emplace_back(indices[i], std::sqrt(squared_distances[i]));
+  }
+  return result;
+}
+
+std::vector<FrontierIndex::FrontierDistance>
+FrontierIndex::getFrontiersWithinRadius(const Point& position,
+                                        const FloatingPoint radius) const {
+  std::vector<FrontierDistance> result;
+  if (empty()) {
+    return result;
+  }
+  radiusSearch(*centroid_kdtree_, position, radius, true, &result);
+  for (FrontierDistance& frontier_distance : result) {
+    frontier_distance.second = std::sqrt(frontier_distance.second);
+  }
+  return result;
+}
+
+std::vector<size_t> FrontierIndex::getFrontiersWithPointsWithinRadius(
+    const Point& position, const FloatingPoint radius) const {
+  std::vector<size_t> result;
+  if (points_.points.empty()) {
+    return result;
+  }
+  RadiusResult points;
+  radiusSearch(*point_kdtree_, position, radius, false, &points);
+  result.reserve(points.size());
+  for (const auto& point : points) {
+    result.emplace_back(point_frontier_ids_[point.first]);
+  }
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+std::vector<Point> FrontierIndex::getFrontierPointsWithinRadius(
+    const Point& position, const FloatingPoint radius,
+    const size_t frontier_id) const {
+  std::vector<Point> result;
+  if (points_.points.empty()) {
+    return result;
+  }
+  RadiusResult points;
+  radiusSearch(*point_kdtree_, position, radius, false, &points);
+  for (const auto& point : points) {
+    if (point_frontier_ids_[point.first] == frontier_id) {
+      result.emplace_back(points_.points[point.first]);
+    }
+  }
+  return result;
+}
+
+void FrontierIndex::radiusSearch(const KDTree& kdtree, const Point& position,
+                                 const FloatingPoint radius, const bool sorted,
+                                 RadiusResult* result) {
+  CHECK_NOTNULL(result);
+  // NOTE: The L2 metrics of nanoflann work on squared distances.
+  nanoflann::SearchParams params;
+  params.sorted = sorted;
+  kdtree.radiusSearch(position.data(), radius * radius, *result, params);
+}
+
+}  // namespace glocal_exploration
@@ -0,0 +1,106 @@
+#include "glocal_exploration/planning/global/incremental_frontier_tracker.h"
+
+#include <utility>
+#include <vector>
+
+#include "glocal_exploration/planning/global/submap_frontier_evaluator.h"
+#include "glocal_exploration/utils/morton_order.h"
+
+namespace glocal_exploration {
+
+IncrementalFrontierTracker::IncrementalFrontierTracker(
+    const FloatingPoint voxel_size, const size_t voxels_per_side)
+    : voxel_size_(voxel_size),
+      voxels_per_side_(voxels_per_side),
+      extractor_(voxels_per_side) {}
+
+void IncrementalFrontierTracker::update(
+    const voxblox::Layer<voxblox::TsdfVoxel>& tsdf_layer,
+    const voxblox::BlockIndexList& updated_blocks,
+    const voxblox::BlockIndexList& removed_blocks) {
+  // Reclassify the changed blocks.
+  // NOTE: The voxels are classified as for the frontier extraction on the
+  //       finished submaps, s.t. both yield the same candidates.
+  voxblox::IndexSet affected_blocks;
+  const auto add_neighborhood = [&affected_blocks](const BlockIndex& index) {
+    for (int i = 0; i < 27; ++i) {
+      affected_blocks.insert(index +
+                             BlockIndex(i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1));
+    }
+  };
+  std::vector<MapBase::VoxelState> voxel_states;
+  for (const BlockIndex& block_index : updated_blocks) {
+    const auto block_ptr = tsdf_layer.getBlockPtrByIndex(block_index);
+    if (block_ptr) {
+      voxel_states.resize(block_ptr->num_voxels());
+      for (size_t linear_index = 0u; linear_index < block_ptr->num_voxels();
+           ++linear_index) {
+        voxel_states[linear_index] = SubmapFrontierEvaluator::tsdfVoxelState(
+            block_ptr->getVoxelByLinearIndex(linear_index), voxel_size_);
+      }
+      extractor_.addBlock(block_index, voxel_states);
+    } else {
+      extractor_.removeBlock(block_index);
+    }
+    add_neighborhood(block_index);
+  }
+  for (const BlockIndex& block_index : removed_blocks) {
+    extractor_.removeBlock(block_index);
+    add_neighborhood(block_index);
+  }
+
+  // A block's frontiers only depend on the block and its direct neighbors.
+  std::vector<GlobalIndex> frontiers;
+  for (const BlockIndex& block_index : affected_blocks) {
+    frontiers.clear();
+    extractor_.extractFrontiersInBlock(block_index, &frontiers);
+    auto it = block_frontiers_.find(block_index);
+    if (it != block_frontiers_.end()) {
+      num_frontiers_ -= it->second.size();
+      if (frontiers.empty()) {
+        block_frontiers_.erase(it);
+        continue;
+      }
+    } else if (frontiers.empty()) {
+      continue;
+    } else {
+      it = block_frontiers_.emplace(block_index, std::vector<GlobalIndex>())
+               .first;
+    }
+    num_frontiers_ += frontiers.size();
+    it->second.swap(frontiers);
+  }
+}
+
+FrontierVoxelList IncrementalFrontierTracker::getFrontiers() const {
+  voxblox::IndexSet block_indices;
+  BlockIndex min_block_index = BlockIndex::Zero();
+  BlockIndex max_block_index = BlockIndex::Zero();
+  for (const auto& block_kv : block_frontiers_) {
+    if (block_indices.empty()) {
+      min_block_index = block_kv.first;
+      max_block_index = block_kv.first;
+    }
+    block_indices.insert(block_kv.first);
+    min_block_index = min_block_index.cwiseMin(block_kv.first);
+    max_block_index = max_block_index.cwiseMax(block_kv.first);
+  }
+  // NOTE: The map's voxel indices are global, so the list is centered on the
+  //       frontiers to keep them within its compact coordinate range.
+  const BlockIndex center_block_index = (min_block_index + max_block_index) / 2;
+  FrontierVoxelList frontiers(
+      voxel_size_, voxblox::getGlobalVoxelIndexFromBlockAndVoxelIndex(
+                       center_block_index, voxblox::VoxelIndex::Zero(),
+                       voxels_per_side_));
+  frontiers.reserve(num_frontiers_);
+  // NOTE: Sorting the blocks keeps nearby frontiers close in the list.
+  for (const BlockIndex& block_index :
+       morton_order::getSortedBlockIndices(block_indices)) {
+    for (const GlobalIndex& index : block_frontiers_.at(block_index)) {
+      frontiers.push_back(index);
+    }
+  }
+  return frontiers;
+}
+
+}  // namespace glocal_exploration
@@ -0,0 +1,120 @@
+#include "glocal_exploration/planning/global/skeleton/global_vertex_registry.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace glocal_exploration {
+
+void GlobalVertexRegistry::addSubmap(SkeletonSubmap::ConstPtr submap_ptr) {
+  CHECK_NOTNULL(submap_ptr);
+  const SubmapId submap_id = submap_ptr->getId();
+  CHECK(!hasSubmap(submap_id))
+      << "Skeleton submap with ID " << submap_id << " was already added.";
+  if (submap_vertices_.size() <= submap_id) {
+    submap_vertices_.resize(submap_id + 1u);
+  }
+
+  // The graph's vertex IDs are assigned incrementally, so the submap gets one
+  // index per ID up to the largest one.
+  VertexIdElement max_vertex_id = -1;
+  for (const auto& vertex_kv : submap_ptr->getSkeletonGraph().getVertexMap()) {
+    max_vertex_id = std::max(max_vertex_id, vertex_kv.second.vertex_id);
+  }
+  auto vertices = std::make_shared<SubmapVertices>();
+  vertices->submap_ptr = submap_ptr;
+  vertices->offset = num_indices_;
+  const size_t num_indices = static_cast<size_t>(max_vertex_id + 1);
+  vertices->vertex_ids.resize(num_indices);
+  vertices->positions.resize(num_indices, Point::Zero());
+  for (const auto& vertex_kv : submap_ptr->getSkeletonGraph().getVertexMap()) {
+    const VertexIdElement vertex_id = vertex_kv.second.vertex_id;
+    vertices->vertex_ids[vertex_id] = GlobalVertexId{submap_id, vertex_id};
+  }
+  updatePositions(vertices.get());
+  submap_vertices_[submap_id] = std::move(vertices);
+  submap_offsets_.push_back(SubmapOffset{num_indices_, submap_id});
+  num_indices_ += num_indices;
+  submaps_.emplace_back(std::move(submap_ptr));
+}
+
+bool GlobalVertexRegistry::updatePoses() {
+  // NOTE: The blocks are shared with other versions of the registry, so the
+  //       blocks of the submaps that moved are replaced by updated copies.
+  bool pose_changed = false;
+  for (std::shared_ptr<const SubmapVertices>& vertices : submap_vertices_) {
+    if (vertices && poseChanged(*vertices)) {
+      auto updated_vertices = std::make_shared<SubmapVertices>(*vertices);
+      updatePositions(updated_vertices.get());
+      vertices = std::move(updated_vertices);
+      pose_changed = true;
+    }
+  }
+  return pose_changed;
+}
+
+bool GlobalVertexRegistry::hasOutdatedPoses() const {
+  return std::any_of(
+      submap_vertices_.begin(), submap_vertices_.end(),
+      [](const std::shared_ptr<const SubmapVertices>& vertices) {
+        return vertices && poseChanged(*vertices);
+      });
+}
+
+size_t GlobalVertexRegistry::getIndex(const GlobalVertexId& vertex_id) const {
+  if (!hasSubmap(vertex_id.submap_id) || vertex_id.vertex_id < 0) {
+    return kInvalidIndex;
+  }
+  const SubmapVertices& vertices = *submap_vertices_[vertex_id.submap_id];
+  const size_t local_index = static_cast<size_t>(vertex_id.vertex_id);
+  if (vertices.vertex_ids.size() <= local_index ||
+      !(vertices.vertex_ids[local_index] == vertex_id)) {
+    return kInvalidIndex;
+  }
+  return vertices.offset + local_index;
+}
+
+const SkeletonSubmap::ConstPtr& GlobalVertexRegistry::getSubmap(
+    const SubmapId submap_id) const {
+  static const SkeletonSubmap::ConstPtr kNoSubmap;
+  return hasSubmap(submap_id) ? submap_vertices_[submap_id]->submap_ptr
+                              : kNoSubmap;
+}
+
+const Transformation& GlobalVertexRegistry::getSubmapPose(
+    const SubmapId submap_id) const {
+  static const Transformation kIdentity;
+  return hasSubmap(submap_id) ? submap_vertices_[submap_id]->T_M_S
+                              : kIdentity;
+}
+
+const GlobalVertexRegistry::SubmapVertices&
+GlobalVertexRegistry::getSubmapVerticesByIndex(const size_t index) const {
+  // NOTE: Submaps without vertices share their offset with the next submap,
+  //       so the last submap whose offset is not past the index is taken.
+  const auto next_it = std::upper_bound(
+      submap_offsets_.begin(), submap_offsets_.end(), index,
+      [](const size_t value, const SubmapOffset& submap_offset) {
+        return value < submap_offset.offset;
+      });
+  DCHECK(next_it != submap_offsets_.begin());
+  return *submap_vertices_[std::prev(next_it)->submap_id];
+}
+
+bool GlobalVertexRegistry::poseChanged(const SubmapVertices& vertices) {
+  return vertices.submap_ptr->getPose().getTransformationMatrix() !=
+         vertices.T_M_S.getTransformationMatrix();
+}
+
+void GlobalVertexRegistry::updatePositions(SubmapVertices* vertices) {
+  CHECK_NOTNULL(vertices);
+  vertices->T_M_S = vertices->submap_ptr->getPose();
+  for (const auto& vertex_kv :
+       vertices->submap_ptr->getSkeletonGraph().getVertexMap()) {
+    vertices->positions[vertex_kv.second.vertex_id] =
+        vertices->T_M_S * vertex_kv.second.point;
+  }
+}
+
+}  // namespace glocal_exploration
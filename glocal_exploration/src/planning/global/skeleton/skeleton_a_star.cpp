@@ -1,10 +1,10 @@
 #include "glocal_exploration/planning/global/skeleton/skeleton_a_star.h"
 
+#include <algorithm>
+#include <chrono>
 #include <limits>
 #include <list>
 #include <map>
-#include <set>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -50,6 +50,8 @@ void SkeletonAStar::Config::printFields() const {
 
 bool SkeletonAStar::planPath(const Point& start_point, const Point& goal_point,
                              std::vector<RelativeWayPoint>* way_points) {
+  updateSubmapPoses();
+
   // Search the nearest reachable start vertex on the skeleton graphs
   if (!comm_->map()->isTraversableInActiveSubmap(
           start_point, config_.traversability_radius)) {
@@ -121,10 +123,12 @@ SkeletonAStar::searchClosestReachableSkeletonVertices(
     Point t_O_point = Point::Zero();
     float distance = -1.f;
   };
+  const SkeletonSubmapCollection::VertexRegistryConstPtr registry =
+      skeleton_submap_collection_.getVertexRegistry();
   std::list<CandidateVertex> candidate_start_vertices;
   for (const SubmapId submap_id : comm_->map()->getSubmapIdsAtPosition(point)) {
-    SkeletonSubmap::ConstPtr skeleton_submap =
-        skeleton_submap_collection_.getSubmapConstPtrById(submap_id);
+    const SkeletonSubmap::ConstPtr& skeleton_submap =
+        registry->getSubmap(submap_id);
     if (!skeleton_submap) {
       LOG(ERROR) << "Couldn't get pointer to skeleton submap with ID "
                  << submap_id;
@@ -135,8 +139,8 @@ SkeletonAStar::searchClosestReachableSkeletonVertices(
       CandidateVertex candidate_vertex;
       candidate_vertex.global_vertex_id.submap_id = submap_id;
       candidate_vertex.global_vertex_id.vertex_id = vertex_kv.second.vertex_id;
-      candidate_vertex.t_O_point =
-          skeleton_submap->getPose() * vertex_kv.second.point;
+      candidate_vertex.t_O_point = registry->getPosition(
+          registry->getIndex(candidate_vertex.global_vertex_id));
       candidate_vertex.distance = (candidate_vertex.t_O_point - point).norm();
       candidate_start_vertices.emplace_back(std::move(candidate_vertex));
     }
@@ -174,55 +178,95 @@ bool SkeletonAStar::getPathBetweenVertices(
   CHECK(!start_vertex_candidates.empty());
   CHECK(!end_vertex_candidates.empty());
 
-  std::map<GlobalVertexId, FloatingPoint> g_score_map;
-  std::map<GlobalVertexId, FloatingPoint> f_score_map;
-  std::map<GlobalVertexId, GlobalVertexId> parent_map;
-
-  std::set<GlobalVertexId> open_set;
-  std::set<GlobalVertexId> closed_set;
+  const auto t_start = std::chrono::steady_clock::now();
+
+  // The search state is stored in flat arrays, addressed by the vertices'
+  // indices in the registry. The goal gets the index after the last vertex.
+  const SkeletonSubmapCollection::VertexRegistryConstPtr registry =
+      skeleton_submap_collection_.getVertexRegistry();
+  const size_t goal_vertex_index = registry->size();
+  std::lock_guard<std::mutex> search_lock(search_mutex_);
+  resetSearchState(goal_vertex_index + 1u);
+  const auto get_vertex_id = [&](const size_t vertex_index) {
+    return vertex_index == goal_vertex_index
+               ? kGoalVertexId
+               : registry->getVertexId(vertex_index);
+  };
+  // Queue the vertex if the path through the parent is shorter than its
+  // current path.
+  const auto relax_vertex = [&](const size_t vertex_index,
+                                const size_t parent_index,
+                                const FloatingPoint tentative_g_score,
+                                const FloatingPoint heuristic) {
+    VertexSearchState& state = getSearchState(vertex_index);
+    if (tentative_g_score < state.g_score) {
+      state.g_score = tentative_g_score;
+      state.parent = parent_index;
+      open_set_.push(vertex_index, tentative_g_score + heuristic);
+    }
+  };
 
-  // Auto copy the visualization data once this method returns.
+  // Auto copy the visualization data and statistics once this method returns.
   // NOTE: We copy them s.t. it's safe to read them from a separate thread.
   std::map<GlobalVertexId, GlobalVertexId> intraversable_edge_map;
+  size_t iteration_counter = 0u;
   ExecuteOnScopeExit auto_copy_visuals([&]() {
+    std::map<GlobalVertexId, GlobalVertexId> parent_map;
+    SearchStatistics statistics;
+    for (const size_t vertex_index : touched_indices_) {
+      const VertexSearchState& state = search_states_[vertex_index];
+      if (state.g_score != kUnreached) {
+        ++statistics.num_vertices_reached;
+      }
+      if (state.parent != kNoParent) {
+        parent_map.emplace(get_vertex_id(vertex_index),
+                           get_vertex_id(state.parent));
+      }
+    }
+    statistics.num_expansions = iteration_counter;
+    statistics.duration_s = std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - t_start)
+                                .count();
+    VLOG(2) << "Skeleton A* expanded " << statistics.num_expansions
+            << " of " << statistics.num_vertices_reached
+            << " reached vertices in " << statistics.duration_s << "s ("
+            << statistics.getExpansionsPerSecond() << " expansions/s).";
     std::lock_guard<std::mutex> lock_guard(visualization_data_mutex_);
-    visualization_edges_.parent_map_ = parent_map;
+    visualization_edges_.parent_map_ = std::move(parent_map);
     visualization_edges_.intraversable_edge_map_ = intraversable_edge_map;
+    last_search_statistics_ = statistics;
   });
 
   // Initialize the search with vertices that can be used as graph entry points
   // i.e. vertices that are closest to the start_point and reachable
+  // NOTE: Candidates of submaps that were added after the registry version
+  //       used by this search was published are skipped.
   for (const GlobalVertexId& current_vertex_id : start_vertex_candidates) {
-    const SkeletonSubmap& current_submap =
-        skeleton_submap_collection_.getSubmapById(current_vertex_id.submap_id);
-    const voxblox::SparseSkeletonGraph& current_graph =
-        current_submap.getSkeletonGraph();
-    const voxblox::SkeletonVertex& current_vertex =
-        current_graph.getVertex(current_vertex_id.vertex_id);
-
-    const voxblox::Point t_odom_current_vertex =
-        current_submap.getPose() * current_vertex.point;
-    g_score_map[current_vertex_id] =
-        (t_odom_current_vertex - start_point).norm();
-    f_score_map[current_vertex_id] =
-        (goal_point - t_odom_current_vertex).norm();
-    open_set.insert(current_vertex_id);
+    const size_t current_vertex_index = registry->getIndex(current_vertex_id);
+    if (current_vertex_index == GlobalVertexRegistry::kInvalidIndex) {
+      continue;
+    }
+    const Point& t_odom_current_vertex =
+        registry->getPosition(current_vertex_index);
+    relax_vertex(current_vertex_index, kNoParent,
+                 (t_odom_current_vertex - start_point).norm(),
+                 (goal_point - t_odom_current_vertex).norm());
   }
 
   // Indicate which vertices can be used as graph exit points
   // i.e. vertices that are close to the end point and that can reach it
-  std::unordered_set<GlobalVertexId, GlobalVertexIdHash>
-      end_vertex_candidate_set;
   for (const GlobalVertexId& end_vertex_candidate : end_vertex_candidates) {
-    end_vertex_candidate_set.insert(end_vertex_candidate);
+    const size_t end_vertex_index = registry->getIndex(end_vertex_candidate);
+    if (end_vertex_index != GlobalVertexRegistry::kInvalidIndex) {
+      getSearchState(end_vertex_index).is_end_vertex_candidate = true;
+    }
   }
 
   // Run the Astar search
-  size_t iteration_counter = 0u;
   SubmapId previous_submap_id = -1;
   const SkeletonSubmap* current_submap = nullptr;
   const voxblox::SparseSkeletonGraph* current_graph = nullptr;
-  while (!open_set.empty()) {
+  while (!open_set_.empty()) {
     if (config_.max_num_a_star_iterations <= ++iteration_counter) {
       LOG(WARNING) << "Aborting skeleton planning. Exceeded maximum number of "
                       "iterations ("
@@ -230,52 +274,50 @@ bool SkeletonAStar::getPathBetweenVertices(
       return false;
     }
 
-    // Find the smallest f-value in the open set.
-    const GlobalVertexId current_vertex_id =
-        popSmallestFromOpen(f_score_map, &open_set);
+    // Get the vertex with the smallest f-value in the open set.
+    const size_t current_vertex_index = open_set_.pop();
 
     // Check if we have reached the goal
-    if (current_vertex_id == kGoalVertexId) {
+    if (current_vertex_index == goal_vertex_index) {
+      const double duration_s = std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() - t_start)
+                                    .count();
       LOG(INFO) << "Found skeleton path to goal in " << iteration_counter
-                << " iterations.";
-      getSolutionVertexPath(kGoalVertexId, parent_map, vertex_path);
+                << " iterations ("
+                << static_cast<double>(iteration_counter) / duration_s
+                << " expansions/s).";
+      getSolutionVertexPath(goal_vertex_index, *registry, vertex_path);
       return true;
     }
 
     // Get vertex's submap and graph
+    const GlobalVertexId& current_vertex_id =
+        registry->getVertexId(current_vertex_index);
     if (current_vertex_id.submap_id != previous_submap_id) {
-      current_submap = &skeleton_submap_collection_.getSubmapById(
-          current_vertex_id.submap_id);
+      current_submap = registry->getSubmap(current_vertex_id.submap_id).get();
       current_graph = &current_submap->getSkeletonGraph();
     }
     previous_submap_id = current_vertex_id.submap_id;
-    closed_set.insert(current_vertex_id);
+    VertexSearchState& current_state = getSearchState(current_vertex_index);
+    current_state.is_closed = true;
+    const FloatingPoint current_g_score = current_state.g_score;
 
     // If this vertex is an exit point candidate,
     // hallucinate an edge to the goal
     const voxblox::SkeletonVertex& current_vertex =
         current_graph->getVertex(current_vertex_id.vertex_id);
-    if (end_vertex_candidate_set.count(current_vertex_id)) {
-      //      LOG(WARNING) << "Found exit point candidate vertex";
-      if (open_set.count(kGoalVertexId) == 0) {
-        open_set.insert(kGoalVertexId);
-      }
-      FloatingPoint tentative_g_score =
-          g_score_map[current_vertex_id] +
-          (goal_point - current_vertex.point).norm();
-      if (g_score_map.count(kGoalVertexId) == 0 ||
-          g_score_map[kGoalVertexId] < tentative_g_score) {
-        g_score_map[kGoalVertexId] = tentative_g_score;
-        f_score_map[kGoalVertexId] = tentative_g_score;
-        parent_map[kGoalVertexId] = current_vertex_id;
-      }
+    const Point& t_odom_current_vertex =
+        registry->getPosition(current_vertex_index);
+    if (current_state.is_end_vertex_candidate) {
+      relax_vertex(goal_vertex_index, current_vertex_index,
+                   current_g_score +
+                       (goal_point - t_odom_current_vertex).norm(),
+                   0.f);
       continue;
     }
 
     // Unless this vertex already has many neighbors, try to connect to a
     // neighboring skeleton submap
-    const Point t_odom_current_vertex =
-        current_submap->getPose() * current_vertex.point;
     if (current_vertex.edge_list.size() <= 3) {
       int num_linked_submaps = 0;
       int num_links_total = 0;
@@ -286,8 +328,8 @@ bool SkeletonAStar::getPathBetweenVertices(
           continue;
         }
 
-        SkeletonSubmap::ConstPtr nearby_submap =
-            skeleton_submap_collection_.getSubmapConstPtrById(submap_id);
+        const SkeletonSubmap::ConstPtr& nearby_submap =
+            registry->getSubmap(submap_id);
         if (!nearby_submap) {
           continue;
         }
@@ -299,7 +341,8 @@ bool SkeletonAStar::getPathBetweenVertices(
         }
 
         voxblox::Point t_nearby_submap_current_vertex =
-            (nearby_submap->getPose().inverse() * t_odom_current_vertex);
+            registry->getSubmapPose(submap_id).inverse() *
+            t_odom_current_vertex;
         std::vector<VertexIdElement> nearest_vertex_ids;
         nearby_submap->getNClosestVertices(
             t_nearby_submap_current_vertex,
@@ -309,10 +352,13 @@ bool SkeletonAStar::getPathBetweenVertices(
         for (const VertexIdElement& nearby_vertex_id : nearest_vertex_ids) {
           const GlobalVertexId nearby_vertex_global_id{submap_id,
                                                        nearby_vertex_id};
-          const Point t_odom_nearby_vertex =
-              nearby_submap->getPose() * nearby_submap->getSkeletonGraph()
-                                             .getVertex(nearby_vertex_id)
-                                             .point;
+          const size_t nearby_vertex_index =
+              registry->getIndex(nearby_vertex_global_id);
+          if (nearby_vertex_index == GlobalVertexRegistry::kInvalidIndex) {
+            continue;
+          }
+          const Point& t_odom_nearby_vertex =
+              registry->getPosition(nearby_vertex_index);
           const float distance_current_to_nearby_vertex =
               (t_odom_current_vertex - t_odom_nearby_vertex).norm();
           if (distance_current_to_nearby_vertex <
@@ -322,24 +368,12 @@ bool SkeletonAStar::getPathBetweenVertices(
                     config_.traversability_radius)) {
               ++num_links_total;
               linked_submap = true;
-              if (closed_set.count(nearby_vertex_global_id) > 0) {
+              if (getSearchState(nearby_vertex_index).is_closed) {
                 continue;
               }
-              if (open_set.count(nearby_vertex_global_id) == 0) {
-                open_set.insert(nearby_vertex_global_id);
-              }
-
-              FloatingPoint tentative_g_score =
-                  g_score_map[current_vertex_id] +
-                  (t_odom_nearby_vertex - t_odom_current_vertex).norm();
-              if (g_score_map.count(nearby_vertex_global_id) == 0 ||
-                  g_score_map[nearby_vertex_global_id] < tentative_g_score) {
-                g_score_map[nearby_vertex_global_id] = tentative_g_score;
-                f_score_map[nearby_vertex_global_id] =
-                    tentative_g_score +
-                    (goal_point - t_odom_nearby_vertex).norm();
-                parent_map[nearby_vertex_global_id] = current_vertex_id;
-              }
+              relax_vertex(nearby_vertex_index, current_vertex_index,
+                           current_g_score + distance_current_to_nearby_vertex,
+                           (goal_point - t_odom_nearby_vertex).norm());
             } else {
               intraversable_edge_map[current_vertex_id] =
                   nearby_vertex_global_id;
@@ -362,16 +396,19 @@ bool SkeletonAStar::getPathBetweenVertices(
         neighbor_vertex_id.vertex_id = edge.start_vertex;
       }
 
-      if (closed_set.count(neighbor_vertex_id) > 0) {
+      const size_t neighbor_vertex_index =
+          registry->getIndex(neighbor_vertex_id);
+      if (neighbor_vertex_index == GlobalVertexRegistry::kInvalidIndex) {
+        continue;
+      }
+      if (getSearchState(neighbor_vertex_index).is_closed) {
         // This neighbor has already been checked
         continue;
       }
 
       // Check if this neighbor is reachable from the current vertex
-      const voxblox::SkeletonVertex& neighbor_vertex =
-          current_graph->getVertex(neighbor_vertex_id.vertex_id);
-      const voxblox::Point t_odom_neighbor_vertex =
-          current_submap->getPose() * neighbor_vertex.point;
+      const Point& t_odom_neighbor_vertex =
+          registry->getPosition(neighbor_vertex_index);
       if (!comm_->map()->isLineTraversableInGlobalMap(
               t_odom_current_vertex, t_odom_neighbor_vertex,
               config_.traversability_radius)) {
@@ -379,22 +416,10 @@ bool SkeletonAStar::getPathBetweenVertices(
         continue;
       }
 
-      if (open_set.count(neighbor_vertex_id) == 0) {
-        open_set.insert(neighbor_vertex_id);
-      }
-
-      FloatingPoint tentative_g_score =
-          g_score_map[current_vertex_id] +
-          (neighbor_vertex.point - current_vertex.point).norm();
-      // NOTE: Since the vertex and its neighbor are already in the same
-      //       (submap) frame, we can directly compute their distance above
-      if (g_score_map.count(neighbor_vertex_id) == 0 ||
-          g_score_map[neighbor_vertex_id] < tentative_g_score) {
-        g_score_map[neighbor_vertex_id] = tentative_g_score;
-        f_score_map[neighbor_vertex_id] =
-            tentative_g_score + (goal_point - t_odom_neighbor_vertex).norm();
-        parent_map[neighbor_vertex_id] = current_vertex_id;
-      }
+      relax_vertex(neighbor_vertex_index, current_vertex_index,
+                   current_g_score +
+                       (t_odom_neighbor_vertex - t_odom_current_vertex).norm(),
+                   (goal_point - t_odom_neighbor_vertex).norm());
     }
   }
 
@@ -422,37 +447,43 @@ void SkeletonAStar::convertVertexToWaypointPath(
 }
 
 void SkeletonAStar::getSolutionVertexPath(
-    GlobalVertexId end_vertex_id,
-    const std::map<GlobalVertexId, GlobalVertexId>& parent_map,
-    std::vector<GlobalVertexId>* vertex_path) {
+    const size_t end_vertex_index, const GlobalVertexRegistry& registry,
+    std::vector<GlobalVertexId>* vertex_path) const {
   CHECK_NOTNULL(vertex_path);
   vertex_path->clear();
-  vertex_path->push_back(end_vertex_id);
-  GlobalVertexId vertex_id = end_vertex_id;
-  while (parent_map.count(vertex_id) > 0) {
-    vertex_id = parent_map.at(vertex_id);
-    vertex_path->push_back(vertex_id);
+  for (size_t vertex_index = end_vertex_index; vertex_index != kNoParent;
+       vertex_index = search_states_[vertex_index].parent) {
+    vertex_path->push_back(vertex_index < registry.size()
+                               ? registry.getVertexId(vertex_index)
+                               : kGoalVertexId);
   }
   std::reverse(vertex_path->begin(), vertex_path->end());
 }
 
-GlobalVertexId SkeletonAStar::popSmallestFromOpen(
-    const std::map<GlobalVertexId, FloatingPoint>& f_score_map,
-    std::set<GlobalVertexId>* open_set) {
-  FloatingPoint min_distance = std::numeric_limits<FloatingPoint>::max();
-  auto min_iter = open_set->cbegin();
-
-  for (auto iter = open_set->cbegin(); iter != open_set->cend(); ++iter) {
-    FloatingPoint distance = f_score_map.at(*iter);
-    if (distance < min_distance) {
-      min_distance = distance;
-      min_iter = iter;
+void SkeletonAStar::resetSearchState(const size_t num_indices) const {
+  if (search_states_.size() < num_indices) {
+    search_states_.resize(num_indices);
+  }
+  touched_indices_.clear();
+  open_set_.clear();
+  if (++search_generation_ == 0u) {
+    // NOTE: When the generation wraps around, stale stamps could match again.
+    for (VertexSearchState& state : search_states_) {
+      state.generation = 0u;
     }
+    search_generation_ = 1u;
   }
+}
 
-  GlobalVertexId return_val = *min_iter;
-  open_set->erase(min_iter);
-  return return_val;
+SkeletonAStar::VertexSearchState& SkeletonAStar::getSearchState(
+    const size_t vertex_index) const {
+  VertexSearchState& state = search_states_[vertex_index];
+  if (state.generation != search_generation_) {
+    state = VertexSearchState();
+    state.generation = search_generation_;
+    touched_indices_.push_back(vertex_index);
+  }
+  return state;
 }
 
 }  // namespace glocal_exploration
@@ -1,13 +1,18 @@
 #include "glocal_exploration/planning/global/submap_frontier_evaluator.h"
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stack>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "glocal_exploration/mapping/compact_submap_layer.h"
+#include "glocal_exploration/planning/global/block_frontier_extractor.h"
 #include "glocal_exploration/state/communicator.h"
 
 namespace glocal_exploration {
@@ -20,6 +25,11 @@ void SubmapFrontierEvaluator::Config::checkParams() const {
   checkParamGT(min_frontier_size, 0, "min_frontier_size");
   checkParamGT(min_num_visible_frontier_points, 0,
                "min_num_visible_frontier_points");
+  checkParamGE(num_threads, 0, "num_threads");
+  checkParamGE(submap_pose_translation_threshold, 0.f,
+               "submap_pose_translation_threshold");
+  checkParamGE(submap_pose_rotation_threshold, 0.f,
+               "submap_pose_rotation_threshold");
 }
 
 void SubmapFrontierEvaluator::Config::fromRosParam() {
@@ -27,6 +37,12 @@ void SubmapFrontierEvaluator::Config::fromRosParam() {
   rosParam("min_frontier_size", &min_frontier_size);
   rosParam("submaps_are_frozen", &submaps_are_frozen);
   rosParam("min_num_visible_frontier_points", &min_num_visible_frontier_points);
+  rosParam("num_threads", &num_threads);
+  rosParam("use_block_frontier_extraction", &use_block_frontier_extraction);
+  rosParam("only_connected_frontiers", &only_connected_frontiers);
+  rosParam("submap_pose_translation_threshold",
+           &submap_pose_translation_threshold);
+  rosParam("submap_pose_rotation_threshold", &submap_pose_rotation_threshold);
 }
 
 void SubmapFrontierEvaluator::Config::printFields() const {
@@ -35,156 +51,329 @@ void SubmapFrontierEvaluator::Config::printFields() const {
   printField("submaps_are_frozen", submaps_are_frozen);
   printField("min_num_visible_frontier_points",
              min_num_visible_frontier_points);
+  printField("num_threads", num_threads);
+  printField("use_block_frontier_extraction", use_block_frontier_extraction);
+  printField("only_connected_frontiers", only_connected_frontiers);
+  printField("submap_pose_translation_threshold",
+             submap_pose_translation_threshold);
+  printField("submap_pose_rotation_threshold", submap_pose_rotation_threshold);
 }
 
 SubmapFrontierEvaluator::SubmapFrontierEvaluator(
     const Config& config, std::shared_ptr<Communicator> communicator)
     : GlobalPlannerBase(std::move(communicator)),
-      config_(config.checkValid()) {}
+      config_(config.checkValid()),
+      frontier_thread_pool_(config_.num_threads) {}
 
 void SubmapFrontierEvaluator::computeFrontiersForSubmap(
     const MapBase::SubmapData& data, const Point& initial_point) {
-  // Only one thread allowed at a time to run in background.
-  if (frontier_computation_thread_) {
-    if (frontier_computation_thread_->joinable()) {
-      frontier_computation_thread_->join();
-    }
-  }
+  std::lock_guard<std::mutex> slots_lock(frontier_candidates_mutex_);
   // Initialize all frontier candidates for the given layer and id.
   auto it = frontier_candidates_.find(data.id);
+  if (data.frontier_candidates) {
+    // Candidates tracked by the map are taken over once they changed.
+    if (it == frontier_candidates_.end()) {
+      it = frontier_candidates_.emplace(data.id, FrontierCandidateSlot()).first;
+    } else if (it->second.tracked_candidates == data.frontier_candidates) {
+      return;
+    } else if (it->second.computation.valid()) {
+      it->second.computation.wait();
+    }
+    it->second.candidates = *data.frontier_candidates;
+    it->second.tracked_candidates = data.frontier_candidates;
+    it->second.computation = std::shared_future<void>();
+    ++it->second.version;
+    return;
+  }
   if (it == frontier_candidates_.end()) {
     // New id, setup candidates.
-    it = frontier_candidates_
-             .insert(std::make_pair(data.id, std::vector<Point>()))
-             .first;
+    it = frontier_candidates_.emplace(data.id, FrontierCandidateSlot()).first;
   } else if (config_.submaps_are_frozen) {
     // Found an existing frozen frontier.
     return;
+  } else if (it->second.computation.valid()) {
+    // NOTE: If not frozen the frontiers will be recomputed and overwritten,
+    //       once their previous computation finished.
+    it->second.computation.wait();
   }
-  // NOTE: If not frozen the frontiers will be recomputed and overwritten.
 
-  // Compute all frontiers.
-  frontier_computation_thread_ =
-      std::make_unique<std::thread>([this, data, initial_point, it] {
-        computeFrontierCandidates(*(data.tsdf_layer), initial_point, &(*it));
-      });
+  // Compute all frontiers, preferably on the compact copy of the submap.
+  // NOTE: Pointers to the slots are stable, since the map is node based and
+  //       slots are never erased.
+  FrontierVoxelList* candidates = &it->second.candidates;
+  ++it->second.version;
+  it->second.computation =
+      frontier_thread_pool_
+          .submit([this, data, initial_point, candidates] {
+            if (config_.use_block_frontier_extraction &&
+                computeFrontierCandidatesBlockwise(data, initial_point,
+                                                   candidates)) {
+              return;
+            }
+            if (data.compact_layer) {
+              const CompactSubmapLayer& compact_layer = *data.compact_layer;
+              computeFrontierCandidates(
+                  [&compact_layer](const Index& index) {
+                    return compact_layer.getVoxelState(index);
+                  },
+                  compact_layer.voxel_size(), initial_point, data.id,
+                  candidates);
+            } else {
+              const voxblox::Layer<voxblox::TsdfVoxel>& layer =
+                  *data.tsdf_layer;
+              computeFrontierCandidates(
+                  [this, &layer](const Index& index) {
+                    return voxelState(index, layer);
+                  },
+                  layer.voxel_size(), initial_point, data.id, candidates);
+            }
+          })
+          .share();
 }
 
-void SubmapFrontierEvaluator::updateFrontiers(
-    const std::vector<MapBase::SubmapData>& data) {
-  // Make sure frontier computation finished.
-  if (frontier_computation_thread_) {
-    if (frontier_computation_thread_->joinable()) {
-      frontier_computation_thread_->join();
+const FrontierVoxelList* SubmapFrontierEvaluator::waitForFrontierCandidates(
+    const int submap_id, size_t* version) {
+  std::shared_future<void> computation;
+  const FrontierVoxelList* candidates;
+  {
+    std::lock_guard<std::mutex> slots_lock(frontier_candidates_mutex_);
+    auto it = frontier_candidates_.find(submap_id);
+    if (it == frontier_candidates_.end()) {
+      return nullptr;
+    }
+    computation = it->second.computation;
+    candidates = &it->second.candidates;
+    if (version) {
+      *version = it->second.version;
     }
   }
-  // Verify all frontiers are built. If they are frozen nothing happens.
-  int num_candidate_points = 0;
+  if (computation.valid()) {
+    computation.wait();
+  }
+  return candidates;
+}
+
+std::unordered_map<int, FrontierVoxelList>
+SubmapFrontierEvaluator::getFrontierCandidates() {
+  std::vector<int> submap_ids;
+  {
+    std::lock_guard<std::mutex> slots_lock(frontier_candidates_mutex_);
+    submap_ids.reserve(frontier_candidates_.size());
+    for (const auto& id_slot_pair : frontier_candidates_) {
+      submap_ids.emplace_back(id_slot_pair.first);
+    }
+  }
+  std::unordered_map<int, FrontierVoxelList> frontier_candidates;
+  for (const int submap_id : submap_ids) {
+    frontier_candidates.emplace(submap_id,
+                                *waitForFrontierCandidates(submap_id));
+  }
+  return frontier_candidates;
+}
+
+void SubmapFrontierEvaluator::updateFrontiers(
+    const std::vector<MapBase::SubmapData>& data) {
+  // Verify all frontiers are built. If they are frozen nothing happens, the
+  // missing ones are computed in parallel.
   // NOTE: The submap origin is in free space since it corresponds
   //       to a robot pose by construction.
   Point initial_point(0.f, 0.f, 0.f);
   for (const auto& datum : data) {
     computeFrontiersForSubmap(datum, initial_point);
-    num_candidate_points += frontier_candidates_.find(datum.id)->second.size();
+  }
+  int num_candidate_points = 0;
+  std::vector<const FrontierVoxelList*> submap_candidates;
+  std::vector<size_t> submap_candidate_versions(data.size());
+  submap_candidates.reserve(data.size());
+  for (size_t i = 0u; i < data.size(); ++i) {
+    submap_candidates.emplace_back(
+        waitForFrontierCandidates(data[i].id, &submap_candidate_versions[i]));
+    num_candidate_points += submap_candidates.back()->size();
   }
 
-  // Transform and condense all submap frontier candidates to global frame and
-  // check whether they are active. Then extract connected frontiers.
+  // Update the global frontiers with what changed since the last round: the
+  // candidates of new, moved and recomputed submaps, and the observed space.
   auto t_start = std::chrono::high_resolution_clock::now();
-
-  // Combine all candidates to a global set.
-  // NOTE(schmluk): Reserving the maximum amount of points might waste a bit of
-  //                memory but  prevents costly reallocation of bins and
-  //                rehashing the index. This occurs multiple times downstream.
-  IndexSet global_frontier_points;
-  global_frontier_points.reserve(num_candidate_points);
   FloatingPoint voxel_size = comm_->map()->getVoxelSize();
   CHECK_GT(voxel_size, 0.f);
   FloatingPoint voxel_size_inv = 1.f / voxel_size;
-  for (const auto& datum : data) {
-    auto it = frontier_candidates_.find(datum.id);
-    for (const Point& candidate_S : it->second) {
-      Point candidate_M = datum.T_M_S * candidate_S;
+
+  // Transform the candidates of the submaps that changed to global frame.
+  // NOTE: The new contribution of a submap is added before its old one is
+  //       removed, s.t. the candidates it still contains keep their state.
+  std::vector<Index> candidates_to_check;
+  std::vector<Index> deactivated_candidates;
+  int num_updated_submaps = 0;
+  std::unordered_set<int> supplied_submap_ids;
+  for (size_t i = 0u; i < data.size(); ++i) {
+    const Transformation& T_M_S = data[i].T_M_S;
+    supplied_submap_ids.insert(data[i].id);
+    auto contribution_it = submap_contributions_.find(data[i].id);
+    if (contribution_it != submap_contributions_.end() &&
+        contribution_it->second.candidates_version ==
+            submap_candidate_versions[i] &&
+        !submapPoseChanged(contribution_it->second.T_M_S, T_M_S)) {
+      continue;
+    }
+    SubmapContribution contribution;
+    contribution.T_M_S = T_M_S;
+    contribution.candidates_version = submap_candidate_versions[i];
+    contribution.global_indices.reserve(submap_candidates[i]->size());
+    for (const Point& candidate_S : submap_candidates[i]->points()) {
+      Point candidate_M = T_M_S * candidate_S;
       if (comm_->regionOfInterest()->contains(candidate_M)) {
-        global_frontier_points.insert(
+        contribution.global_indices.emplace_back(
             indexFromPoint(candidate_M, voxel_size_inv));
       }
     }
+    addGlobalCandidates(contribution.global_indices, &candidates_to_check);
+    if (contribution_it != submap_contributions_.end()) {
+      removeGlobalCandidates(contribution_it->second.global_indices,
+                             &deactivated_candidates);
+      contribution_it->second = std::move(contribution);
+    } else {
+      submap_contributions_.emplace(data[i].id, std::move(contribution));
+    }
+    ++num_updated_submaps;
   }
 
   // Verify the right number of transformations were supplied.
-  for (const auto& id_submap_pair : frontier_candidates_) {
-    if (std::find_if(data.begin(), data.end(),
-                     [id_submap_pair](const MapBase::SubmapData& d) {
-                       return d.id == id_submap_pair.first;
-                     }) == data.end()) {
-      LOG(WARNING) << "No update data for submap id " << id_submap_pair.first
-                   << " was supplied, its frontier candidates will be ignored.";
-    }
-  }
-
-  // Remove all inactive candidates.
-  const int num_global_candidates = global_frontier_points.size();
-  inactive_frontiers_.clear();
-  inactive_frontiers_.reserve(num_global_candidates);
-  auto it = global_frontier_points.begin();
-  while (it != global_frontier_points.end()) {
-    Point candidate = centerPointFromIndex(*it, voxel_size);
-    if (comm_->map()->isObservedInGlobalMap(candidate)) {
-      it = global_frontier_points.erase(it);
-      inactive_frontiers_.push_back(candidate);
+  {
+    std::lock_guard<std::mutex> slots_lock(frontier_candidates_mutex_);
+    for (const auto& id_slot_pair : frontier_candidates_) {
+      if (!supplied_submap_ids.count(id_slot_pair.first)) {
+        LOG(WARNING)
+            << "No update data for submap id " << id_slot_pair.first
+            << " was supplied, its frontier candidates will be ignored.";
+      }
+    }
+  }
+  auto contribution_it = submap_contributions_.begin();
+  while (contribution_it != submap_contributions_.end()) {
+    if (supplied_submap_ids.count(contribution_it->first)) {
+      ++contribution_it;
     } else {
-      it++;
+      removeGlobalCandidates(contribution_it->second.global_indices,
+                             &deactivated_candidates);
+      contribution_it = submap_contributions_.erase(contribution_it);
     }
   }
 
-  // Cluster frontiers.
-  const int num_active_points = global_frontier_points.size();
-  int num_final_points = 0;
-  int num_frontiers = 0;
-  active_frontiers_.clear();
-  while (!global_frontier_points.empty()) {
-    // Setup search with first point left in candidates.
-    IndexSet open_set;
-    IndexSet result_set;
-    open_set.reserve(num_active_points);
-    result_set.reserve(num_active_points);
-    open_set.insert(*global_frontier_points.begin());
-    result_set.insert(*global_frontier_points.begin());
-    global_frontier_points.erase(global_frontier_points.begin());
-
-    // Find all points connected to this frontier.
-    while (!open_set.empty()) {
-      const Index& open_point = *open_set.begin();
-      for (const Index& offset : kNeighborOffsets) {
-        const Index candidate = open_point + offset;
-        // Check whether it is a valid frontier point.
-        if (global_frontier_points.find(candidate) !=
-            global_frontier_points.end()) {
-          open_set.insert(candidate);
-          result_set.insert(candidate);
-          global_frontier_points.erase(candidate);
-        }
+  // Recheck the candidates in the parts of the map that changed.
+  // NOTE: The changes are queried before checking, s.t. changes that happen
+  //       in the meantime are processed again in the next round.
+  if (map_changes_consumer_id_ < 0) {
+    map_changes_consumer_id_ = comm_->map()->addObservedSpaceChangesConsumer();
+  }
+  const MapBase::ObservedSpaceChanges map_changes =
+      comm_->map()->getBlocksChangedSince(map_changes_consumer_id_,
+                                          map_revision_);
+  map_revision_ = map_changes.revision;
+  if (map_changes.block_size != candidate_block_size_) {
+    rebuildCandidateBlocks(map_changes.block_size, voxel_size);
+  }
+  if (map_changes.everything_changed) {
+    for (const auto& candidate_kv : global_candidates_) {
+      if (candidate_kv.second.is_checked) {
+        candidates_to_check.emplace_back(candidate_kv.first);
       }
-      open_set.erase(open_set.begin());
     }
+  } else if (!map_changes.changed_blocks.empty()) {
+    // Only look up the checked candidates in the changed blocks.
+    IndexSet changed_candidates;
+    for (const voxblox::BlockIndex& block_index : map_changes.changed_blocks) {
+      const auto block_it = candidate_blocks_.find(block_index);
+      if (block_it != candidate_blocks_.end()) {
+        changed_candidates.insert(block_it->second.begin(),
+                                  block_it->second.end());
+      }
+    }
+    candidates_to_check.insert(candidates_to_check.end(),
+                               changed_candidates.begin(),
+                               changed_candidates.end());
+  }
+  std::vector<GlobalCandidate*> checked_candidates;
+  std::vector<Index> checked_indices;
+  std::vector<Point> checked_points;
+  checked_candidates.reserve(candidates_to_check.size());
+  checked_indices.reserve(candidates_to_check.size());
+  checked_points.reserve(candidates_to_check.size());
+  for (const Index& index : candidates_to_check) {
+    auto candidate_it = global_candidates_.find(index);
+    if (candidate_it != global_candidates_.end()) {
+      checked_candidates.emplace_back(&candidate_it->second);
+      checked_indices.emplace_back(index);
+      checked_points.emplace_back(centerPointFromIndex(index, voxel_size));
+    }
+  }
+  std::vector<bool> is_observed;
+  comm_->map()->areObservedInGlobalMap(checked_points, &is_observed);
+  std::vector<Index> activated_candidates;
+  for (size_t i = 0u; i < checked_candidates.size(); ++i) {
+    const Index& index = checked_indices[i];
+    GlobalCandidate& candidate = *checked_candidates[i];
+    const bool was_active = candidate.isActive();
+    candidate.is_observed = is_observed[i];
+    if (!candidate.is_checked) {
+      candidate.is_checked = true;
+      addToCandidateBlocks(index);
+    }
+    if (was_active && !candidate.isActive()) {
+      deactivated_candidates.emplace_back(index);
+    } else if (!was_active && candidate.isActive()) {
+      activated_candidates.emplace_back(index);
+    }
+  }
+
+  // Update the connected frontiers locally, unless most of them changed.
+  if (map_changes.everything_changed ||
+      frontier_ids_.size() <
+          deactivated_candidates.size() + activated_candidates.size()) {
+    rebuildFrontiers();
+  } else {
+    removeFromFrontiers(deactivated_candidates);
+    addToFrontiers(activated_candidates);
+  }
 
-    // Check whether the final result matches the criteria and write result.
-    if (result_set.size() >= config_.min_frontier_size) {
-      std::vector<Point>& new_frontier = active_frontiers_.emplace_back();
-      new_frontier.reserve(result_set.size());
-      for (const Index& idx : result_set) {
-        new_frontier.emplace_back(centerPointFromIndex(idx, voxel_size));
+  // Write the results.
+  const int num_global_candidates = global_candidates_.size();
+  const int num_active_points = frontier_ids_.size();
+  int num_final_points = 0;
+  int num_frontiers = 0;
+  active_frontier_voxels_ = FrontierVoxelList(voxel_size);
+  active_frontier_voxels_.reserve(num_active_points);
+  active_frontier_ranges_.clear();
+  small_frontier_ids_.clear();
+  inactive_frontier_voxels_outdated_ = true;
+  for (const auto& id_frontier_pair : frontiers_) {
+    const IndexSet& frontier = id_frontier_pair.second;
+    // Check whether the frontier matches the criteria.
+    if (frontier.size() >= config_.min_frontier_size) {
+      const size_t begin = active_frontier_voxels_.size();
+      for (const Index& idx : frontier) {
+        active_frontier_voxels_.push_back(idx);
       }
-      num_final_points += result_set.size();
+      active_frontier_ranges_.emplace_back(begin,
+                                           active_frontier_voxels_.size());
+      num_final_points += frontier.size();
       num_frontiers++;
     } else {
-      for (const Index& idx : result_set) {
-        inactive_frontiers_.emplace_back(centerPointFromIndex(idx, voxel_size));
-      }
+      small_frontier_ids_.emplace_back(id_frontier_pair.first);
     }
   }
 
+  // Index the active frontiers by their centroids.
+  std::vector<Point> active_frontier_centroids;
+  active_frontier_centroids.reserve(active_frontier_ranges_.size());
+  for (const FrontierVoxelList::PointSpan& frontier : getActiveFrontiers()) {
+    Point centroid(0.f, 0.f, 0.f);
+    for (const Point& point : frontier) {
+      centroid += point;
+    }
+    active_frontier_centroids.emplace_back(centroid / frontier.size());
+  }
+  active_frontier_index_.build(active_frontier_centroids, getActiveFrontiers());
+
   // Logging.
   auto t_end = std::chrono::high_resolution_clock::now();
   std::stringstream info;
@@ -196,14 +385,248 @@ void SubmapFrontierEvaluator::updateFrontiers(
     info << " " << num_candidate_points << " candidates -> "
          << num_global_candidates << " global candidates -> "
          << num_active_points << " active points -> " << num_frontiers
-         << " frontiers, totaling " << num_final_points << " points.";
+         << " frontiers, totaling " << num_final_points << " points. "
+         << num_updated_submaps << " submaps changed, "
+         << candidates_to_check.size() << " candidates rechecked, "
+         << activated_candidates.size() << " activated, "
+         << deactivated_candidates.size() << " deactivated.";
   }
   LOG_IF(INFO, config_.verbosity >= 2) << info.str();
 }
 
+FrontierVoxelList::PointSpan SubmapFrontierEvaluator::getInactiveFrontiers()
+    const {
+  if (inactive_frontier_voxels_outdated_) {
+    inactive_frontier_voxels_ =
+        FrontierVoxelList(active_frontier_voxels_.voxel_size());
+    for (const auto& candidate_kv : global_candidates_) {
+      if (candidate_kv.second.is_observed) {
+        inactive_frontier_voxels_.push_back(candidate_kv.first);
+      }
+    }
+    for (const int frontier_id : small_frontier_ids_) {
+      for (const Index& idx : frontiers_.at(frontier_id)) {
+        inactive_frontier_voxels_.push_back(idx);
+      }
+    }
+    inactive_frontier_voxels_outdated_ = false;
+  }
+  return inactive_frontier_voxels_.points();
+}
+
+std::vector<FrontierVoxelList::PointSpan>
+SubmapFrontierEvaluator::getActiveFrontiers() const {
+  std::vector<FrontierVoxelList::PointSpan> active_frontiers;
+  active_frontiers.reserve(active_frontier_ranges_.size());
+  for (const auto& range : active_frontier_ranges_) {
+    active_frontiers.emplace_back(
+        active_frontier_voxels_.points(range.first, range.second));
+  }
+  return active_frontiers;
+}
+
+bool SubmapFrontierEvaluator::submapPoseChanged(
+    const Transformation& T_M_S_old, const Transformation& T_M_S_new) const {
+  const Transformation pose_delta = T_M_S_old.inverse() * T_M_S_new;
+  const FloatingPoint angle_delta = pose_delta.log().tail<3>().norm();
+  const FloatingPoint translation_delta = pose_delta.log().head<3>().norm();
+  return (config_.submap_pose_translation_threshold < translation_delta ||
+          config_.submap_pose_rotation_threshold < angle_delta);
+}
+
+void SubmapFrontierEvaluator::addGlobalCandidates(
+    const std::vector<Index>& indices, std::vector<Index>* new_candidates) {
+  CHECK_NOTNULL(new_candidates);
+  for (const Index& index : indices) {
+    GlobalCandidate& candidate = global_candidates_[index];
+    if (candidate.num_references++ == 0) {
+      new_candidates->emplace_back(index);
+    }
+  }
+}
+
+void SubmapFrontierEvaluator::removeGlobalCandidates(
+    const std::vector<Index>& indices,
+    std::vector<Index>* removed_active_candidates) {
+  CHECK_NOTNULL(removed_active_candidates);
+  for (const Index& index : indices) {
+    auto it = global_candidates_.find(index);
+    if (it == global_candidates_.end() || --it->second.num_references > 0) {
+      continue;
+    }
+    if (it->second.isActive()) {
+      removed_active_candidates->emplace_back(index);
+    }
+    if (it->second.is_checked) {
+      removeFromCandidateBlocks(index);
+    }
+    global_candidates_.erase(it);
+  }
+}
+
+void SubmapFrontierEvaluator::getCandidateBlocks(
+    const Index& index, voxblox::BlockIndexList* block_indices) const {
+  CHECK_NOTNULL(block_indices);
+  block_indices->clear();
+  if (candidate_block_size_ <= 0.f) {
+    return;
+  }
+  // Observedness is interpolated, so neighboring blocks matter as well.
+  const FloatingPoint block_size_inv = 1.f / candidate_block_size_;
+  const Point candidate = centerPointFromIndex(index, candidate_voxel_size_);
+  const Point half_voxel = Point::Constant(0.5f * candidate_voxel_size_);
+  const auto min_block_index =
+      voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+          candidate - half_voxel, block_size_inv);
+  const auto max_block_index =
+      voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+          candidate + half_voxel, block_size_inv);
+  voxblox::BlockIndex block_index;
+  for (block_index.x() = min_block_index.x();
+       block_index.x() <= max_block_index.x(); ++block_index.x()) {
+    for (block_index.y() = min_block_index.y();
+         block_index.y() <= max_block_index.y(); ++block_index.y()) {
+      for (block_index.z() = min_block_index.z();
+           block_index.z() <= max_block_index.z(); ++block_index.z()) {
+        block_indices->emplace_back(block_index);
+      }
+    }
+  }
+}
+
+void SubmapFrontierEvaluator::addToCandidateBlocks(const Index& index) {
+  voxblox::BlockIndexList block_indices;
+  getCandidateBlocks(index, &block_indices);
+  for (const voxblox::BlockIndex& block_index : block_indices) {
+    candidate_blocks_[block_index].insert(index);
+  }
+}
+
+void SubmapFrontierEvaluator::removeFromCandidateBlocks(const Index& index) {
+  voxblox::BlockIndexList block_indices;
+  getCandidateBlocks(index, &block_indices);
+  for (const voxblox::BlockIndex& block_index : block_indices) {
+    auto block_it = candidate_blocks_.find(block_index);
+    if (block_it == candidate_blocks_.end()) {
+      continue;
+    }
+    block_it->second.erase(index);
+    if (block_it->second.empty()) {
+      candidate_blocks_.erase(block_it);
+    }
+  }
+}
+
+void SubmapFrontierEvaluator::rebuildCandidateBlocks(
+    const FloatingPoint block_size, const FloatingPoint voxel_size) {
+  candidate_block_size_ = block_size;
+  candidate_voxel_size_ = voxel_size;
+  candidate_blocks_.clear();
+  for (const auto& candidate_kv : global_candidates_) {
+    if (candidate_kv.second.is_checked) {
+      addToCandidateBlocks(candidate_kv.first);
+    }
+  }
+}
+
+void SubmapFrontierEvaluator::removeFromFrontiers(
+    const std::vector<Index>& indices) {
+  // Remove the candidates from their frontiers.
+  std::unordered_set<int> affected_frontier_ids;
+  for (const Index& index : indices) {
+    auto it = frontier_ids_.find(index);
+    if (it == frontier_ids_.end()) {
+      continue;
+    }
+    frontiers_[it->second].erase(index);
+    affected_frontier_ids.insert(it->second);
+    frontier_ids_.erase(it);
+  }
+
+  // Split the affected frontiers into their connected parts.
+  std::vector<Index> remaining_points;
+  std::vector<int> labels;
+  for (const int frontier_id : affected_frontier_ids) {
+    auto frontier_it = frontiers_.find(frontier_id);
+    remaining_points.assign(frontier_it->second.begin(),
+                            frontier_it->second.end());
+    frontiers_.erase(frontier_it);
+    addFrontiers(remaining_points, &labels);
+  }
+}
+
+void SubmapFrontierEvaluator::addFrontiers(const std::vector<Index>& points,
+                                           std::vector<int>* labels) {
+  CHECK_NOTNULL(labels);
+  const int num_clusters = frontier_clusterer_.cluster(points, labels);
+  const int first_frontier_id = next_frontier_id_;
+  next_frontier_id_ += num_clusters;
+  for (size_t i = 0u; i < points.size(); ++i) {
+    const int frontier_id = first_frontier_id + (*labels)[i];
+    frontiers_[frontier_id].insert(points[i]);
+    frontier_ids_[points[i]] = frontier_id;
+  }
+}
+
+void SubmapFrontierEvaluator::rebuildFrontiers() {
+  frontiers_.clear();
+  frontier_ids_.clear();
+  std::vector<Index> active_points;
+  active_points.reserve(global_candidates_.size());
+  for (const auto& candidate_kv : global_candidates_) {
+    if (candidate_kv.second.isActive()) {
+      active_points.emplace_back(candidate_kv.first);
+    }
+  }
+  std::vector<int> labels;
+  addFrontiers(active_points, &labels);
+}
+
+void SubmapFrontierEvaluator::addToFrontiers(
+    const std::vector<Index>& indices) {
+  for (const Index& index : indices) {
+    // Find the frontiers this candidate connects.
+    std::unordered_set<int> neighbor_frontier_ids;
+    for (const Index& offset : kNeighborOffsets) {
+      auto it = frontier_ids_.find(index + offset);
+      if (it != frontier_ids_.end()) {
+        neighbor_frontier_ids.insert(it->second);
+      }
+    }
+    if (neighbor_frontier_ids.empty()) {
+      const int new_frontier_id = next_frontier_id_++;
+      frontiers_[new_frontier_id].insert(index);
+      frontier_ids_[index] = new_frontier_id;
+      continue;
+    }
+
+    // Merge them into the largest one.
+    const int largest_frontier_id = *std::max_element(
+        neighbor_frontier_ids.begin(), neighbor_frontier_ids.end(),
+        [this](const int lhs, const int rhs) {
+          return frontiers_[lhs].size() < frontiers_[rhs].size();
+        });
+    IndexSet& largest_frontier = frontiers_[largest_frontier_id];
+    for (const int frontier_id : neighbor_frontier_ids) {
+      if (frontier_id == largest_frontier_id) {
+        continue;
+      }
+      for (const Index& point : frontiers_[frontier_id]) {
+        largest_frontier.insert(point);
+        frontier_ids_[point] = largest_frontier_id;
+      }
+      frontiers_.erase(frontier_id);
+    }
+    largest_frontier.insert(index);
+    frontier_ids_[index] = largest_frontier_id;
+  }
+}
+
+template <typename VoxelStateFunctor>
 void SubmapFrontierEvaluator::computeFrontierCandidates(
-    const voxblox::Layer<voxblox::TsdfVoxel>& layer, const Point& initial_point,
-    std::pair<const int, std::vector<Point>>* output) {
+    const VoxelStateFunctor& voxel_state, const FloatingPoint voxel_size,
+    const Point& initial_point, const int submap_id,
+    FrontierVoxelList* output) const {
   // Perform a full sweep over the submap's free space to identify frontier
   // candidates. Frontiers are unknown points that border observed free space
   // and are attributed to the submap that contains the free space. Use
@@ -212,14 +635,13 @@ void SubmapFrontierEvaluator::computeFrontierCandidates(
   auto t_start = std::chrono::high_resolution_clock::now();
 
   // Cache submap data.
-  FloatingPoint voxel_size = layer.voxel_size();
   CHECK_GT(voxel_size, 0.f);
   FloatingPoint voxel_size_inv = 1.f / voxel_size;
 
   // Setup search.
   IndexSet closed_list;
   std::stack<Index> open_stack;
-  std::vector<Point> result;
+  FrontierVoxelList result(voxel_size);
   open_stack.push(indexFromPoint(initial_point, voxel_size_inv));
 
   // Search all frontiers.
@@ -236,7 +658,7 @@ void SubmapFrontierEvaluator::computeFrontierCandidates(
         continue;
       }
       closed_list.insert(candidate);
-      switch (voxelState(candidate, layer)) {
+      switch (voxel_state(candidate)) {
         case MapBase::VoxelState::kFree: {
           // Adjacent free space to continue the search.
           open_stack.push(candidate);
@@ -244,7 +666,7 @@ void SubmapFrontierEvaluator::computeFrontierCandidates(
         }
         case MapBase::VoxelState::kUnknown: {
           // This is a frontier point.
-          result.push_back(centerPointFromIndex(candidate, voxel_size));
+          result.push_back(candidate);
           break;
         }
         case MapBase::VoxelState::kOccupied:
@@ -254,18 +676,81 @@ void SubmapFrontierEvaluator::computeFrontierCandidates(
       }
     }
   }
-  output->second = result;
+  *output = std::move(result);
   auto t_end = std::chrono::high_resolution_clock::now();
 
   // Logging
   LOG_IF(INFO, config_.verbosity >= 2)
-      << "Found " << result.size() << " frontier candidates in submap "
-      << output->first << " in "
+      << "Found " << output->size() << " frontier candidates in submap "
+      << submap_id << " in "
       << std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start)
              .count()
       << "ms.";
 }
 
+bool SubmapFrontierEvaluator::computeFrontierCandidatesBlockwise(
+    const MapBase::SubmapData& data, const Point& initial_point,
+    FrontierVoxelList* output) const {
+  CHECK_NOTNULL(output);
+  const size_t voxels_per_side = data.compact_layer
+                                     ? data.compact_layer->voxels_per_side()
+                                     : data.tsdf_layer->voxels_per_side();
+  if (voxels_per_side > BlockFrontierExtractor::kMaxVoxelsPerSide) {
+    return false;
+  }
+  auto t_start = std::chrono::high_resolution_clock::now();
+
+  // Classify the voxels of all blocks.
+  BlockFrontierExtractor extractor(voxels_per_side);
+  std::vector<MapBase::VoxelState> voxel_states;
+  FloatingPoint voxel_size;
+  if (data.compact_layer) {
+    const CompactSubmapLayer& compact_layer = *data.compact_layer;
+    voxel_size = compact_layer.voxel_size();
+    for (const voxblox::BlockIndex& block_index :
+         compact_layer.getBlockIndices()) {
+      compact_layer.getBlockVoxelStates(block_index, &voxel_states);
+      extractor.addBlock(block_index, voxel_states);
+    }
+  } else {
+    const voxblox::Layer<voxblox::TsdfVoxel>& layer = *data.tsdf_layer;
+    voxel_size = layer.voxel_size();
+    voxblox::BlockIndexList block_indices;
+    layer.getAllAllocatedBlocks(&block_indices);
+    for (const voxblox::BlockIndex& block_index : block_indices) {
+      const voxblox::Block<voxblox::TsdfVoxel>& block =
+          layer.getBlockByIndex(block_index);
+      voxel_states.resize(block.num_voxels());
+      for (size_t linear_index = 0u; linear_index < block.num_voxels();
+           ++linear_index) {
+        voxel_states[linear_index] = tsdfVoxelState(
+            block.getVoxelByLinearIndex(linear_index), voxel_size);
+      }
+      extractor.addBlock(block_index, voxel_states);
+    }
+  }
+
+  // Find all unknown voxels next to the (connected) free space.
+  const Index initial_index = indexFromPoint(initial_point, 1.f / voxel_size);
+  const std::vector<Index> frontier_indices = extractor.extractFrontiers(
+      config_.only_connected_frontiers ? &initial_index : nullptr);
+  *output = FrontierVoxelList(voxel_size);
+  output->reserve(frontier_indices.size());
+  for (const Index& index : frontier_indices) {
+    output->push_back(index);
+  }
+  auto t_end = std::chrono::high_resolution_clock::now();
+
+  // Logging
+  LOG_IF(INFO, config_.verbosity >= 2)
+      << "Found " << output->size() << " frontier candidates in submap "
+      << data.id << " in "
+      << std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start)
+             .count()
+      << "ms.";
+  return true;
+}
+
 SubmapFrontierEvaluator::Index SubmapFrontierEvaluator::indexFromPoint(
     const Point& point, FloatingPoint voxel_size_inv) const {
   return voxblox::getGridIndexFromPoint<Index>(point, voxel_size_inv);
@@ -284,15 +769,21 @@ MapBase::VoxelState SubmapFrontierEvaluator::voxelState(
       index, layer.voxels_per_side(), &block_idx, &voxel_idx);
   const auto block = layer.getBlockPtrByIndex(block_idx);
   if (block) {
-    const voxblox::TsdfVoxel& voxel = block->getVoxelByVoxelIndex(voxel_idx);
-    if (voxel.weight > 1e-6) {
-      if (voxel.distance > layer.voxel_size()) {
-        // Note(schmluk): The surface is slightly inflated to make detection
-        // more conservative and avoid frontiers out in the blue.
-        return MapBase::VoxelState::kFree;
-      } else {
-        return MapBase::VoxelState::kOccupied;
-      }
+    return tsdfVoxelState(block->getVoxelByVoxelIndex(voxel_idx),
+                          layer.voxel_size());
+  }
+  return MapBase::VoxelState::kUnknown;
+}
+
+MapBase::VoxelState SubmapFrontierEvaluator::tsdfVoxelState(
+    const voxblox::TsdfVoxel& voxel, const FloatingPoint voxel_size) {
+  if (voxel.weight > 1e-6) {
+    if (voxel.distance > voxel_size) {
+      // Note(schmluk): The surface is slightly inflated to make detection
+      // more conservative and avoid frontiers out in the blue.
+      return MapBase::VoxelState::kFree;
+    } else {
+      return MapBase::VoxelState::kOccupied;
     }
   }
   return MapBase::VoxelState::kUnknown;
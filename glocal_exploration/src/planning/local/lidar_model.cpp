@@ -97,6 +97,9 @@ void LidarModel::getVisibleUnknownVoxels(const WayPoint& waypoint,
       Eigen::AngleAxisf(waypoint.yaw, Point::UnitZ()) *
       config_.T_baselink_sensor.getEigenQuaternion();
   Point position = waypoint.position + config_.T_baselink_sensor.getPosition();
+  // Steps through blocks that are known to be free skip the map lookup
+  const BlockSummaryLayer::ConstPtr block_summary =
+      comm_->map()->getBlockSummaryOfActiveSubmap();
   Point camera_direction;
   Point direction;
   Point current_position;
@@ -124,8 +127,11 @@ void LidarModel::getVisibleUnknownVoxels(const WayPoint& waypoint,
           distance += config_.ray_step;
 
           // Check voxel occupied
-          MapBase::VoxelState state =
-              comm_->map()->getVoxelStateInLocalArea(current_position);
+          MapBase::VoxelState state = MapBase::VoxelState::kFree;
+          if (!block_summary ||
+              !block_summary->isInFreeBlock(current_position)) {
+            state = comm_->map()->getVoxelStateInLocalArea(current_position);
+          }
           if (state == MapBase::VoxelState::kOccupied ||
               !comm_->regionOfInterest()->contains(current_position)) {
             // Occlusion, mark neighboring rays as occluded
@@ -0,0 +1,100 @@
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "glocal_exploration/mapping/block_change_tracker.h"
+
+using glocal_exploration::BlockChangeTracker;
+using glocal_exploration::MapBase;
+
+namespace {
+voxblox::BlockIndexList makeBlocks(const int first_x, const int num_blocks) {
+  voxblox::BlockIndexList blocks;
+  for (int x = first_x; x < first_x + num_blocks; ++x) {
+    blocks.emplace_back(x, 0, 0);
+  }
+  return blocks;
+}
+}  // namespace
+
+TEST(BlockChangeTrackerTest, ReportsChangesSinceRevision) {
+  BlockChangeTracker tracker(1.f);
+  const int consumer = tracker.addConsumer();
+  MapBase::ObservedSpaceChanges changes = tracker.getChangesSince(consumer, 0u);
+  EXPECT_FALSE(changes.everything_changed);
+  EXPECT_TRUE(changes.changed_blocks.empty());
+
+  tracker.markChanged(makeBlocks(0, 2));
+  tracker.markChanged(makeBlocks(1, 2));
+  changes = tracker.getChangesSince(consumer, changes.revision);
+  EXPECT_FALSE(changes.everything_changed);
+  EXPECT_EQ(changes.changed_blocks.size(), 3u);
+
+  changes = tracker.getChangesSince(consumer, changes.revision);
+  EXPECT_FALSE(changes.everything_changed);
+  EXPECT_TRUE(changes.changed_blocks.empty());
+}
+
+TEST(BlockChangeTrackerTest, CapsTheLogForIdleConsumers) {
+  BlockChangeTracker tracker(1.f, 10u);
+  const int idle_consumer = tracker.addConsumer();
+  const int active_consumer = tracker.addConsumer();
+  const uint64_t idle_revision =
+      tracker.getChangesSince(idle_consumer, 0u).revision;
+  uint64_t active_revision =
+      tracker.getChangesSince(active_consumer, 0u).revision;
+
+  // The active consumer keeps up, whereas the idle one holds on to the first
+  // revision, s.t. only the cap bounds the log
+  for (int i = 0; i < 100; ++i) {
+    tracker.markChanged(makeBlocks(i, 4));
+    const MapBase::ObservedSpaceChanges changes =
+        tracker.getChangesSince(active_consumer, active_revision);
+    EXPECT_FALSE(changes.everything_changed);
+    EXPECT_EQ(changes.changed_blocks.size(), 4u);
+    active_revision = changes.revision;
+  }
+
+  const MapBase::ObservedSpaceChanges changes =
+      tracker.getChangesSince(idle_consumer, idle_revision);
+  EXPECT_TRUE(changes.everything_changed);
+  EXPECT_TRUE(changes.changed_blocks.empty());
+}
+
+TEST(BlockChangeTrackerTest, KeepsChangesWithinTheCap) {
+  BlockChangeTracker tracker(1.f, 10u);
+  const int consumer = tracker.addConsumer();
+  const uint64_t revision = tracker.getChangesSince(consumer, 0u).revision;
+  tracker.markChanged(makeBlocks(0, 4));
+  tracker.markChanged(makeBlocks(4, 4));
+  MapBase::ObservedSpaceChanges changes =
+      tracker.getChangesSince(consumer, revision);
+  EXPECT_FALSE(changes.everything_changed);
+  EXPECT_EQ(changes.changed_blocks.size(), 8u);
+
+  // Exceeding the cap trims the oldest changes
+  tracker.markChanged(makeBlocks(8, 4));
+  tracker.markChanged(makeBlocks(12, 4));
+  tracker.markChanged(makeBlocks(16, 4));
+  changes = tracker.getChangesSince(consumer, changes.revision);
+  EXPECT_TRUE(changes.everything_changed);
+}
+
+TEST(BlockChangeTrackerTest, ReportsEverythingChanged) {
+  BlockChangeTracker tracker(1.f);
+  const int consumer = tracker.addConsumer();
+  const uint64_t revision = tracker.getChangesSince(consumer, 0u).revision;
+  tracker.markChanged(makeBlocks(0, 2));
+  tracker.markEverythingChanged();
+  MapBase::ObservedSpaceChanges changes =
+      tracker.getChangesSince(consumer, revision);
+  EXPECT_TRUE(changes.everything_changed);
+  changes = tracker.getChangesSince(consumer, changes.revision);
+  EXPECT_FALSE(changes.everything_changed);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
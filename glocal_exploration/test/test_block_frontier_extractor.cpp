@@ -0,0 +1,146 @@
+#include <array>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "glocal_exploration/planning/global/block_frontier_extractor.h"
+
+using glocal_exploration::BlockFrontierExtractor;
+using glocal_exploration::MapBase;
+using voxblox::BlockIndex;
+using voxblox::GlobalIndex;
+
+namespace {
+constexpr int kVoxelsPerSide = 4;
+using VoxelSet = std::set<std::array<int64_t, 3>>;
+
+VoxelSet toSet(const std::vector<GlobalIndex>& voxels) {
+  VoxelSet result;
+  for (const GlobalIndex& voxel : voxels) {
+    result.insert({voxel.x(), voxel.y(), voxel.z()});
+  }
+  return result;
+}
+
+// The 26 neighbors of a voxel, optionally only those outside of a block.
+VoxelSet getNeighbors(const GlobalIndex& voxel,
+                      const BlockIndex* excluded_block = nullptr) {
+  VoxelSet result;
+  for (int i = 0; i < 27; ++i) {
+    const GlobalIndex neighbor =
+        voxel + GlobalIndex(i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1);
+    BlockIndex block_index;
+    voxblox::VoxelIndex voxel_index;
+    voxblox::getBlockAndVoxelIndexFromGlobalVoxelIndex(
+        neighbor, kVoxelsPerSide, &block_index, &voxel_index);
+    if (i != 13 && !(excluded_block && block_index == *excluded_block)) {
+      result.insert({neighbor.x(), neighbor.y(), neighbor.z()});
+    }
+  }
+  return result;
+}
+
+// An occupied block at the origin with free voxels at two opposite corners,
+// which are not connected through free space.
+std::vector<MapBase::VoxelState> makeOccupiedBlockWithFreeCorners() {
+  constexpr int n = kVoxelsPerSide;
+  std::vector<MapBase::VoxelState> states(n * n * n,
+                                          MapBase::VoxelState::kOccupied);
+  states.front() = MapBase::VoxelState::kFree;
+  states.back() = MapBase::VoxelState::kFree;
+  return states;
+}
+}  // namespace
+
+TEST(BlockFrontierExtractorTest, FindsFrontiersAcrossBlockBorders) {
+  BlockFrontierExtractor extractor(kVoxelsPerSide);
+  const BlockIndex block_index(0, 0, 0);
+  extractor.addBlock(block_index, makeOccupiedBlockWithFreeCorners());
+
+  // The frontiers lie in the unallocated blocks around both free corners.
+  VoxelSet expected = getNeighbors(GlobalIndex(0, 0, 0), &block_index);
+  const VoxelSet far_corner = getNeighbors(GlobalIndex(3, 3, 3), &block_index);
+  expected.insert(far_corner.begin(), far_corner.end());
+  EXPECT_EQ(expected.size(), 38u);
+  EXPECT_EQ(toSet(extractor.extractFrontiers()), expected);
+
+  // Unknown voxels in allocated neighbor blocks are frontiers just the same.
+  constexpr int n = kVoxelsPerSide;
+  std::vector<MapBase::VoxelState> unknown_states(
+      n * n * n, MapBase::VoxelState::kUnknown);
+  extractor.addBlock(BlockIndex(1, 1, 1), unknown_states);
+  EXPECT_EQ(toSet(extractor.extractFrontiers()), expected);
+}
+
+TEST(BlockFrontierExtractorTest, FindsFrontiersOfSingleBlocks) {
+  BlockFrontierExtractor extractor(kVoxelsPerSide);
+  const BlockIndex block_index(0, 0, 0);
+  extractor.addBlock(block_index, makeOccupiedBlockWithFreeCorners());
+
+  // The neighboring block only contains the frontiers next to its corner.
+  std::vector<GlobalIndex> frontiers;
+  extractor.extractFrontiersInBlock(BlockIndex(1, 1, 1), &frontiers);
+  EXPECT_EQ(toSet(frontiers), VoxelSet({{4, 4, 4}}));
+  frontiers.clear();
+  extractor.extractFrontiersInBlock(block_index, &frontiers);
+  EXPECT_TRUE(frontiers.empty());
+
+  // Removed blocks are unknown again.
+  extractor.removeBlock(block_index);
+  EXPECT_TRUE(extractor.extractFrontiers().empty());
+}
+
+TEST(BlockFrontierExtractorTest, SeedInFreeSpace) {
+  BlockFrontierExtractor extractor(kVoxelsPerSide);
+  const BlockIndex block_index(0, 0, 0);
+  extractor.addBlock(block_index, makeOccupiedBlockWithFreeCorners());
+
+  // Only the free space that is connected to the seed is searched.
+  const GlobalIndex seed(0, 0, 0);
+  EXPECT_EQ(toSet(extractor.extractFrontiers(&seed)),
+            getNeighbors(seed, &block_index));
+  const GlobalIndex other_seed(3, 3, 3);
+  EXPECT_EQ(toSet(extractor.extractFrontiers(&other_seed)),
+            getNeighbors(other_seed, &block_index));
+}
+
+TEST(BlockFrontierExtractorTest, UnknownSeedNextToFreeSpace) {
+  BlockFrontierExtractor extractor(kVoxelsPerSide);
+  const BlockIndex block_index(0, 0, 0);
+  extractor.addBlock(block_index, makeOccupiedBlockWithFreeCorners());
+
+  // The free corner is reached from the seed, which thus is a frontier, as
+  // are the unknown neighbors of both.
+  const GlobalIndex seed(-1, -1, -1);
+  VoxelSet expected = getNeighbors(GlobalIndex(0, 0, 0), &block_index);
+  const VoxelSet seed_neighbors = getNeighbors(seed, &block_index);
+  expected.insert(seed_neighbors.begin(), seed_neighbors.end());
+  const VoxelSet frontiers = toSet(extractor.extractFrontiers(&seed));
+  EXPECT_EQ(frontiers, expected);
+  EXPECT_EQ(frontiers.count({-1, -1, -1}), 1u);
+  EXPECT_EQ(frontiers.count({4, 4, 4}), 0u);
+}
+
+TEST(BlockFrontierExtractorTest, UnknownSeedWithoutFreeSpaceNextToIt) {
+  BlockFrontierExtractor extractor(kVoxelsPerSide);
+  const BlockIndex block_index(0, 0, 0);
+  extractor.addBlock(block_index, makeOccupiedBlockWithFreeCorners());
+
+  // As for a flood fill, the seed's neighbors are searched, but the seed
+  // itself is no frontier since no free space is next to it.
+  const GlobalIndex seed(10, 10, 10);
+  const VoxelSet frontiers = toSet(extractor.extractFrontiers(&seed));
+  EXPECT_EQ(frontiers, getNeighbors(seed));
+  EXPECT_EQ(frontiers.count({10, 10, 10}), 0u);
+
+  // A seed enclosed by occupied space has no frontiers at all.
+  const GlobalIndex enclosed_seed(1, 2, 2);
+  EXPECT_TRUE(extractor.extractFrontiers(&enclosed_seed).empty());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
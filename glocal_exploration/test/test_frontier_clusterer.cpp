@@ -0,0 +1,86 @@
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "glocal_exploration/planning/global/frontier_clusterer.h"
+
+using glocal_exploration::FrontierClusterer;
+using voxblox::GlobalIndex;
+
+namespace {
+int countDistinct(const std::vector<int>& labels) {
+  return static_cast<int>(std::set<int>(labels.begin(), labels.end()).size());
+}
+}  // namespace
+
+TEST(FrontierClustererTest, HandlesEmptyInput) {
+  FrontierClusterer clusterer;
+  std::vector<int> labels{1, 2, 3};
+  EXPECT_EQ(clusterer.cluster({}, &labels), 0);
+  EXPECT_TRUE(labels.empty());
+}
+
+TEST(FrontierClustererTest, JoinsClustersAcrossBlockFaces) {
+  // The clusterer's blocks are 8 voxels wide, so these touch across a face.
+  const std::vector<GlobalIndex> voxels{GlobalIndex(7, 0, 0),
+                                        GlobalIndex(8, 0, 0)};
+  FrontierClusterer clusterer;
+  std::vector<int> labels;
+  EXPECT_EQ(clusterer.cluster(voxels, &labels), 1);
+  EXPECT_EQ(labels, std::vector<int>({0, 0}));
+}
+
+TEST(FrontierClustererTest, JoinsClustersAcrossBlockCorners) {
+  // Diagonal neighbors in eight different blocks, around the origin.
+  std::vector<GlobalIndex> voxels;
+  for (int i = 0; i < 8; ++i) {
+    voxels.emplace_back(i & 1 ? 0 : -1, i & 2 ? 0 : -1, i & 4 ? 0 : -1);
+  }
+  FrontierClusterer clusterer;
+  std::vector<int> labels;
+  EXPECT_EQ(clusterer.cluster(voxels, &labels), 1);
+  EXPECT_EQ(countDistinct(labels), 1);
+
+  // A single corner contact across the blocks also connects.
+  voxels = {GlobalIndex(-1, -1, -1), GlobalIndex(0, 0, 0),
+            GlobalIndex(15, 15, 15), GlobalIndex(16, 16, 16)};
+  EXPECT_EQ(clusterer.cluster(voxels, &labels), 2);
+  EXPECT_EQ(labels, std::vector<int>({0, 0, 1, 1}));
+}
+
+TEST(FrontierClustererTest, SeparatesClustersWithGaps) {
+  // A gap of one voxel separates the clusters, also across block borders.
+  const std::vector<GlobalIndex> voxels{
+      GlobalIndex(6, 0, 0), GlobalIndex(8, 0, 0), GlobalIndex(9, 1, 0),
+      GlobalIndex(-2, 0, 0), GlobalIndex(0, 0, 0)};
+  FrontierClusterer clusterer;
+  std::vector<int> labels;
+  EXPECT_EQ(clusterer.cluster(voxels, &labels), 4);
+  EXPECT_EQ(labels, std::vector<int>({0, 1, 1, 2, 3}));
+}
+
+TEST(FrontierClustererTest, JoinsLongChainsAndDuplicates) {
+  // A staircase through many blocks, visited in reverse order, and duplicates.
+  std::vector<GlobalIndex> voxels;
+  for (int i = 40; -40 <= i; --i) {
+    voxels.emplace_back(i, i / 2, -i);
+  }
+  voxels.emplace_back(voxels.front());
+  voxels.emplace_back(100, 100, 100);
+  voxels.emplace_back(100, 100, 100);
+  FrontierClusterer clusterer;
+  std::vector<int> labels;
+  EXPECT_EQ(clusterer.cluster(voxels, &labels), 2);
+  ASSERT_EQ(labels.size(), voxels.size());
+  for (size_t i = 0u; i < voxels.size() - 2u; ++i) {
+    EXPECT_EQ(labels[i], 0);
+  }
+  EXPECT_EQ(labels[voxels.size() - 2u], 1);
+  EXPECT_EQ(labels[voxels.size() - 1u], 1);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "glocal_exploration/utils/indexed_min_heap.h"
+
+using glocal_exploration::IndexedMinHeap;
+
+TEST(IndexedMinHeapTest, PopsInKeyOrder) {
+  IndexedMinHeap<float> heap;
+  EXPECT_TRUE(heap.empty());
+  const std::vector<float> keys{5.f, 1.f, 4.f, 2.f, 3.f, 0.5f};
+  for (size_t index = 0u; index < keys.size(); ++index) {
+    heap.push(index, keys[index]);
+  }
+  EXPECT_EQ(heap.size(), keys.size());
+  EXPECT_EQ(heap.top(), 5u);
+  EXPECT_EQ(heap.topKey(), 0.5f);
+
+  std::vector<size_t> popped;
+  while (!heap.empty()) {
+    popped.push_back(heap.pop());
+  }
+  EXPECT_EQ(popped, std::vector<size_t>({5u, 1u, 3u, 4u, 2u, 0u}));
+}
+
+TEST(IndexedMinHeapTest, DecreasesAndIncreasesKeys) {
+  IndexedMinHeap<float> heap;
+  heap.push(0u, 1.f);
+  heap.push(7u, 2.f);
+  heap.push(3u, 3.f);
+  EXPECT_FALSE(heap.contains(1u));
+  EXPECT_TRUE(heap.contains(7u));
+
+  // Decrease the key of a queued index, which moves it to the top
+  heap.push(3u, 0.f);
+  EXPECT_EQ(heap.size(), 3u);
+  EXPECT_EQ(heap.top(), 3u);
+  EXPECT_EQ(heap.topKey(), 0.f);
+
+  // Increase the key of the top, which moves it to the bottom
+  heap.push(3u, 10.f);
+  EXPECT_EQ(heap.size(), 3u);
+  EXPECT_EQ(heap.pop(), 0u);
+  EXPECT_EQ(heap.pop(), 7u);
+  EXPECT_EQ(heap.topKey(), 10.f);
+  EXPECT_EQ(heap.pop(), 3u);
+  EXPECT_TRUE(heap.empty());
+  EXPECT_FALSE(heap.contains(3u));
+}
+
+TEST(IndexedMinHeapTest, ClearsOnlyQueuedIndices) {
+  IndexedMinHeap<int> heap;
+  heap.push(2u, 2);
+  heap.push(100u, 1);
+  heap.clear();
+  EXPECT_TRUE(heap.empty());
+  EXPECT_FALSE(heap.contains(2u));
+  EXPECT_FALSE(heap.contains(100u));
+
+  // The heap can be reused after clearing
+  heap.push(100u, 3);
+  heap.push(2u, 4);
+  EXPECT_EQ(heap.pop(), 100u);
+  EXPECT_EQ(heap.pop(), 2u);
+}
+
+TEST(IndexedMinHeapTest, MatchesSortedOrderUnderRandomUpdates) {
+  // Interleave pushes, key updates and pops, and compare the popped keys to a
+  // reference that tracks the current key of every queued index.
+  std::mt19937 random_engine(42);
+  std::uniform_int_distribution<size_t> index_distribution(0u, 199u);
+  std::uniform_int_distribution<int> key_distribution(0, 1000);
+  IndexedMinHeap<int> heap;
+  std::vector<int> keys(200u, -1);  // -1 if the index is not queued.
+  for (int step = 0; step < 5000; ++step) {
+    if (step % 3 == 2 && !heap.empty()) {
+      const int min_key = *std::min_element(
+          keys.begin(), keys.end(), [](const int a, const int b) {
+            return 0 <= a && (b < 0 || a < b);
+          });
+      EXPECT_EQ(heap.topKey(), min_key);
+      const size_t index = heap.pop();
+      EXPECT_EQ(keys[index], min_key);
+      keys[index] = -1;
+    } else {
+      const size_t index = index_distribution(random_engine);
+      const int key = key_distribution(random_engine);
+      heap.push(index, key);
+      keys[index] = key;
+    }
+    EXPECT_EQ(heap.size(), static_cast<size_t>(std::count_if(
+                               keys.begin(), keys.end(),
+                               [](const int key) { return 0 <= key; })));
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,77 @@
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "glocal_exploration/utils/inline_vector.h"
+#include "glocal_exploration/utils/shared_view.h"
+
+using glocal_exploration::InlineVector;
+using glocal_exploration::SharedView;
+
+TEST(InlineVectorTest, StoresSmallListsInline) {
+  InlineVector<int, 4> vector;
+  EXPECT_TRUE(vector.empty());
+  EXPECT_EQ(vector.begin(), vector.end());
+  for (int i = 0; i < 4; ++i) {
+    vector.push_back(i);
+  }
+  EXPECT_TRUE(vector.isInline());
+  ASSERT_EQ(vector.size(), 4u);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(vector[i], i);
+  }
+  EXPECT_TRUE(vector.contains(3));
+  EXPECT_FALSE(vector.contains(4));
+}
+
+TEST(InlineVectorTest, FallsBackToTheHeapWhenFull) {
+  InlineVector<int, 4> vector({0, 1, 2, 3});
+  vector.push_back(4);
+  vector.push_back(5);
+  EXPECT_FALSE(vector.isInline());
+  EXPECT_EQ(std::vector<int>(vector.begin(), vector.end()),
+            std::vector<int>({0, 1, 2, 3, 4, 5}));
+
+  // Clearing returns to inline storage
+  vector.clear();
+  EXPECT_TRUE(vector.empty());
+  vector.push_back(7);
+  EXPECT_TRUE(vector.isInline());
+  EXPECT_EQ(vector[0], 7);
+}
+
+TEST(InlineVectorTest, CopiesAreIndependent) {
+  InlineVector<int, 2> vector({0, 1, 2});
+  InlineVector<int, 2> copy = vector;
+  vector.clear();
+  vector.push_back(5);
+  EXPECT_EQ(std::vector<int>(copy.begin(), copy.end()),
+            std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(std::vector<int>(vector.begin(), vector.end()),
+            std::vector<int>({5}));
+}
+
+TEST(SharedViewTest, KeepsTheContainerAlive) {
+  using IntList = InlineVector<int, 4>;
+  SharedView<IntList> empty_view;
+  EXPECT_TRUE(empty_view.empty());
+  EXPECT_EQ(empty_view.begin(), empty_view.end());
+
+  auto list = std::make_shared<IntList>(IntList({1, 2, 3}));
+  SharedView<IntList> view(list);
+  std::weak_ptr<IntList> weak_list = list;
+  list.reset();
+  ASSERT_FALSE(weak_list.expired());
+  EXPECT_EQ(view.size(), 3u);
+  EXPECT_EQ(view[2], 3);
+  EXPECT_EQ(std::vector<int>(view.begin(), view.end()),
+            std::vector<int>({1, 2, 3}));
+  view = SharedView<IntList>();
+  EXPECT_TRUE(weak_list.expired());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,107 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "glocal_exploration/utils/rcu_pointer.h"
+
+using glocal_exploration::RcuPointer;
+
+namespace {
+// Counts its live instances, s.t. the tests can check when versions are freed.
+struct Version {
+  explicit Version(int value, std::atomic<int>* num_alive)
+      : value(value), copy(value), num_alive(num_alive) {
+    ++*num_alive;
+  }
+  ~Version() { --*num_alive; }
+  int value;
+  int copy;  // Always equal to value while the version is alive.
+  std::atomic<int>* num_alive;
+};
+}  // namespace
+
+TEST(RcuPointerTest, ReadsTheLatestVersion) {
+  std::atomic<int> num_alive{0};
+  RcuPointer<Version> pointer;
+  EXPECT_FALSE(pointer.read());
+
+  pointer.publish(std::make_unique<Version>(1, &num_alive));
+  EXPECT_EQ(pointer.read()->value, 1);
+  pointer.publish(std::make_unique<Version>(2, &num_alive));
+  EXPECT_EQ(pointer.read()->value, 2);
+  // The previous version is freed once it was replaced
+  EXPECT_EQ(num_alive, 1);
+}
+
+TEST(RcuPointerTest, ExchangeReturnsThePreviousVersion) {
+  std::atomic<int> num_alive{0};
+  RcuPointer<Version> pointer(std::make_unique<Version>(1, &num_alive));
+  std::unique_ptr<Version> previous =
+      pointer.exchange(std::make_unique<Version>(2, &num_alive));
+  ASSERT_TRUE(previous);
+  EXPECT_EQ(previous->value, 1);
+  EXPECT_EQ(pointer.read()->value, 2);
+  EXPECT_EQ(num_alive, 2);
+}
+
+TEST(RcuPointerTest, PublishWaitsForReadersOfThePreviousVersion) {
+  std::atomic<int> num_alive{0};
+  RcuPointer<Version> pointer(std::make_unique<Version>(1, &num_alive));
+  auto guard = std::make_unique<RcuPointer<Version>::ReadGuard>(
+      pointer.read());
+
+  std::atomic<bool> published{false};
+  std::thread writer([&] {
+    pointer.publish(std::make_unique<Version>(2, &num_alive));
+    published = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(published);
+  EXPECT_EQ((*guard)->value, 1);
+
+  guard.reset();
+  writer.join();
+  EXPECT_TRUE(published);
+  EXPECT_EQ(pointer.read()->value, 2);
+  EXPECT_EQ(num_alive, 1);
+}
+
+TEST(RcuPointerTest, ConcurrentReadersNeverSeeFreedVersions) {
+  std::atomic<int> num_alive{0};
+  RcuPointer<Version> pointer(std::make_unique<Version>(0, &num_alive));
+  std::atomic<bool> stop{false};
+  std::atomic<int> num_errors{0};
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      int last_value = 0;
+      while (!stop) {
+        const auto version = pointer.read();
+        if (version->value != version->copy || version->value < last_value) {
+          ++num_errors;
+        }
+        last_value = version->value;
+      }
+    });
+  }
+  for (int value = 1; value <= 1000; ++value) {
+    pointer.publish(std::make_unique<Version>(value, &num_alive));
+  }
+  stop = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(num_errors, 0);
+  EXPECT_EQ(pointer.read()->value, 1000);
+  EXPECT_EQ(num_alive, 1);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
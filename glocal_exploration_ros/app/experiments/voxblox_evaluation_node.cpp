@@ -14,6 +14,7 @@
 #include <voxblox/io/layer_io.h>
 
 #include <glocal_exploration/state/region_of_interest.h>
+#include <glocal_exploration/utils/morton_order.h>
 
 namespace glocal_exploration {
 
@@ -155,9 +156,8 @@ std::string EvaluationNode::evaluateSingle(const std::string& map_name) {
 
   FloatingPoint volume = 0.f;
 
-  voxblox::BlockIndexList blocks;
-  tsdf_layer->getAllAllocatedBlocks(&blocks);
-  for (voxblox::BlockIndex& index : blocks) {
+  for (const voxblox::BlockIndex& index :
+       morton_order::getAllAllocatedBlocks(*tsdf_layer)) {
     // Iterate over all voxels in said blocks.
     voxblox::Block<voxblox::TsdfVoxel>& block =
         tsdf_layer->getBlockByIndex(index);
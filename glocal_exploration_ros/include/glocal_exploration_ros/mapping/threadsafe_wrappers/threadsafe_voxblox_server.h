@@ -1,21 +1,61 @@
 #ifndef GLOCAL_EXPLORATION_ROS_MAPPING_THREADSAFE_WRAPPERS_THREADSAFE_VOXBLOX_SERVER_H_
 #define GLOCAL_EXPLORATION_ROS_MAPPING_THREADSAFE_WRAPPERS_THREADSAFE_VOXBLOX_SERVER_H_
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
-#include <minkindr_conversions/kindr_msg.h>
 #include <voxblox_ros/esdf_server.h>
 #include <voxblox_ros/ros_params.h>
 
+#include <glocal_exploration/mapping/block_change_tracker.h>
+#include <glocal_exploration/mapping/block_summary_layer.h>
+#include <glocal_exploration/mapping/incremental_layer_snapshot.h>
+#include <glocal_exploration/mapping/voxel_state_layer.h>
+#include <glocal_exploration/planning/global/incremental_frontier_tracker.h>
+
 #include "glocal_exploration_ros/conversions/ros_node_handles.h"
 
 namespace glocal_exploration {
+/**
+ * Voxblox server that runs as a pipeline of three stages, s.t. pointcloud
+ * intake never waits for the ESDF:
+ *  1. The pointclouds are integrated into the TSDF on the server's callback
+ *     thread, which hands the changed TSDF blocks over to the ESDF stage.
+ *  2. The ESDF is propagated from these blocks on a separate thread.
+ *  3. That thread then publishes immutable snapshots of the updated maps.
+ * The base server's map publishers and services read the ESDF snapshot, and
+ * everything that writes to the ESDF runs on the ESDF stage's thread.
+ */
 class ThreadsafeVoxbloxServer : public voxblox::EsdfServer {
  public:
   using Function = std::function<void()>;
+  using PoseHistory = std::vector<geometry_msgs::PoseStamped>;
+
+  // Backlog and latency of one pipeline stage.
+  struct StageStats {
+    size_t queue_depth = 0u;  // See PipelineStats for what is being queued.
+    size_t num_runs = 0u;
+    double last_latency = 0.0;  // s
+    double mean_latency = 0.0;  // s
+    double max_latency = 0.0;   // s
+
+    void addRun(const double latency, const size_t new_queue_depth);
+  };
+  struct PipelineStats {
+    StageStats tsdf_integration;      // Pointclouds waiting for their pose.
+    StageStats esdf_propagation;      // Changed TSDF blocks.
+    StageStats snapshot_publication;  // ESDF blocks affected by the changes.
+    // Pointclouds that never reached the server, e.g. since the subscriber's
+    // queue overflowed, as inferred from gaps in their header sequence.
+    size_t num_dropped_pointclouds = 0u;
+  };
 
   template <typename... Args>
   ThreadsafeVoxbloxServer(const ros::NodeHandle& nh,
@@ -24,76 +64,215 @@ class ThreadsafeVoxbloxServer : public voxblox::EsdfServer {
             changeNodeHandleCallbackQueue(nh, &callback_queue_),
             changeNodeHandleCallbackQueue(nh_private, &callback_queue_),
             std::forward<Args>(args)...),
+        tsdf_snapshot_enabled_(false),
+        block_summaries_enabled_(false),
+        voxel_states_enabled_(false),
+        frontier_tracking_enabled_(false),
+        observed_space_changes_(esdf_map_->block_size()),
+        shutdown_esdf_stage_(false),
+        esdf_update_requested_(false),
+        esdf_batch_requested_(false),
+        esdf_batch_full_euclidean_(false),
+        esdf_input_requested_(false),
+        esdf_input_ready_(false),
         spinner_(1, &callback_queue_) {
-    // Set up the thread-safe ESDF map copy
-    safe_esdf_map_.reset(new voxblox::EsdfMap(
-        voxblox::getEsdfMapConfigFromRosParam(nh_private_)));
-    // Start processing callbacks
+    esdf_max_distance_ =
+        voxblox::getEsdfIntegratorConfigFromRosParam(nh_private_)
+            .max_distance_m;
+    // Start the ESDF stage and processing callbacks
+    setupEsdfStage();
     spinner_.start();
   }
+  ~ThreadsafeVoxbloxServer() override;
+
+  // Stage 1, which runs on the server's callback thread.
+  void insertPointcloud(
+      const sensor_msgs::PointCloud2::Ptr& pointcloud) override;
+  void newPoseCallback(const voxblox::Transformation& T_G_C) override;
 
-  // TODO(victorr): Also make sure all other thread-unsafe base class methods
-  //                are no longer accessible, and see if there's a cleaner
-  //                alternative to base method hiding.
+  // NOTE: The ESDF updates run asynchronously on the ESDF stage's thread, so
+  //       these only request an update.
+  void updateEsdf() override;
+  void updateEsdfBatch(bool full_euclidean = false) override;
+
+  // NOTE: The mutable ESDF map is the live map, which is written by the ESDF
+  //       stage's thread and may thus only be accessed from there. All other
+  //       threads read the immutable map that wraps the latest ESDF snapshot.
   std::shared_ptr<voxblox::EsdfMap> getEsdfMapPtr() override {
-    return safe_esdf_map_;
+    return esdf_map_;
   }
   std::shared_ptr<const voxblox::EsdfMap> getEsdfMapPtr() const override {
-    return safe_esdf_map_;
+    return getEsdfMapSnapshot();
+  }
+  std::shared_ptr<const voxblox::EsdfMap> getEsdfMapSnapshot() const {
+    return std::atomic_load(&published_esdf_map_);
   }
 
-  void updateEsdf() override {
-    voxblox::EsdfServer::updateEsdf();
-    *safe_esdf_map_->getEsdfLayerPtr() = esdf_map_->getEsdfLayer();
+  // The base server's map publication, which runs on the callback thread.
+  void publishMap(bool reset_remote_map = false) override;
+  void publishPointclouds() override;
+  void publishSlices() override;
+  bool saveMap(const std::string& file_path) override;
+  // NOTE: The TSDF is loaded and cleared right away, whereas the ESDF is loaded
+  //       and cleared by the ESDF stage once it finished its current update.
+  bool loadMap(const std::string& file_path) override;
+  void clear() override;
+  // NOTE: Hides the base server's service, which published the live ESDF.
+  bool generateEsdfCallback(std_srvs::Empty::Request& request,     // NOLINT
+                            std_srvs::Empty::Response& response);  // NOLINT
 
-    // Call the external callback, if it has been set
-    if (external_new_esdf_callback_) {
-      external_new_esdf_callback_();
-    }
+  void setExternalNewPoseCallback(Function callback) {
+    external_new_pose_callback_ = std::move(callback);
+  }
+  // The external ESDF callback runs on the ESDF stage's thread.
+  void setExternalNewEsdfCallback(Function callback) {
+    external_new_esdf_callback_ = std::move(callback);
   }
-  void updateEsdfBatch(bool full_euclidean = false) override {
-    voxblox::EsdfServer::updateEsdfBatch();
-    *safe_esdf_map_->getEsdfLayerPtr() = esdf_map_->getEsdfLayer();
 
-    // Call the external callback, if it has been set
-    if (external_new_esdf_callback_) {
-      external_new_esdf_callback_();
-    }
+  // Immutable copy of the ESDF layer, which is refreshed after every ESDF
+  // update. Returns nullptr until the first ESDF update.
+  IncrementalLayerSnapshot<voxblox::EsdfVoxel>::LayerConstPtr
+  getEsdfLayerSnapshot() const {
+    return esdf_snapshot_.get();
   }
 
-  void newPoseCallback(const voxblox::Transformation& T_G_C) override {
-    voxblox::EsdfServer::newPoseCallback(T_G_C);
+  // The TSDF snapshot is only maintained once it has been enabled, since the
+  // voxgraph map does not need it. It is refreshed together with the ESDF.
+  void enableTsdfLayerSnapshot() { tsdf_snapshot_enabled_ = true; }
+  IncrementalLayerSnapshot<voxblox::TsdfVoxel>::LayerConstPtr
+  getTsdfLayerSnapshot() const {
+    return tsdf_snapshot_.get();
+  }
 
-    // Call the external callback, if it has been set
-    if (external_new_pose_callback_) {
-      external_new_pose_callback_();
-    }
+  // Summaries of the ESDF blocks, which are maintained once they have been
+  // enabled. Returns nullptr until the first ESDF update.
+  void enableBlockSummaries() { block_summaries_enabled_ = true; }
+  BlockSummaryLayer::ConstPtr getBlockSummaries() const {
+    return std::atomic_load(&published_block_summaries_);
   }
 
-  void setExternalNewPoseCallback(Function callback) {
-    external_new_pose_callback_ = std::move(callback);
+  // Packed state of every ESDF voxel, which is maintained once it has been
+  // enabled. Returns nullptr until the first ESDF update.
+  void enableVoxelStateLayer() { voxel_states_enabled_ = true; }
+  VoxelStateLayer::ConstPtr getVoxelStateLayer() const {
+    return std::atomic_load(&published_voxel_states_);
   }
-  void setExternalNewEsdfCallback(Function callback) {
-    external_new_esdf_callback_ = std::move(callback);
+
+  // Frontier candidates of the TSDF, which are tracked once it has been
+  // enabled and updated together with the ESDF. Returns nullptr until the
+  // first ESDF update.
+  void enableFrontierTracking() { frontier_tracking_enabled_ = true; }
+  std::shared_ptr<const FrontierVoxelList> getFrontierCandidates() const {
+    return std::atomic_load(&published_frontier_candidates_);
+  }
+
+  // Poses of the pointclouds that are currently integrated, as of the last
+  // ESDF update.
+  PoseHistory getPoseHistory() const {
+    const std::shared_ptr<const PoseHistory> pose_history =
+        std::atomic_load(&published_pose_history_);
+    return pose_history ? *pose_history : PoseHistory();
+  }
+
+  // The ESDF blocks whose observed space changed since a given revision.
+  int addObservedSpaceChangesConsumer() {
+    return observed_space_changes_.addConsumer();
+  }
+  MapBase::ObservedSpaceChanges getBlocksChangedSince(const int consumer_id,
+                                                      const uint64_t revision) {
+    return observed_space_changes_.getChangesSince(consumer_id, revision);
+  }
+  // Lets users that overlay other maps report changes to these as well.
+  void markEverythingChanged() {
+    observed_space_changes_.markEverythingChanged();
   }
 
-  std::vector<geometry_msgs::PoseStamped> getPoseHistory() {
-    std::vector<geometry_msgs::PoseStamped> pose_history;
-    for (const auto& item : pointcloud_deintegration_queue_) {
-      geometry_msgs::PoseStamped pose_msg;
-      pose_msg.header.stamp = item.timestamp;
-      tf::poseKindrToMsg(item.T_G_C.cast<double>(), &pose_msg.pose);
-      pose_history.emplace_back(pose_msg);
-    }
-    return pose_history;
+  PipelineStats getPipelineStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
   }
 
  protected:
-  voxblox::EsdfMap::Ptr safe_esdf_map_;
+  using TsdfBlock = voxblox::Block<voxblox::TsdfVoxel>;
 
   Function external_new_pose_callback_;
   Function external_new_esdf_callback_;
 
+  // Immutable copies of the ESDF and TSDF layers that share unchanged blocks
+  // between updates.
+  IncrementalLayerSnapshot<voxblox::EsdfVoxel> esdf_snapshot_;
+  std::shared_ptr<const voxblox::EsdfMap> published_esdf_map_;
+  std::atomic<bool> tsdf_snapshot_enabled_;
+  IncrementalLayerSnapshot<voxblox::TsdfVoxel> tsdf_snapshot_;
+
+  // The summaries and voxel states are updated in place and published as
+  // immutable copies.
+  FloatingPoint esdf_max_distance_;
+  std::atomic<bool> block_summaries_enabled_;
+  std::unique_ptr<BlockSummaryLayer> block_summaries_;
+  BlockSummaryLayer::ConstPtr published_block_summaries_;
+  std::atomic<bool> voxel_states_enabled_;
+  std::unique_ptr<VoxelStateLayer> voxel_states_;
+  VoxelStateLayer::ConstPtr published_voxel_states_;
+  std::atomic<bool> frontier_tracking_enabled_;
+  std::unique_ptr<IncrementalFrontierTracker> frontier_tracker_;
+  std::shared_ptr<const FrontierVoxelList> published_frontier_candidates_;
+  std::shared_ptr<const PoseHistory> published_pose_history_;
+  BlockChangeTracker observed_space_changes_;
+
+  // Everything the integration stage hands over to the ESDF stage.
+  struct EsdfStageInput {
+    std::vector<std::pair<voxblox::BlockIndex, TsdfBlock::Ptr>> updated_blocks;
+    voxblox::BlockIndexList allocated_blocks;
+    std::vector<voxblox::Transformation> new_poses;
+    std::shared_ptr<const PoseHistory> pose_history;
+  };
+  // Only accessed by the integration stage.
+  std::vector<voxblox::Transformation> new_poses_;
+  int64_t last_pointcloud_seq_ = -1;  // None received yet if negative.
+  EsdfStageInput collectEsdfStageInput();
+  // Hand the TSDF changes over to the ESDF stage if it is waiting for them.
+  void handOverEsdfStageInput();
+
+  // The ESDF stage propagates the ESDF from its own copy of the TSDF, which
+  // it brings up to date with every input.
+  std::thread esdf_stage_thread_;
+  std::mutex esdf_stage_mutex_;
+  std::condition_variable esdf_stage_cv_;
+  bool shutdown_esdf_stage_;
+  bool esdf_update_requested_;
+  bool esdf_batch_requested_;
+  bool esdf_batch_full_euclidean_;
+  bool esdf_input_requested_;
+  bool esdf_input_ready_;
+  EsdfStageInput esdf_input_;
+  std::vector<Function> esdf_stage_tasks_;
+  double update_esdf_period_;  // s, no periodic updates if not positive.
+  std::unique_ptr<voxblox::Layer<voxblox::TsdfVoxel>> esdf_input_tsdf_layer_;
+  void setupEsdfStage();
+  void esdfStageLoop();
+  // Run a task on the ESDF stage's thread, in between two ESDF updates.
+  void runOnEsdfStage(Function task);
+  void runEsdfStage(EsdfStageInput input, const bool batch,
+                    const bool full_euclidean);
+
+  // Stage 3, which runs on the ESDF stage's thread.
+  void publishSnapshots(const voxblox::BlockIndexList& updated_tsdf_blocks,
+                        const voxblox::BlockIndexList& updated_esdf_blocks);
+  void updateEsdfLayerSummaries(
+      const voxblox::BlockIndexList& updated_esdf_blocks);
+  void updateFrontierCandidates(
+      const voxblox::BlockIndexList& updated_tsdf_blocks,
+      const voxblox::BlockIndexList& removed_tsdf_blocks);
+  // NOTE: Changes to the TSDF propagate through the ESDF up to its maximum
+  //       distance, so the updated TSDF blocks are dilated accordingly.
+  voxblox::BlockIndexList getEsdfBlocksAffectedBy(
+      const voxblox::BlockIndexList& updated_tsdf_blocks) const;
+  voxblox::BlockIndexList getAllEsdfBlocks() const;
+
+  mutable std::mutex stats_mutex_;
+  PipelineStats stats_;
+
   ros::CallbackQueue callback_queue_;
   ros::AsyncSpinner spinner_;
 };
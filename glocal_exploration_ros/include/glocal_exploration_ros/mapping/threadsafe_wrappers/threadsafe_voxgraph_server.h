@@ -1,6 +1,8 @@
 #ifndef GLOCAL_EXPLORATION_ROS_MAPPING_THREADSAFE_WRAPPERS_THREADSAFE_VOXGRAPH_SERVER_H_
 #define GLOCAL_EXPLORATION_ROS_MAPPING_THREADSAFE_WRAPPERS_THREADSAFE_VOXGRAPH_SERVER_H_
 
+#include <mutex>
+#include <shared_mutex>
 #include <utility>
 
 #include <voxgraph/frontend/voxgraph_mapper.h>
@@ -11,6 +13,7 @@ namespace glocal_exploration {
 class ThreadsafeVoxgraphServer : public voxgraph::VoxgraphMapper {
  public:
   using Function = std::function<void()>;
+  using SubmapCollectionLock = std::shared_lock<std::shared_mutex>;
 
   template <typename... Args>
   ThreadsafeVoxgraphServer(const ros::NodeHandle& nh,
@@ -26,8 +29,15 @@ class ThreadsafeVoxgraphServer : public voxgraph::VoxgraphMapper {
 
   bool submapCallback(
       const voxblox_msgs::LayerWithTrajectory& submap_msg) override {
-    const bool submap_added_successfully =
-        voxgraph::VoxgraphMapper::submapCallback(submap_msg);
+    bool submap_added_successfully;
+    {
+      std::unique_lock<std::shared_mutex> lock(submap_collection_mutex_);
+      submap_added_successfully =
+          voxgraph::VoxgraphMapper::submapCallback(submap_msg);
+    }
+
+    // NOTE: The external callback runs on this thread after the lock has been
+    //       released, since it does not add or remove any submaps.
 
     // Call the external callback, if it has been set
     if (submap_added_successfully && external_new_submap_callback_) {
@@ -37,12 +47,19 @@ class ThreadsafeVoxgraphServer : public voxgraph::VoxgraphMapper {
     return submap_added_successfully;
   }
 
+  // Threads other than this server's must hold this lock while accessing the
+  // submap collection, which voxgraph modifies when adding a new submap.
+  SubmapCollectionLock lockSubmapCollection() const {
+    return SubmapCollectionLock(submap_collection_mutex_);
+  }
+
   void setExternalNewSubmapCallback(Function callback) {
     external_new_submap_callback_ = std::move(callback);
   }
 
  protected:
   Function external_new_submap_callback_;
+  mutable std::shared_mutex submap_collection_mutex_;
 
   ros::CallbackQueue callback_queue_;
   ros::AsyncSpinner spinner_;
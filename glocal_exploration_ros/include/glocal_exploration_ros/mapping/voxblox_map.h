@@ -6,6 +6,7 @@
 #include <vector>
 
 #include <glocal_exploration/3rd_party/config_utilities.hpp>
+#include <glocal_exploration/mapping/esdf_interpolator.h>
 #include <glocal_exploration/mapping/map_base.h>
 
 #include "glocal_exploration_ros/mapping/threadsafe_wrappers/threadsafe_voxblox_server.h"
@@ -21,6 +22,9 @@ class VoxbloxMap : public MapBase {
     std::string nh_private_namespace = "~";
     FloatingPoint traversability_radius = 0.3f;  // m
     FloatingPoint clearing_radius = 0.5f;        // m
+    bool use_block_summaries = true;
+    bool use_voxel_state_layer = true;
+    bool use_frontier_tracking = true;  // Instead of sweeping for frontiers.
 
     Config();
     void checkParams() const override;
@@ -68,11 +72,22 @@ class VoxbloxMap : public MapBase {
   Point getVoxelCenterInLocalArea(const Point& position) const override {
     return (position / c_voxel_size_).array().round() * c_voxel_size_;
   }
+  BlockSummaryLayer::ConstPtr getBlockSummaryOfActiveSubmap() const override {
+    return server_->getBlockSummaries();
+  }
 
   /* Global planner */
   // Since map is monolithic global = local.
   bool isObservedInGlobalMap(const Point& position) override {
-    return server_->getEsdfMapPtr()->isObserved(position.cast<double>());
+    const auto esdf_layer = server_->getEsdfLayerSnapshot();
+    return esdf_layer && EsdfInterpolator(*esdf_layer).isObserved(position);
+  }
+  int addObservedSpaceChangesConsumer() override {
+    return server_->addObservedSpaceChangesConsumer();
+  }
+  ObservedSpaceChanges getBlocksChangedSince(const int consumer_id,
+                                             const uint64_t revision) override {
+    return server_->getBlocksChangedSince(consumer_id, revision);
   }
   bool isTraversableInGlobalMap(
       const Point& position,
@@ -95,9 +110,11 @@ class VoxbloxMap : public MapBase {
     return getDistanceInActiveSubmap(position, distance);
   }
 
-  std::vector<SubmapId> getSubmapIdsAtPosition(
+  SubmapIdListView getSubmapIdsAtPosition(
       const Point& position) const override {
-    return std::vector<SubmapId>({0u});
+    static const SubmapIdListView kActiveSubmapIds(
+        std::make_shared<const SubmapIdList>(SubmapIdList({0u})));
+    return kActiveSubmapIds;
   }
   std::vector<SubmapData> getAllSubmapData() override;
 
@@ -0,0 +1,55 @@
+#ifndef GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_COMPACT_SUBMAP_STORE_H_
+#define GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_COMPACT_SUBMAP_STORE_H_
+
+#include <unordered_map>
+
+#include <voxgraph/frontend/submap_collection/voxgraph_submap_collection.h>
+
+#include <glocal_exploration/common.h>
+#include <glocal_exploration/mapping/compact_submap_layer.h>
+#include <glocal_exploration/utils/rcu_pointer.h>
+
+namespace glocal_exploration {
+/**
+ * Holds a compact copy of every finished voxgraph submap, which the global
+ * planner queries instead of the submap's full precision layers.
+ * NOTE: This is a cache that speeds up the lookups, not a memory reduction.
+ *       Voxgraph keeps the full precision layers of all submaps to register
+ *       new submaps against them, so the copies add to the map's footprint.
+ */
+class VoxgraphCompactSubmapStore {
+ public:
+  using CompactSubmapLayers =
+      std::unordered_map<voxgraph::SubmapID, CompactSubmapLayer::ConstPtr>;
+
+  explicit VoxgraphCompactSubmapStore(const FloatingPoint max_distance)
+      : max_distance_(max_distance),
+        compact_memory_usage_(0u),
+        full_memory_usage_(0u) {}
+
+  // Compact the submaps that were added since the last call. Must always be
+  // called from the same thread.
+  void update(const voxgraph::VoxgraphSubmapCollection& submap_collection);
+
+  // Lock-free, returns nullptr if the submap has not been compacted yet.
+  CompactSubmapLayer::ConstPtr getLayer(
+      const voxgraph::SubmapID submap_id) const {
+    const auto layers = layers_.read();
+    if (!layers) {
+      return nullptr;
+    }
+    const auto layer_it = layers->find(submap_id);
+    return layer_it != layers->end() ? layer_it->second : nullptr;
+  }
+
+ private:
+  const FloatingPoint max_distance_;
+  RcuPointer<CompactSubmapLayers> layers_;
+
+  // Statistics, only accessed by the thread calling update(...).
+  size_t compact_memory_usage_;
+  size_t full_memory_usage_;  // Of the compacted submaps' voxgraph layers.
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_COMPACT_SUBMAP_STORE_H_
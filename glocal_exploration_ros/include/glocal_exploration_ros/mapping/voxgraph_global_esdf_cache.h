@@ -0,0 +1,109 @@
+#ifndef GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_GLOBAL_ESDF_CACHE_H_
+#define GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_GLOBAL_ESDF_CACHE_H_
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <voxblox/core/esdf_map.h>
+#include <voxgraph/common.h>
+#include <voxgraph/frontend/submap_collection/voxgraph_submap_collection.h>
+
+#include <glocal_exploration/common.h>
+#include <glocal_exploration/utils/frame_transformer.h>
+
+#include "glocal_exploration_ros/mapping/voxgraph_compact_submap_store.h"
+#include "glocal_exploration_ros/mapping/voxgraph_spatial_hash.h"
+
+namespace glocal_exploration {
+/**
+ * Block-sparse cache of the minimum ESDF distance over all global submaps,
+ * expressed in a fixed frame. Blocks are computed lazily the first time they
+ * are queried and invalidated individually when the submaps that overlap with
+ * them are added or move. Once the cache holds more than the given number of
+ * blocks, the least recently queried ones are dropped.
+ */
+class VoxgraphGlobalEsdfCache {
+ public:
+  using SubmapId = voxgraph::SubmapID;
+  using EsdfVoxel = voxblox::EsdfVoxel;
+
+  VoxgraphGlobalEsdfCache(
+      const voxblox::EsdfMap::Config& config,
+      const FloatingPoint submap_pose_rotation_threshold,
+      const size_t max_num_cached_blocks,
+      const VoxgraphCompactSubmapStore* compact_submap_store = nullptr)
+      : cache_layer_(config.esdf_voxel_size, config.esdf_voxels_per_side),
+        max_num_cached_blocks_(max_num_cached_blocks),
+        fixed_frame_transformer_("submap_0"),
+        compact_submap_store_(compact_submap_store),
+        submap_pose_rotation_threshold_(submap_pose_rotation_threshold) {}
+
+  // Invalidate all cached blocks that are affected by new or moved submaps.
+  void update(const voxgraph::VoxgraphSubmapCollection& submap_collection);
+
+  // Get the minimum distance over all submaps at the given odom frame
+  // position. Returns false if the position is not observed in any submap.
+  bool getDistanceAtPosition(
+      const Point& position,
+      const voxgraph::VoxgraphSubmapCollection& submap_collection,
+      const VoxgraphSpatialHash& spatial_submap_id_hash,
+      FloatingPoint* distance);
+
+  size_t getNumberOfCachedBlocks() const {
+    std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+    return cache_layer_.getNumberOfAllocatedBlocks();
+  }
+
+ protected:
+  // The pose each submap had when it was last used to compute cache blocks,
+  // and the cache blocks it could have contributed to.
+  std::unordered_map<SubmapId, Transformation> submap_poses_;
+  std::unordered_map<SubmapId, voxblox::IndexSet> submap_cache_blocks_;
+  // The submaps each cache block was computed from, s.t. dropping a block
+  // removes it from all of the above sets, and the block's position in the
+  // least recently used order.
+  struct CacheBlockInfo {
+    std::vector<SubmapId> submap_ids;
+    std::list<voxblox::BlockIndex>::iterator lru_it;
+  };
+  voxblox::AnyIndexHashMapType<CacheBlockInfo>::type cache_block_infos_;
+  std::list<voxblox::BlockIndex> lru_cache_blocks_;  // Most recent first.
+
+  // The allocated blocks of each submap, s.t. its footprint does not have to
+  // be recomputed whenever it moves.
+  struct SubmapFootprint {
+    FloatingPoint block_size;
+    voxblox::BlockIndexList blocks;
+  };
+  std::unordered_map<SubmapId, SubmapFootprint> submap_footprints_;
+
+  voxblox::Layer<EsdfVoxel> cache_layer_;
+  const size_t max_num_cached_blocks_;
+  mutable std::mutex cache_mutex_;
+
+  FrameTransformer fixed_frame_transformer_;
+  const VoxgraphCompactSubmapStore* compact_submap_store_;
+
+  // Distance of the submap voxel nearest to the position.
+  // NOTE: The submap's compact layer is used instead of its ESDF if given.
+  bool getSubmapDistance(const voxgraph::VoxgraphSubmap& submap,
+                         const CompactSubmapLayer* compact_layer,
+                         const Point& t_submap_position,
+                         FloatingPoint* distance) const;
+  void computeBlock(const voxblox::BlockIndex& block_index,
+                    const voxgraph::VoxgraphSubmapCollection& submap_collection,
+                    const VoxgraphSpatialHash& spatial_submap_id_hash);
+  void removeCacheBlock(const voxblox::BlockIndex& block_index);
+  void evictLeastRecentlyUsedBlocks();
+  void invalidateBlocksInFootprint(const Transformation& T_F_submap,
+                                   const SubmapFootprint& submap_footprint);
+
+  const FloatingPoint submap_pose_rotation_threshold_;  // rad
+  bool submapPoseChanged(const Transformation& T_F_submap_old,
+                         const Transformation& T_F_submap_new) const;
+};
+}  // namespace glocal_exploration
+
+#endif  // GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_GLOBAL_ESDF_CACHE_H_
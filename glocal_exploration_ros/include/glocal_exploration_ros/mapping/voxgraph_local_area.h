@@ -1,16 +1,21 @@
 #ifndef GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_LOCAL_AREA_H_
 #define GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_LOCAL_AREA_H_
 
+#include <functional>
 #include <limits>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <voxgraph/common.h>
 #include <voxgraph/frontend/submap_collection/voxgraph_submap_collection.h>
 
 #include <glocal_exploration/mapping/map_base.h>
+#include <glocal_exploration/mapping/voxel_state_layer.h>
 #include <glocal_exploration/utils/frame_transformer.h>
+#include <glocal_exploration/utils/thread_pool.h>
 
 #include "glocal_exploration_ros/mapping/voxgraph_spatial_hash.h"
 
@@ -24,36 +29,93 @@ class VoxgraphLocalArea {
   using VoxelState = MapBase::VoxelState;
   using SubmapIdSet = std::set<SubmapId>;
 
-  explicit VoxgraphLocalArea(const voxblox::TsdfMap::Config& config)
+  // NOTE: The integration thread pool can be shared with other local areas,
+  //       as long as they are not updated at the same time. Without a pool,
+  //       the calling thread does all the work.
+  VoxgraphLocalArea(const voxblox::TsdfMap::Config& config,
+                    ThreadPool* integration_thread_pool,
+                    const FloatingPoint submap_pose_rotation_threshold,
+                    const bool use_voxel_state_layer = true)
       : local_area_layer_(config.tsdf_voxel_size, config.tsdf_voxels_per_side),
-        fixed_frame_transformer_("submap_0") {}
+        use_voxel_state_layer_(use_voxel_state_layer),
+        voxel_states_(config.tsdf_voxel_size, config.tsdf_voxels_per_side),
+        fixed_frame_transformer_("submap_0"),
+        integration_thread_pool_(integration_thread_pool),
+        submap_pose_rotation_threshold_(submap_pose_rotation_threshold) {}
 
+  // NOTE: The local map is passed as the list of its allocated blocks, s.t.
+  //       the update does not need to access the local map itself.
   void update(const voxgraph::VoxgraphSubmapCollection& submap_collection,
               const VoxgraphSpatialHash& spatial_submap_id_hash,
-              const voxblox::EsdfMap& local_map);
-  void prune();
+              const voxblox::BlockIndexList& local_map_block_list,
+              const FloatingPoint local_map_block_size);
 
-  VoxelState getVoxelStateAtPosition(const Point& position);
-  bool isObserved(const Point& position);
+  VoxelState getVoxelStateAtPosition(const Point& position) const;
+  bool isObserved(const Point& position) const;
   bool isValidAtPosition(const Point& position);
 
-  void publishLocalArea(ros::Publisher local_area_pub);
+  void publishLocalArea(ros::Publisher local_area_pub) const;
 
  protected:
   static constexpr FloatingPoint kTsdfObservedWeight = 1e-3;
 
-  std::unordered_map<SubmapId, Transformation> submaps_in_local_area_;
+  struct IntegratedSubmap {
+    Transformation T_F_submap;
+    // The submap resampled into the fixed frame, restricted to the local
+    // area's footprint. Kept s.t. the submap can be deintegrated without
+    // resampling it again.
+    std::unique_ptr<voxblox::Layer<TsdfVoxel>> resampled_tsdf;
+  };
+  std::unordered_map<SubmapId, IntegratedSubmap> submaps_in_local_area_;
   voxblox::Layer<TsdfVoxel> local_area_layer_;
 
+  // Packed state of the local area's voxels, which is refreshed for all blocks
+  // that changed at the end of every update. Only maintained if enabled,
+  // otherwise the voxel states are looked up in the TSDF.
+  const bool use_voxel_state_layer_;
+  VoxelStateLayer voxel_states_;
+  voxblox::IndexSet changed_blocks_;
+  void updateVoxelStates();
+
+  // The local area blocks that overlap with the local map
+  voxblox::IndexSet footprint_;
+
+  // Number of observed voxels in each local area block. Blocks are released
+  // as soon as their count drops to zero, s.t. all allocated blocks contain
+  // observed voxels.
+  voxblox::AnyIndexHashMapType<int>::type observed_voxel_counts_;
+  void updateObservedVoxelCount(const voxblox::BlockIndex& block_index,
+                                const int observed_voxel_delta);
+
   FrameTransformer fixed_frame_transformer_;
 
-  void deintegrateSubmap(const SubmapId submap_id,
-                         const voxblox::Layer<TsdfVoxel>& submap_tsdf);
-  void integrateSubmap(const SubmapId submap_id,
-                       const Transformation& T_F_submap,
-                       const voxblox::Layer<TsdfVoxel>& submap_tsdf,
-                       bool deintegrate = false);
+  // Maps local area blocks to the submaps that should be merged into them
+  using IntegrationJobs =
+      voxblox::AnyIndexHashMapType<std::vector<SubmapId>>::type;
+  void addIntegrationJobs(const SubmapId submap_id,
+                          const Transformation& T_F_submap,
+                          const voxblox::Layer<TsdfVoxel>& submap_tsdf,
+                          const voxblox::IndexSet& target_blocks,
+                          IntegrationJobs* integration_jobs) const;
+  void integrateSubmaps(
+      const voxgraph::VoxgraphSubmapCollection& submap_collection,
+      const IntegrationJobs& integration_jobs);
+  void deintegrateSubmaps(const SubmapIdSet& submap_ids);
+
+  // Returns the change in the local area block's number of observed voxels
+  static int mergeBlock(const voxblox::Block<TsdfVoxel>& submap_block,
+                        const bool deintegrate,
+                        voxblox::Block<TsdfVoxel>* local_area_block);
+  void addBlocksInBox(const Point& t_F_box_center,
+                      const Point& aabb_half_extent,
+                      voxblox::IndexSet* block_indices) const;
+
+  // Run the job for all indices in [0, num_jobs) on the integration threads
+  ThreadPool* const integration_thread_pool_;
+  void parallelFor(size_t num_jobs,
+                   const std::function<void(size_t)>& job) const;
 
+  const FloatingPoint submap_pose_rotation_threshold_;  // rad
   bool submapPoseChanged(const SubmapId submap_id,
                          const Transformation& T_F_submap_new);
 };
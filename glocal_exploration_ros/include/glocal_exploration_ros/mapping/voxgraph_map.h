@@ -1,15 +1,25 @@
 #ifndef GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_MAP_H_
 #define GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_MAP_H_
 
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <glocal_exploration/3rd_party/config_utilities.hpp>
+#include <glocal_exploration/mapping/esdf_interpolator.h>
 #include <glocal_exploration/mapping/map_base.h>
+#include <glocal_exploration/utils/rcu_pointer.h>
+#include <glocal_exploration/utils/thread_pool.h>
 
 #include "glocal_exploration_ros/mapping/threadsafe_wrappers/threadsafe_voxblox_server.h"
 #include "glocal_exploration_ros/mapping/threadsafe_wrappers/threadsafe_voxgraph_server.h"
+#include "glocal_exploration_ros/mapping/voxgraph_compact_submap_store.h"
+#include "glocal_exploration_ros/mapping/voxgraph_global_esdf_cache.h"
 #include "glocal_exploration_ros/mapping/voxgraph_local_area.h"
 #include "glocal_exploration_ros/mapping/voxgraph_spatial_hash.h"
 
@@ -24,6 +34,21 @@ class VoxgraphMap : public MapBase {
     std::string nh_private_namespace = "~";
     FloatingPoint traversability_radius = 0.3f;  // m
     FloatingPoint clearing_radius = 0.5f;        // m
+    FloatingPoint spatial_hash_resolution = 1.6f;  // m
+    bool use_global_esdf_cache = true;
+    int global_esdf_cache_max_num_blocks = 1000;  // Least recently used go.
+    // Quantized copies of the finished submaps for faster global lookups,
+    // kept in addition to voxgraph's layers.
+    bool use_compact_submap_layers = true;
+    FloatingPoint compact_submap_max_distance = 2.f;  // m
+    int local_area_num_threads = 4;
+    int global_query_num_threads = 4;  // Batched queries, 1: no threading.
+    bool use_block_summaries = true;
+    bool use_voxel_state_layer = true;
+    bool use_frontier_tracking = true;  // Frontiers of the active submap.
+    // Submaps that rotated less than this are not treated as moved by the
+    // observed space tracking, local area and global ESDF cache.
+    FloatingPoint submap_pose_rotation_threshold = 0.0523599f;  // rad
     int verbosity = 1;
 
     Config();
@@ -34,7 +59,7 @@ class VoxgraphMap : public MapBase {
 
   explicit VoxgraphMap(const Config& config,
                        const std::shared_ptr<Communicator>& communicator);
-  ~VoxgraphMap() override = default;
+  ~VoxgraphMap() override;
 
   /* General and Accessors */
   FloatingPoint getVoxelSize() const override { return c_voxel_size_; }
@@ -70,9 +95,23 @@ class VoxgraphMap : public MapBase {
     return (position / c_voxel_size_).array().round() * c_voxel_size_;
   }
   VoxelState getVoxelStateInLocalArea(const Point& position) override;
+  BlockSummaryLayer::ConstPtr getBlockSummaryOfActiveSubmap() const override {
+    return voxblox_server_->getBlockSummaries();
+  }
 
   /* Global planner */
   bool isObservedInGlobalMap(const Point& position) override;
+  void areObservedInGlobalMap(const std::vector<Point>& positions,
+                              std::vector<bool>* is_observed) override;
+  // NOTE: Changes are tracked in blocks of the active submap. If finished
+  //       submaps move, everything is reported as changed.
+  int addObservedSpaceChangesConsumer() override {
+    return voxblox_server_->addObservedSpaceChangesConsumer();
+  }
+  ObservedSpaceChanges getBlocksChangedSince(const int consumer_id,
+                                             const uint64_t revision) override {
+    return voxblox_server_->getBlocksChangedSince(consumer_id, revision);
+  }
   bool isTraversableInGlobalMap(
       const Point& position,
       const FloatingPoint traversability_radius) override;
@@ -91,7 +130,7 @@ class VoxgraphMap : public MapBase {
   bool getDistanceInGlobalMap(const Point& position,
                               FloatingPoint* min_esdf_distance);
 
-  std::vector<voxgraph::SubmapID> getSubmapIdsAtPosition(
+  SubmapIdListView getSubmapIdsAtPosition(
       const Point& position) const override {
     return voxgraph_spatial_hash_.getSubmapsAtPosition(position);
   }
@@ -103,21 +142,77 @@ class VoxgraphMap : public MapBase {
   std::unique_ptr<ThreadsafeVoxbloxServer> voxblox_server_;
   std::unique_ptr<ThreadsafeVoxgraphServer> voxgraph_server_;
 
-  std::unique_ptr<VoxgraphLocalArea> local_area_;
+  // The local area is maintained by a background worker, which updates the
+  // back buffer while the planners read the front buffer and then swaps them.
+  // Queries therefore never wait for an integration pass.
+  // NOTE: Both buffers share the persistent integration threads, which are
+  //       only set if enabled.
+  std::unique_ptr<ThreadPool> local_area_thread_pool_;
+  RcuPointer<VoxgraphLocalArea> local_area_;
+  std::unique_ptr<VoxgraphLocalArea> local_area_back_buffer_;
+  std::thread local_area_worker_;
+  std::mutex local_area_worker_mutex_;
+  std::condition_variable local_area_worker_cv_;
   bool local_area_needs_update_;
-  void updateLocalAreaIfNeeded();
-  static constexpr FloatingPoint local_area_pruning_period_s_ = 10.f;
-  ros::Timer local_area_pruning_timer_;
+  bool shutdown_local_area_worker_;
+  voxblox::BlockIndexList local_map_blocks_;
+  void localAreaWorkerLoop();
   ros::Publisher local_area_pub_;
 
   VoxgraphSpatialHash voxgraph_spatial_hash_;
   ros::Publisher voxgraph_spatial_hash_pub_;
 
+  // The submap poses as of the last reported change of the observed space.
+  std::unordered_map<voxgraph::SubmapID, Transformation>
+      observed_space_submap_poses_;
+  void reportMovedSubmaps();
+
+  // Compact copies of the finished submaps, only set if enabled.
+  std::unique_ptr<VoxgraphCompactSubmapStore> compact_submap_store_;
+
+  // Summaries of the finished submaps' ESDF blocks, only set if enabled.
+  using SubmapBlockSummaries =
+      std::unordered_map<voxgraph::SubmapID, BlockSummaryLayer::ConstPtr>;
+  RcuPointer<SubmapBlockSummaries> submap_block_summaries_;
+  void updateSubmapBlockSummaries();
+  BlockSummaryLayer::ConstPtr getSubmapBlockSummary(
+      const voxgraph::SubmapID submap_id) const;
+
+  // Held by all threads other than the voxgraph server's while they access
+  // the submaps, s.t. voxgraph can not add submaps in the meantime.
+  ThreadsafeVoxgraphServer::SubmapCollectionLock lockSubmaps() const {
+    return voxgraph_server_->lockSubmapCollection();
+  }
+  bool getDistanceInSubmap(const voxgraph::VoxgraphSubmap& submap,
+                           const Point& t_submap_position,
+                           FloatingPoint* distance) const;
+  bool isObservedInSubmap(const voxgraph::VoxgraphSubmap& submap,
+                          const Point& t_submap_position) const;
+
+  // Batched queries process the positions in the same block together, and
+  // the blocks in parallel if enabled.
+  std::unique_ptr<ThreadPool> global_query_thread_pool_;
+  void areObservedInGlobalMapBlock(
+      const voxblox::BlockIndex& block_index,
+      const std::vector<size_t>& position_indices,
+      const std::vector<Point>& positions,
+      const EsdfInterpolator* active_submap_esdf,
+      std::vector<uint8_t>* is_observed);
+
+  // Merged minimum distance over all submaps, only set if enabled.
+  std::unique_ptr<VoxgraphGlobalEsdfCache> global_esdf_cache_;
+
+  // Get a handle to a finished submap's TSDF layer without copying it.
+  static TsdfLayerConstPtr getTsdfLayerHandle(
+      const voxgraph::VoxgraphSubmap::ConstPtr& submap_ptr);
+
   // cached constants
   FloatingPoint c_block_size_;
   FloatingPoint c_voxel_size_;
 
   static constexpr FloatingPoint kMaxLineTraversabilityCheckLength = 1e2;
+  // Id under which the active submap is handed to the global planner.
+  static constexpr int kActiveSubmapId = -1;
 };
 
 }  // namespace glocal_exploration
@@ -1,6 +1,9 @@
 #ifndef GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_SPATIAL_HASH_H_
 #define GLOCAL_EXPLORATION_ROS_MAPPING_VOXGRAPH_SPATIAL_HASH_H_
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -11,6 +14,7 @@
 
 #include <glocal_exploration/common.h>
 #include <glocal_exploration/utils/frame_transformer.h>
+#include <glocal_exploration/utils/rcu_pointer.h>
 #include <glocal_exploration/utils/set_utils.h>
 
 namespace glocal_exploration {
@@ -22,49 +26,122 @@ class VoxgraphSpatialHash {
   using SpatialSubmapIdHash =
       voxblox::AnyIndexHashMapType<UnorderedSubmapIdSet>::type;
 
-  VoxgraphSpatialHash() : fixed_frame_transformer_("submap_0") {}
+  // Immutable version of the hash that is shared with the readers. The cells
+  // are grouped in chunks of kChunkSize^3 cells, which are shared between
+  // versions s.t. publishing a version only copies the chunks that changed.
+  using CellPtr = std::shared_ptr<const SubmapIdList>;
+  using Chunk = voxblox::AnyIndexHashMapType<CellPtr>::type;
+  static constexpr int kChunkSize = 8;
+  struct Snapshot {
+    explicit Snapshot(const FrameTransformer& fixed_frame_transformer)
+        : fixed_frame_transformer(fixed_frame_transformer) {}
+    FrameTransformer fixed_frame_transformer;
+    voxblox::AnyIndexHashMapType<std::shared_ptr<const Chunk>>::type chunks;
 
-  std::vector<voxgraph::SubmapID> getSubmapsAtPosition(
-      const Point& position) const {
+    // Returns nullptr if no submap overlaps with the cell.
+    const CellPtr* findCell(const voxblox::BlockIndex& cell_index) const;
+  };
+
+  explicit VoxgraphSpatialHash(const FloatingPoint resolution = 1.6f)
+      : fixed_frame_transformer_("submap_0"),
+        block_grid_size_(resolution),
+        block_grid_size_inv_(1.f / resolution),
+        num_queries_(0u),
+        num_candidates_(0u) {}
+
+  // NOTE: Lookups are lock-free and never allocate. The returned view shares
+  //       the cell's submap ID list with the snapshot it was read from.
+  SubmapIdListView getSubmapsAtPosition(const Point& position) const {
+    const auto snapshot = snapshot_.read();
+    if (!snapshot) {
+      return SubmapIdListView();
+    }
     const voxblox::Point t_F_block =
-        fixed_frame_transformer_.transformFromOdomToFixedFrame(position);
+        snapshot->fixed_frame_transformer.transformFromOdomToFixedFrame(
+            position);
     const auto mission_block_index =
         voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
             t_F_block, block_grid_size_inv_);
-    if (spatial_submap_id_hash_.count(mission_block_index)) {
-      std::lock_guard<std::mutex> spatial_hash_lock(spatial_hash_mutex_);
-      const UnorderedSubmapIdSet& submap_id_set =
-          spatial_submap_id_hash_.at(mission_block_index);
-      std::vector<voxgraph::SubmapID> submap_id_vector(submap_id_set.begin(),
-                                                       submap_id_set.end());
-      return submap_id_vector;
+    const CellPtr* cell = snapshot->findCell(mission_block_index);
+    num_queries_.fetch_add(1u, std::memory_order_relaxed);
+    if (cell) {
+      num_candidates_.fetch_add((*cell)->size(), std::memory_order_relaxed);
+      return SubmapIdListView(*cell);
     } else {
-      return std::vector<voxgraph::SubmapID>();
+      return SubmapIdListView();
+    }
+  }
+
+  // Average number of candidate submaps returned by getSubmapsAtPosition(...)
+  FloatingPoint getAverageCandidatesPerQuery() const {
+    const uint64_t num_queries = num_queries_;
+    if (num_queries == 0u) {
+      return 0.f;
     }
+    return static_cast<FloatingPoint>(num_candidates_) / num_queries;
   }
 
+  // Get all submaps whose hash cells overlap with the axis aligned bounding
+  // box of the sphere with the given radius around the position.
+  // NOTE: The result is a conservative superset, not all returned submaps
+  //       necessarily contain observed voxels within the radius.
+  std::vector<voxgraph::SubmapID> getSubmapsNearPosition(
+      const Point& position, const FloatingPoint radius) const;
+
   void update(const voxgraph::VoxgraphSubmapCollection& submap_collection);
 
   void publishSpatialHash(ros::Publisher spatial_hash_pub);
 
  private:
+  // The writer side state, which is only accessed from the thread calling
+  // update(...).
   SpatialSubmapIdHash spatial_submap_id_hash_;
   std::unordered_map<voxgraph::SubmapID, voxgraph::Transformation>
       submaps_in_spatial_hash_;
-  mutable std::mutex spatial_hash_mutex_;
-
+  // The observed part of each submap block, in submap frame. Since submaps are
+  // frozen these only need to be computed once.
+  struct ObservedBox {
+    voxblox::Point t_submap_min;
+    voxblox::Point t_submap_max;
+  };
+  std::unordered_map<voxgraph::SubmapID, std::vector<ObservedBox>>
+      submap_observed_boxes_;
   FrameTransformer fixed_frame_transformer_;
+  // The cells that changed since the last published version.
+  voxblox::IndexSet changed_cells_;
+
+  // The latest published version
+  RcuPointer<Snapshot> snapshot_;
+  void publishSnapshot();
+  static voxblox::BlockIndex getChunkIndex(
+      const voxblox::BlockIndex& cell_index);
 
-  const float block_grid_size_ = 3.2;
-  const float block_grid_size_inv_ = 1.f / block_grid_size_;
+  // Edge length of the hash cells
+  const float block_grid_size_;
+  const float block_grid_size_inv_;
 
-  void removeSubmap(const voxgraph::SubmapID submap_id,
-                    const voxblox::Layer<voxblox::TsdfVoxel>& submap_tsdf);
+  // Statistics to monitor how well the hash prunes the candidate submaps
+  mutable std::atomic<uint64_t> num_queries_;
+  mutable std::atomic<uint64_t> num_candidates_;
+
+  void removeSubmap(const voxgraph::SubmapID submap_id);
   void addSubmap(const voxgraph::SubmapID submap_id,
                  const voxgraph::Transformation& T_F_submap,
-                 const voxblox::Layer<voxblox::TsdfVoxel>& submap_tsdf,
                  const bool remove = false);
 
+  static std::vector<ObservedBox> computeObservedBoxes(
+      const voxblox::Layer<voxblox::TsdfVoxel>& submap_tsdf);
+
+  static bool getObservedBoundingBox(
+      const voxblox::Block<voxblox::TsdfVoxel>& block,
+      voxblox::Point* t_submap_observed_min,
+      voxblox::Point* t_submap_observed_max);
+  bool orientedBoxOverlapsCell(
+      const voxblox::Point& t_F_box_center,
+      const voxblox::Point& box_half_extent,
+      const Eigen::Matrix<FloatingPoint, 3, 3>& R_F_box,
+      const voxblox::Point& t_F_cell_center) const;
+
   bool submapPoseChanged(const voxgraph::SubmapID submap_id,
                          const voxgraph::Transformation& T_F_submap_new);
 };
@@ -11,6 +11,7 @@
 #include <ros/ros.h>
 
 #include <glocal_exploration/3rd_party/config_utilities.hpp>
+#include <glocal_exploration/planning/global/frontier_index.h>
 #include <glocal_exploration/planning/global/skeleton/relative_waypoint.h>
 #include <glocal_exploration/planning/global/skeleton/skeleton_a_star.h>
 #include <glocal_exploration/planning/global/skeleton/skeleton_submap_collection.h>
@@ -37,6 +38,9 @@ class SkeletonPlanner : public SubmapFrontierEvaluator {
     // frontier before returning to local planning (or choosing a new frontier).
     int max_replan_attempts_to_chosen_frontier = 3;
     FloatingPoint sensor_vertical_fov_rad = 0.5;
+    // Frontier points beyond this range are not considered to be observable
+    // from a skeleton vertex. Set to -1 to disable.
+    FloatingPoint sensor_max_range_m = -1.f;
 
     FloatingPoint backtracking_distance_m = 10.f;  // Set to -1 to disable.
 
@@ -56,7 +60,11 @@ class SkeletonPlanner : public SubmapFrontierEvaluator {
     FloatingPoint euclidean_distance = 0.f;
     FloatingPoint path_distance = 0.f;
     int num_points = 0;
-    std::vector<Point> frontier_points;
+    // NOTE: Views into the frontier evaluator's storage, which are valid
+    //       until the frontiers are updated again.
+    FrontierVoxelList::PointSpan frontier_points;
+    // Id of these points in the frontier evaluator's spatial index.
+    size_t frontier_id = 0u;
     int clusters = 1;
     std::vector<RelativeWayPoint> way_points;
     enum Reachability {
@@ -116,9 +124,12 @@ class SkeletonPlanner : public SubmapFrontierEvaluator {
   bool computePathToFrontier(
       const Point& start_point,
       const std::vector<GlobalVertexId>& start_vertex_candidates,
-      const Point& frontier_centroid, const std::vector<Point>& frontier_points,
+      const FrontierSearchData& frontier,
       std::vector<RelativeWayPoint>* way_points,
       bool* frontier_is_observable = nullptr);
+  template <typename PointRange>
+  bool hasEnoughVisibleFrontierPoints(const PointRange& frontier_points,
+                                      const Point& skeleton_vertex_point);
   bool isFrontierPointObservableFromPosition(
       const Point& frontier_point, const Point& skeleton_vertex_point);
   void clusterFrontiers();
@@ -133,6 +144,8 @@ class SkeletonPlanner : public SubmapFrontierEvaluator {
   // Variables.
   std::vector<RelativeWayPoint> way_points_;  // in mission frame.
   std::vector<FrontierSearchData> frontier_data_;
+  // Spatial index over the clustered frontiers, if they are clustered.
+  FrontierIndex clustered_frontier_index_;
   VisualizationData vis_data_;
 
   // Stages of global planning.
@@ -0,0 +1,588 @@
+#include "glocal_exploration_ros/mapping/threadsafe_wrappers/threadsafe_voxblox_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#include <minkindr_conversions/kindr_msg.h>
+#include <voxblox/io/layer_io.h>
+#include <voxblox_ros/conversions.h>
+#include <voxblox_ros/ptcloud_vis.h>
+
+namespace glocal_exploration {
+
+void ThreadsafeVoxbloxServer::StageStats::addRun(
+    const double latency, const size_t new_queue_depth) {
+  queue_depth = new_queue_depth;
+  ++num_runs;
+  last_latency = latency;
+  mean_latency += (latency - mean_latency) / static_cast<double>(num_runs);
+  max_latency = std::max(max_latency, latency);
+}
+
+ThreadsafeVoxbloxServer::~ThreadsafeVoxbloxServer() {
+  spinner_.stop();
+  {
+    std::lock_guard<std::mutex> lock(esdf_stage_mutex_);
+    shutdown_esdf_stage_ = true;
+  }
+  esdf_stage_cv_.notify_all();
+  if (esdf_stage_thread_.joinable()) {
+    esdf_stage_thread_.join();
+  }
+}
+
+void ThreadsafeVoxbloxServer::setupEsdfStage() {
+  // Replace the base server's periodic ESDF update, which would run on the
+  // integration thread
+  update_esdf_timer_.stop();
+  update_esdf_period_ =
+      nh_private_.param<double>("update_esdf_every_n_sec", 1.0);
+
+  // Let the ESDF integrator read the ESDF stage's own copy of the TSDF
+  const voxblox::Layer<voxblox::TsdfVoxel>& tsdf_layer =
+      tsdf_map_->getTsdfLayer();
+  esdf_input_tsdf_layer_ = std::make_unique<voxblox::Layer<voxblox::TsdfVoxel>>(
+      tsdf_layer.voxel_size(), tsdf_layer.voxels_per_side());
+  esdf_integrator_.reset(new voxblox::EsdfIntegrator(
+      voxblox::getEsdfIntegratorConfigFromRosParam(nh_private_),
+      esdf_input_tsdf_layer_.get(), esdf_map_->getEsdfLayerPtr()));
+
+  // Hand out an empty ESDF map until the first snapshot is published
+  const voxblox::Layer<voxblox::EsdfVoxel>& esdf_layer =
+      esdf_map_->getEsdfLayer();
+  published_esdf_map_ = std::make_shared<voxblox::EsdfMap>(
+      std::make_shared<voxblox::Layer<voxblox::EsdfVoxel>>(
+          esdf_layer.voxel_size(), esdf_layer.voxels_per_side()));
+
+  // Replace the base server's ESDF service and drop its ESDF subscriber, which
+  // would access the live ESDF from the callback thread
+  generate_esdf_srv_.shutdown();
+  generate_esdf_srv_ = nh_private_.advertiseService(
+      "generate_esdf", &ThreadsafeVoxbloxServer::generateEsdfCallback, this);
+  esdf_map_sub_.shutdown();
+
+  esdf_stage_thread_ =
+      std::thread(&ThreadsafeVoxbloxServer::esdfStageLoop, this);
+}
+
+void ThreadsafeVoxbloxServer::insertPointcloud(
+    const sensor_msgs::PointCloud2::Ptr& pointcloud) {
+  const auto t_start = std::chrono::steady_clock::now();
+
+  // Count the pointclouds that were dropped before reaching the server
+  // NOTE: Sequence numbers that do not increase, e.g. since the publisher
+  //       restarted or does not set them, do not indicate any drops.
+  const int64_t seq = pointcloud->header.seq;
+  size_t num_dropped_pointclouds = 0u;
+  if (0 <= last_pointcloud_seq_ && last_pointcloud_seq_ < seq) {
+    num_dropped_pointclouds = seq - last_pointcloud_seq_ - 1;
+  }
+  last_pointcloud_seq_ = seq;
+
+  voxblox::EsdfServer::insertPointcloud(pointcloud);
+  handOverEsdfStageInput();
+
+  const std::chrono::duration<double> latency =
+      std::chrono::steady_clock::now() - t_start;
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  stats_.tsdf_integration.addRun(latency.count(), pointcloud_queue_.size());
+  stats_.num_dropped_pointclouds += num_dropped_pointclouds;
+}
+
+void ThreadsafeVoxbloxServer::handOverEsdfStageInput() {
+  bool input_requested;
+  {
+    std::lock_guard<std::mutex> lock(esdf_stage_mutex_);
+    input_requested = esdf_input_requested_;
+  }
+  if (!input_requested) {
+    return;
+  }
+  EsdfStageInput input = collectEsdfStageInput();
+  {
+    std::lock_guard<std::mutex> lock(esdf_stage_mutex_);
+    esdf_input_ = std::move(input);
+    esdf_input_requested_ = false;
+    esdf_input_ready_ = true;
+  }
+  esdf_stage_cv_.notify_all();
+}
+
+void ThreadsafeVoxbloxServer::newPoseCallback(
+    const voxblox::Transformation& T_G_C) {
+  // NOTE: The base server uses the new poses to update the ESDF, which is
+  //       deferred to the ESDF stage.
+  new_poses_.emplace_back(T_G_C);
+
+  // Call the external callback, if it has been set
+  if (external_new_pose_callback_) {
+    external_new_pose_callback_();
+  }
+}
+
+void ThreadsafeVoxbloxServer::updateEsdf() {
+  {
+    std::lock_guard<std::mutex> lock(esdf_stage_mutex_);
+    esdf_update_requested_ = true;
+  }
+  esdf_stage_cv_.notify_all();
+}
+
+void ThreadsafeVoxbloxServer::updateEsdfBatch(bool full_euclidean) {
+  {
+    std::lock_guard<std::mutex> lock(esdf_stage_mutex_);
+    esdf_update_requested_ = true;
+    esdf_batch_requested_ = true;
+    esdf_batch_full_euclidean_ = full_euclidean;
+  }
+  esdf_stage_cv_.notify_all();
+}
+
+void ThreadsafeVoxbloxServer::publishMap(bool reset_remote_map) {
+  const auto esdf_layer = getEsdfLayerSnapshot();
+  if (publish_esdf_map_ && esdf_layer) {
+    const int subscribers = esdf_map_pub_.getNumSubscribers();
+    if (0 < subscribers) {
+      if (num_subscribers_esdf_map_ < subscribers) {
+        reset_remote_map = true;
+      }
+      const bool only_updated = false;
+      voxblox_msgs::Layer layer_msg;
+      voxblox::serializeLayerAsMsg<voxblox::EsdfVoxel>(
+          *esdf_layer, only_updated, &layer_msg);
+      if (reset_remote_map) {
+        layer_msg.action =
+            static_cast<uint8_t>(voxblox::MapDerializationAction::kReset);
+      }
+      esdf_map_pub_.publish(layer_msg);
+    }
+    num_subscribers_esdf_map_ = subscribers;
+  }
+  voxblox::TsdfServer::publishMap();
+}
+
+void ThreadsafeVoxbloxServer::publishPointclouds() {
+  const auto esdf_layer = getEsdfLayerSnapshot();
+  if (esdf_layer) {
+    pcl::PointCloud<pcl::PointXYZI> pointcloud;
+    voxblox::createDistancePointcloudFromEsdfLayer(*esdf_layer, &pointcloud);
+    pointcloud.header.frame_id = world_frame_;
+    esdf_pointcloud_pub_.publish(pointcloud);
+    if (publish_traversable_) {
+      pcl::PointCloud<pcl::PointXYZI> traversable_pointcloud;
+      voxblox::createFreePointcloudFromEsdfLayer(
+          *esdf_layer, traversability_radius_, &traversable_pointcloud);
+      traversable_pointcloud.header.frame_id = world_frame_;
+      traversable_pub_.publish(traversable_pointcloud);
+    }
+  }
+  // NOTE: This also publishes the slices, if enabled.
+  voxblox::TsdfServer::publishPointclouds();
+}
+
+void ThreadsafeVoxbloxServer::publishSlices() {
+  voxblox::TsdfServer::publishSlices();
+  const auto esdf_layer = getEsdfLayerSnapshot();
+  if (!esdf_layer) {
+    return;
+  }
+  pcl::PointCloud<pcl::PointXYZI> pointcloud;
+  constexpr int kZAxisIndex = 2;
+  voxblox::createDistancePointcloudFromEsdfLayerSlice(
+      *esdf_layer, kZAxisIndex, slice_level_, &pointcloud);
+  pointcloud.header.frame_id = world_frame_;
+  esdf_slice_pub_.publish(pointcloud);
+}
+
+bool ThreadsafeVoxbloxServer::saveMap(const std::string& file_path) {
+  // Output the TSDF first, then the ESDF
+  const auto esdf_layer = getEsdfLayerSnapshot();
+  const bool success = voxblox::TsdfServer::saveMap(file_path);
+  if (!success || !esdf_layer) {
+    return success;
+  }
+  constexpr bool kClearFile = false;
+  return voxblox::io::SaveLayer(*esdf_layer, file_path, kClearFile);
+}
+
+bool ThreadsafeVoxbloxServer::loadMap(const std::string& file_path) {
+  // Load the TSDF first, then the ESDF
+  if (!voxblox::TsdfServer::loadMap(file_path)) {
+    return false;
+  }
+  // NOTE: The loaded TSDF blocks are handed over to the ESDF stage with its
+  //       next input, s.t. its TSDF copy includes them. The ESDF is replaced
+  //       by the ESDF stage right before that input is processed.
+  voxblox::Layer<voxblox::TsdfVoxel>* tsdf_layer =
+      tsdf_map_->getTsdfLayerPtr();
+  voxblox::BlockIndexList tsdf_blocks;
+  tsdf_layer->getAllAllocatedBlocks(&tsdf_blocks);
+  for (const voxblox::BlockIndex& block_index : tsdf_blocks) {
+    tsdf_layer->getBlockByIndex(block_index).updated().set(
+        voxblox::Update::kEsdf);
+  }
+
+  const voxblox::Layer<voxblox::EsdfVoxel>& esdf_layer =
+      esdf_map_->getEsdfLayer();
+  auto loaded_esdf_layer = std::make_shared<voxblox::Layer<voxblox::EsdfVoxel>>(
+      esdf_layer.voxel_size(), esdf_layer.voxels_per_side());
+  constexpr bool kMultipleLayerSupport = true;
+  if (!voxblox::io::LoadBlocksFromFile(
+          file_path,
+          voxblox::Layer<voxblox::EsdfVoxel>::BlockMergingStrategy::kReplace,
+          kMultipleLayerSupport, loaded_esdf_layer.get())) {
+    return false;
+  }
+  runOnEsdfStage([this, loaded_esdf_layer] {
+    voxblox::Layer<voxblox::EsdfVoxel>* esdf_layer =
+        esdf_map_->getEsdfLayerPtr();
+    voxblox::BlockIndexList loaded_blocks;
+    loaded_esdf_layer->getAllAllocatedBlocks(&loaded_blocks);
+    for (const voxblox::BlockIndex& block_index : loaded_blocks) {
+      esdf_layer->removeBlock(block_index);
+      esdf_layer->insertBlock(std::make_pair(
+          block_index, loaded_esdf_layer->getBlockPtrByIndex(block_index)));
+    }
+    publishSnapshots(voxblox::BlockIndexList(), loaded_blocks);
+    observed_space_changes_.markChanged(loaded_blocks);
+  });
+  handOverEsdfStageInput();
+  return true;
+}
+
+void ThreadsafeVoxbloxServer::clear() {
+  // NOTE: The ESDF stage's TSDF copy is brought up to date with its next
+  //       input, which reports the cleared TSDF blocks as removed.
+  runOnEsdfStage([this] {
+    esdf_map_->getEsdfLayerPtr()->removeAllBlocks();
+    esdf_integrator_->clear();
+    publishSnapshots(voxblox::BlockIndexList(), voxblox::BlockIndexList());
+  });
+  voxblox::TsdfServer::clear();
+  handOverEsdfStageInput();
+
+  // Publish a message to reset the map to all subscribers
+  constexpr bool kResetRemoteMap = true;
+  publishMap(kResetRemoteMap);
+}
+
+bool ThreadsafeVoxbloxServer::generateEsdfCallback(
+    std_srvs::Empty::Request& /*request*/,      // NOLINT
+    std_srvs::Empty::Response& /*response*/) {  // NOLINT
+  // NOTE: The ESDF is regenerated asynchronously, so it is published by the
+  //       next periodic map publication.
+  const bool full_euclidean = true;
+  updateEsdfBatch(full_euclidean);
+  handOverEsdfStageInput();
+  return true;
+}
+
+void ThreadsafeVoxbloxServer::runOnEsdfStage(Function task) {
+  {
+    std::lock_guard<std::mutex> lock(esdf_stage_mutex_);
+    esdf_stage_tasks_.emplace_back(std::move(task));
+  }
+  esdf_stage_cv_.notify_all();
+}
+
+ThreadsafeVoxbloxServer::EsdfStageInput
+ThreadsafeVoxbloxServer::collectEsdfStageInput() {
+  EsdfStageInput input;
+  voxblox::Layer<voxblox::TsdfVoxel>* tsdf_layer =
+      tsdf_map_->getTsdfLayerPtr();
+
+  // NOTE: Only the blocks that changed since the last handover are copied,
+  //       and their flags are cleared as the ESDF integrator would.
+  voxblox::BlockIndexList updated_block_indices;
+  tsdf_layer->getAllUpdatedBlocks(voxblox::Update::kEsdf,
+                                  &updated_block_indices);
+  input.updated_blocks.reserve(updated_block_indices.size());
+  for (const voxblox::BlockIndex& block_index : updated_block_indices) {
+    TsdfBlock& block = tsdf_layer->getBlockByIndex(block_index);
+    TsdfBlock::Ptr block_copy =
+        IncrementalLayerSnapshot<voxblox::TsdfVoxel>::copyBlock(block);
+    block_copy->updated().set(voxblox::Update::kEsdf);
+    block.updated().reset(voxblox::Update::kEsdf);
+    input.updated_blocks.emplace_back(block_index, std::move(block_copy));
+  }
+  tsdf_layer->getAllAllocatedBlocks(&input.allocated_blocks);
+  input.new_poses = std::move(new_poses_);
+  new_poses_.clear();
+
+  auto pose_history = std::make_shared<PoseHistory>();
+  for (const auto& item : pointcloud_deintegration_queue_) {
+    geometry_msgs::PoseStamped pose_msg;
+    pose_msg.header.stamp = item.timestamp;
+    tf::poseKindrToMsg(item.T_G_C.cast<double>(), &pose_msg.pose);
+    pose_history->emplace_back(pose_msg);
+  }
+  input.pose_history = std::move(pose_history);
+  return input;
+}
+
+void ThreadsafeVoxbloxServer::esdfStageLoop() {
+  while (true) {
+    // Wait until the next update is due, or an update or task was requested
+    std::vector<Function> tasks;
+    bool update_is_due;
+    {
+      std::unique_lock<std::mutex> lock(esdf_stage_mutex_);
+      const auto is_requested = [&] {
+        return esdf_update_requested_ || !esdf_stage_tasks_.empty() ||
+               shutdown_esdf_stage_;
+      };
+      if (0.0 < update_esdf_period_) {
+        // NOTE: wait_for() returns false if the period elapsed.
+        update_is_due = !esdf_stage_cv_.wait_for(
+            lock, std::chrono::duration<double>(update_esdf_period_),
+            is_requested);
+      } else {
+        esdf_stage_cv_.wait(lock, is_requested);
+        update_is_due = false;
+      }
+      if (shutdown_esdf_stage_) {
+        return;
+      }
+      update_is_due |= esdf_update_requested_;
+      tasks.swap(esdf_stage_tasks_);
+    }
+    for (const Function& task : tasks) {
+      task();
+    }
+    if (!update_is_due) {
+      continue;
+    }
+
+    EsdfStageInput input;
+    bool batch;
+    bool full_euclidean;
+    {
+      std::unique_lock<std::mutex> lock(esdf_stage_mutex_);
+      esdf_update_requested_ = false;
+      batch = esdf_batch_requested_;
+      full_euclidean = esdf_batch_full_euclidean_;
+      esdf_batch_requested_ = false;
+
+      // Get the changed TSDF blocks from the integration stage, which hands
+      // them over once it integrated the current pointcloud or loaded or
+      // cleared the map
+      // NOTE: Tasks that are queued meanwhile, e.g. by loadMap() or clear(),
+      //       are run right away s.t. they do not wait for the next input.
+      esdf_input_requested_ = true;
+      while (true) {
+        esdf_stage_cv_.wait(lock, [&] {
+          return esdf_input_ready_ || !esdf_stage_tasks_.empty() ||
+                 shutdown_esdf_stage_;
+        });
+        if (shutdown_esdf_stage_) {
+          return;
+        }
+        if (esdf_stage_tasks_.empty()) {
+          break;
+        }
+        tasks.clear();
+        tasks.swap(esdf_stage_tasks_);
+        lock.unlock();
+        for (const Function& task : tasks) {
+          task();
+        }
+        lock.lock();
+      }
+      input = std::move(esdf_input_);
+      esdf_input_ready_ = false;
+    }
+    runEsdfStage(std::move(input), batch, full_euclidean);
+  }
+}
+
+void ThreadsafeVoxbloxServer::runEsdfStage(EsdfStageInput input,
+                                           const bool batch,
+                                           const bool full_euclidean) {
+  // Stage 2: Bring the TSDF copy up to date and propagate the ESDF
+  const auto t_start = std::chrono::steady_clock::now();
+  voxblox::BlockIndexList updated_tsdf_blocks;
+  voxblox::BlockIndexList removed_tsdf_blocks;
+  updated_tsdf_blocks.reserve(input.updated_blocks.size());
+  for (auto& block_kv : input.updated_blocks) {
+    esdf_input_tsdf_layer_->removeBlock(block_kv.first);
+    esdf_input_tsdf_layer_->insertBlock(
+        std::make_pair(block_kv.first, std::move(block_kv.second)));
+    updated_tsdf_blocks.emplace_back(block_kv.first);
+  }
+  if (esdf_input_tsdf_layer_->getNumberOfAllocatedBlocks() !=
+      input.allocated_blocks.size()) {
+    // Drop the blocks that the integration stage removed from the TSDF
+    const voxblox::IndexSet allocated_blocks(input.allocated_blocks.begin(),
+                                             input.allocated_blocks.end());
+    voxblox::BlockIndexList copied_blocks;
+    esdf_input_tsdf_layer_->getAllAllocatedBlocks(&copied_blocks);
+    for (const voxblox::BlockIndex& block_index : copied_blocks) {
+      if (!allocated_blocks.count(block_index)) {
+        esdf_input_tsdf_layer_->removeBlock(block_index);
+        removed_tsdf_blocks.emplace_back(block_index);
+      }
+    }
+  }
+  for (const voxblox::Transformation& T_G_C : input.new_poses) {
+    voxblox::EsdfServer::newPoseCallback(T_G_C);
+  }
+  if (0u < esdf_input_tsdf_layer_->getNumberOfAllocatedBlocks()) {
+    if (batch) {
+      esdf_integrator_->setFullEuclidean(full_euclidean);
+      esdf_integrator_->updateFromTsdfLayerBatch();
+    } else {
+      const bool clear_updated_flag_esdf = true;
+      esdf_integrator_->updateFromTsdfLayer(clear_updated_flag_esdf);
+    }
+  }
+  const auto t_propagated = std::chrono::steady_clock::now();
+
+  // Stage 3: Publish the snapshots
+  // NOTE: Clearing the sphere around the robot writes to the ESDF without
+  //       going through the TSDF, so the whole layer is refreshed then.
+  const voxblox::BlockIndexList updated_esdf_blocks =
+      batch || clear_sphere_for_planning_
+          ? getAllEsdfBlocks()
+          : getEsdfBlocksAffectedBy(updated_tsdf_blocks);
+  std::atomic_store(&published_pose_history_, input.pose_history);
+  publishSnapshots(updated_tsdf_blocks, updated_esdf_blocks);
+  updateFrontierCandidates(updated_tsdf_blocks, removed_tsdf_blocks);
+
+  // Report where the observed space changed, now that the snapshots show it
+  // NOTE: Whether an ESDF voxel is observed only depends on its TSDF voxel,
+  //       except around the robot when the sphere is being cleared.
+  voxblox::BlockIndexList changed_blocks =
+      clear_sphere_for_planning_ ? updated_esdf_blocks : updated_tsdf_blocks;
+  changed_blocks.insert(changed_blocks.end(), removed_tsdf_blocks.begin(),
+                        removed_tsdf_blocks.end());
+  observed_space_changes_.markChanged(changed_blocks);
+
+  // Call the external callback, if it has been set
+  if (external_new_esdf_callback_) {
+    external_new_esdf_callback_();
+  }
+  const auto t_published = std::chrono::steady_clock::now();
+
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.esdf_propagation.addRun(
+        std::chrono::duration<double>(t_propagated - t_start).count(),
+        updated_tsdf_blocks.size());
+    stats_.snapshot_publication.addRun(
+        std::chrono::duration<double>(t_published - t_propagated).count(),
+        updated_esdf_blocks.size());
+    VLOG(3) << "Voxblox pipeline: integration "
+            << stats_.tsdf_integration.last_latency << "s ("
+            << stats_.tsdf_integration.queue_depth
+            << " pointclouds waiting for their pose, "
+            << stats_.num_dropped_pointclouds << " dropped so far), ESDF "
+            << stats_.esdf_propagation.last_latency << "s ("
+            << stats_.esdf_propagation.queue_depth
+            << " TSDF blocks), publication "
+            << stats_.snapshot_publication.last_latency << "s ("
+            << stats_.snapshot_publication.queue_depth << " ESDF blocks).";
+  }
+}
+
+void ThreadsafeVoxbloxServer::publishSnapshots(
+    const voxblox::BlockIndexList& updated_tsdf_blocks,
+    const voxblox::BlockIndexList& updated_esdf_blocks) {
+  esdf_snapshot_.update(esdf_map_->getEsdfLayer(), updated_esdf_blocks);
+  // NOTE: The EsdfMap only takes mutable layers, but the map is published as
+  //       const s.t. the snapshot's layer can never be modified through it.
+  std::shared_ptr<const voxblox::EsdfMap> esdf_map =
+      std::make_shared<voxblox::EsdfMap>(
+          std::const_pointer_cast<voxblox::Layer<voxblox::EsdfVoxel>>(
+              esdf_snapshot_.get()));
+  std::atomic_store(&published_esdf_map_, std::move(esdf_map));
+  if (tsdf_snapshot_enabled_) {
+    tsdf_snapshot_.update(*esdf_input_tsdf_layer_, updated_tsdf_blocks);
+  }
+  updateEsdfLayerSummaries(updated_esdf_blocks);
+}
+
+void ThreadsafeVoxbloxServer::updateEsdfLayerSummaries(
+    const voxblox::BlockIndexList& updated_esdf_blocks) {
+  const voxblox::Layer<voxblox::EsdfVoxel>& esdf_layer =
+      esdf_map_->getEsdfLayer();
+  if (block_summaries_enabled_) {
+    if (!block_summaries_) {
+      block_summaries_ = std::make_unique<BlockSummaryLayer>(esdf_layer);
+    } else {
+      block_summaries_->update(esdf_layer, updated_esdf_blocks);
+    }
+    std::atomic_store(
+        &published_block_summaries_,
+        std::make_shared<const BlockSummaryLayer>(*block_summaries_));
+  }
+  if (voxel_states_enabled_) {
+    if (!voxel_states_) {
+      voxel_states_ = std::make_unique<VoxelStateLayer>(
+          esdf_layer.voxel_size(), esdf_layer.voxels_per_side());
+      voxel_states_->update(esdf_layer, getAllEsdfBlocks());
+    } else {
+      voxel_states_->update(esdf_layer, updated_esdf_blocks);
+    }
+    std::atomic_store(&published_voxel_states_,
+                      std::make_shared<const VoxelStateLayer>(*voxel_states_));
+  }
+}
+
+void ThreadsafeVoxbloxServer::updateFrontierCandidates(
+    const voxblox::BlockIndexList& updated_tsdf_blocks,
+    const voxblox::BlockIndexList& removed_tsdf_blocks) {
+  if (!frontier_tracking_enabled_) {
+    return;
+  }
+  // NOTE: The frontiers are tracked on the TSDF copy that the ESDF is
+  //       propagated from, so only the blocks of this update are revisited.
+  if (!frontier_tracker_) {
+    frontier_tracker_ = std::make_unique<IncrementalFrontierTracker>(
+        esdf_input_tsdf_layer_->voxel_size(),
+        esdf_input_tsdf_layer_->voxels_per_side());
+    voxblox::BlockIndexList all_tsdf_blocks;
+    esdf_input_tsdf_layer_->getAllAllocatedBlocks(&all_tsdf_blocks);
+    frontier_tracker_->update(*esdf_input_tsdf_layer_, all_tsdf_blocks,
+                              removed_tsdf_blocks);
+  } else if (!updated_tsdf_blocks.empty() || !removed_tsdf_blocks.empty()) {
+    frontier_tracker_->update(*esdf_input_tsdf_layer_, updated_tsdf_blocks,
+                              removed_tsdf_blocks);
+  } else {
+    return;
+  }
+  std::atomic_store(&published_frontier_candidates_,
+                    std::make_shared<const FrontierVoxelList>(
+                        frontier_tracker_->getFrontiers()));
+}
+
+voxblox::BlockIndexList ThreadsafeVoxbloxServer::getEsdfBlocksAffectedBy(
+    const voxblox::BlockIndexList& updated_tsdf_blocks) const {
+  if (updated_tsdf_blocks.empty()) {
+    return voxblox::BlockIndexList();
+  }
+  const int radius = std::max(
+      1, static_cast<int>(std::ceil(esdf_max_distance_ /
+                                    esdf_map_->getEsdfLayer().block_size())));
+  voxblox::IndexSet dilated_blocks;
+  for (const voxblox::BlockIndex& block_index : updated_tsdf_blocks) {
+    for (int x = -radius; x <= radius; ++x) {
+      for (int y = -radius; y <= radius; ++y) {
+        for (int z = -radius; z <= radius; ++z) {
+          dilated_blocks.insert(block_index + voxblox::BlockIndex(x, y, z));
+        }
+      }
+    }
+  }
+  return voxblox::BlockIndexList(dilated_blocks.begin(), dilated_blocks.end());
+}
+
+voxblox::BlockIndexList ThreadsafeVoxbloxServer::getAllEsdfBlocks() const {
+  voxblox::BlockIndexList block_indices;
+  esdf_map_->getEsdfLayer().getAllAllocatedBlocks(&block_indices);
+  return block_indices;
+}
+
+}  // namespace glocal_exploration
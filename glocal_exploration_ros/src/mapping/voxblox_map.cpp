@@ -5,6 +5,8 @@
 #include <vector>
 
 #include <glocal_exploration/common.h>
+#include <glocal_exploration/mapping/esdf_interpolator.h>
+#include <glocal_exploration/mapping/voxel_state_layer.h>
 #include <glocal_exploration/state/communicator.h>
 
 namespace glocal_exploration {
@@ -18,6 +20,9 @@ void VoxbloxMap::Config::checkParams() const {
 void VoxbloxMap::Config::fromRosParam() {
   rosParam("traversability_radius", &traversability_radius);
   rosParam("clearing_radius", &clearing_radius);
+  rosParam("use_block_summaries", &use_block_summaries);
+  rosParam("use_voxel_state_layer", &use_voxel_state_layer);
+  rosParam("use_frontier_tracking", &use_frontier_tracking);
   nh_private_namespace = rosParamNameSpace();
 }
 
@@ -28,6 +33,16 @@ VoxbloxMap::VoxbloxMap(const Config& config,
   ros::NodeHandle nh_private(config_.nh_private_namespace);
   ros::NodeHandle nh(ros::names::parentNamespace(config_.nh_private_namespace));
   server_ = std::make_unique<ThreadsafeVoxbloxServer>(nh, nh_private);
+  server_->enableTsdfLayerSnapshot();
+  if (config_.use_block_summaries) {
+    server_->enableBlockSummaries();
+  }
+  if (config_.use_voxel_state_layer) {
+    server_->enableVoxelStateLayer();
+  }
+  if (config_.use_frontier_tracking) {
+    server_->enableFrontierTracking();
+  }
 
   // cache important values
   c_voxel_size_ = server_->getEsdfMapPtr()->voxel_size();
@@ -153,14 +168,9 @@ bool VoxbloxMap::lineIntersectsSurfaceInActiveSubmap(const Point& start_point,
 bool VoxbloxMap::getDistanceInActiveSubmap(const Point& position,
                                            FloatingPoint* distance) const {
   CHECK_NOTNULL(distance);
-  double distance_tmp;
-  if (server_->getEsdfMapPtr()->getDistanceAtPosition(position.cast<double>(),
-                                                      &distance_tmp)) {
-    *distance = static_cast<FloatingPoint>(distance_tmp);
-    return true;
-  } else {
-    return false;
-  }
+  const auto esdf_layer = server_->getEsdfLayerSnapshot();
+  return esdf_layer &&
+         EsdfInterpolator(*esdf_layer).getDistance(position, distance);
 }
 
 bool VoxbloxMap::getDistanceAndGradientInActiveSubmap(const Point& position,
@@ -168,20 +178,23 @@ bool VoxbloxMap::getDistanceAndGradientInActiveSubmap(const Point& position,
                                                       Point* gradient) const {
   CHECK_NOTNULL(distance);
   CHECK_NOTNULL(gradient);
-  double distance_tmp;
-  Eigen::Vector3d gradient_tmp;
-  if (server_->getEsdfMapPtr()->getDistanceAndGradientAtPosition(
-          position.cast<double>(), &distance_tmp, &gradient_tmp)) {
-    *distance = static_cast<FloatingPoint>(distance_tmp);
-    *gradient = gradient_tmp.cast<FloatingPoint>();
-    return true;
-  } else {
-    return false;
-  }
+  const auto esdf_layer = server_->getEsdfLayerSnapshot();
+  return esdf_layer &&
+         EsdfInterpolator(*esdf_layer)
+             .getDistanceAndGradient(position, distance, gradient);
 }
 
 MapBase::VoxelState VoxbloxMap::getVoxelStateInLocalArea(
     const Point& position) {
+  // NOTE: The packed layer looks up the nearest voxel instead of interpolating
+  //       the ESDF, which is accurate enough for the gain computation.
+  if (config_.use_voxel_state_layer) {
+    const VoxelStateLayer::ConstPtr voxel_states =
+        server_->getVoxelStateLayer();
+    if (voxel_states) {
+      return voxel_states->getVoxelState(position);
+    }
+  }
   FloatingPoint distance = 0.f;
   if (getDistanceInActiveSubmap(position, &distance)) {
     // This means the voxel is observed
@@ -194,13 +207,22 @@ MapBase::VoxelState VoxbloxMap::getVoxelStateInLocalArea(
 }
 
 std::vector<MapBase::SubmapData> VoxbloxMap::getAllSubmapData() {
+  // NOTE: The map is still being integrated into, so we hand out the latest
+  //       incremental snapshot instead of copying the whole layer.
   std::vector<SubmapData> data;
   SubmapData datum;
   datum.id = 0;
   datum.T_M_S.setIdentity();
-  datum.tsdf_layer = std::make_shared<const voxblox::Layer<voxblox::TsdfVoxel>>(
-      server_->getTsdfMapPtr()->getTsdfLayer());
-  data.push_back(datum);
+  datum.tsdf_layer = server_->getTsdfLayerSnapshot();
+  datum.block_summary = server_->getBlockSummaries();
+  // NOTE: The tracked frontiers are updated with every ESDF update, so they
+  //       replace the sweep over the whole layer.
+  if (config_.use_frontier_tracking) {
+    datum.frontier_candidates = server_->getFrontierCandidates();
+  }
+  if (datum.tsdf_layer || datum.frontier_candidates) {
+    data.push_back(datum);
+  }
   return data;
 }
 
@@ -0,0 +1,52 @@
+#include "glocal_exploration_ros/mapping/voxgraph_compact_submap_store.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace glocal_exploration {
+
+void VoxgraphCompactSubmapStore::update(
+    const voxgraph::VoxgraphSubmapCollection& submap_collection) {
+  // Copy the current version, which only shares the layers themselves
+  std::unique_ptr<CompactSubmapLayers> new_layers;
+  {
+    const auto layers = layers_.read();
+    new_layers = layers ? std::make_unique<CompactSubmapLayers>(*layers)
+                        : std::make_unique<CompactSubmapLayers>();
+  }
+
+  size_t num_new_layers = 0u;
+  for (const voxgraph::VoxgraphSubmap::ConstPtr& submap_ptr :
+       submap_collection.getSubmapConstPtrs()) {
+    if (new_layers->count(submap_ptr->getID())) {
+      continue;
+    }
+    const voxblox::Layer<voxblox::TsdfVoxel>& tsdf_layer =
+        submap_ptr->getTsdfMap().getTsdfLayer();
+    const voxblox::Layer<voxblox::EsdfVoxel>& esdf_layer =
+        submap_ptr->getEsdfMap().getEsdfLayer();
+    auto compact_layer = std::make_shared<const CompactSubmapLayer>(
+        tsdf_layer, esdf_layer, max_distance_);
+    compact_memory_usage_ += compact_layer->getMemoryUsage();
+    full_memory_usage_ +=
+        tsdf_layer.getMemorySize() + esdf_layer.getMemorySize();
+    new_layers->emplace(submap_ptr->getID(), std::move(compact_layer));
+    ++num_new_layers;
+  }
+  if (num_new_layers == 0u) {
+    return;
+  }
+
+  VLOG(2) << "Compact submap store: added " << num_new_layers
+          << " submaps. The copies of all " << new_layers->size()
+          << " submaps add " << compact_memory_usage_ / 1e6
+          << "MB to the " << full_memory_usage_ / 1e6
+          << "MB of their full precision layers ("
+          << 100.f * compact_memory_usage_ /
+                 std::max(full_memory_usage_, size_t{1})
+          << "%).";
+  layers_.publish(std::move(new_layers));
+}
+
+}  // namespace glocal_exploration
@@ -0,0 +1,287 @@
+#include "glocal_exploration_ros/mapping/voxgraph_global_esdf_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <glocal_exploration/mapping/esdf_interpolator.h>
+
+namespace glocal_exploration {
+
+void VoxgraphGlobalEsdfCache::update(
+    const voxgraph::VoxgraphSubmapCollection& submap_collection) {
+  // Update the transform from the odom to a fixed (non-robocentric) frame
+  if (submap_collection.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+  fixed_frame_transformer_.update(
+      submap_collection.getSubmap(submap_collection.getFirstSubmapId())
+          .getPose());
+
+  size_t num_new_submaps = 0u;
+  size_t num_moved_submaps = 0u;
+  for (const voxgraph::VoxgraphSubmap::ConstPtr& submap_ptr :
+       submap_collection.getSubmapConstPtrs()) {
+    const SubmapId submap_id = submap_ptr->getID();
+    const Transformation T_F_submap_new =
+        fixed_frame_transformer_.transformFromOdomToFixedFrame(
+            submap_ptr->getPose());
+
+    auto submap_pose_it = submap_poses_.find(submap_id);
+    if (submap_pose_it == submap_poses_.end()) {
+      // New submaps can overlap with blocks that have already been computed
+      const voxblox::Layer<voxblox::TsdfVoxel>& submap_tsdf =
+          submap_ptr->getTsdfMap().getTsdfLayer();
+      SubmapFootprint& submap_footprint = submap_footprints_[submap_id];
+      submap_footprint.block_size = submap_tsdf.block_size();
+      submap_tsdf.getAllAllocatedBlocks(&submap_footprint.blocks);
+      invalidateBlocksInFootprint(T_F_submap_new, submap_footprint);
+      submap_poses_.emplace(submap_id, T_F_submap_new);
+      ++num_new_submaps;
+    } else if (submapPoseChanged(submap_pose_it->second, T_F_submap_new)) {
+      // Invalidate the blocks the submap contributed to at its old pose and
+      // the blocks it overlaps with at its new pose
+      // NOTE: The set is copied since removing its blocks also erases them
+      //       from the set itself.
+      auto cache_blocks_it = submap_cache_blocks_.find(submap_id);
+      if (cache_blocks_it != submap_cache_blocks_.end()) {
+        const voxblox::IndexSet cache_blocks = cache_blocks_it->second;
+        for (const voxblox::BlockIndex& block_index : cache_blocks) {
+          removeCacheBlock(block_index);
+        }
+      }
+      invalidateBlocksInFootprint(T_F_submap_new,
+                                  submap_footprints_.at(submap_id));
+      submap_pose_it->second = T_F_submap_new;
+      ++num_moved_submaps;
+    }
+  }
+
+  VLOG(3) << "Global ESDF cache: invalidated blocks for " << num_new_submaps
+          << " new and " << num_moved_submaps << " moved submaps, "
+          << cache_layer_.getNumberOfAllocatedBlocks() << " blocks remain.";
+}
+
+bool VoxgraphGlobalEsdfCache::getDistanceAtPosition(
+    const Point& position,
+    const voxgraph::VoxgraphSubmapCollection& submap_collection,
+    const VoxgraphSpatialHash& spatial_submap_id_hash,
+    FloatingPoint* distance) {
+  CHECK_NOTNULL(distance);
+  std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+  const Point t_F_position =
+      fixed_frame_transformer_.transformFromOdomToFixedFrame(position);
+
+  // Make sure all blocks containing the interpolation neighbors are computed
+  const Point half_voxel = Point::Constant(0.5f * cache_layer_.voxel_size());
+  const auto min_block_index =
+      voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+          t_F_position - half_voxel, cache_layer_.block_size_inv());
+  const auto max_block_index =
+      voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+          t_F_position + half_voxel, cache_layer_.block_size_inv());
+  voxblox::BlockIndex block_index;
+  for (block_index.x() = min_block_index.x();
+       block_index.x() <= max_block_index.x(); ++block_index.x()) {
+    for (block_index.y() = min_block_index.y();
+         block_index.y() <= max_block_index.y(); ++block_index.y()) {
+      for (block_index.z() = min_block_index.z();
+           block_index.z() <= max_block_index.z(); ++block_index.z()) {
+        auto block_info_it = cache_block_infos_.find(block_index);
+        if (block_info_it == cache_block_infos_.end()) {
+          computeBlock(block_index, submap_collection, spatial_submap_id_hash);
+        } else {
+          lru_cache_blocks_.splice(lru_cache_blocks_.begin(), lru_cache_blocks_,
+                                   block_info_it->second.lru_it);
+        }
+      }
+    }
+  }
+  // NOTE: The blocks used by this query are the most recent ones, and the
+  //       cache holds at least 8 blocks, so they are never evicted here.
+  evictLeastRecentlyUsedBlocks();
+
+  // Interpolate if all neighbors are observed, otherwise fall back to the
+  // nearest voxel
+  if (EsdfInterpolator(cache_layer_).getDistance(t_F_position, distance)) {
+    return true;
+  }
+  const EsdfVoxel* voxel_ptr =
+      cache_layer_.getVoxelPtrByCoordinates(t_F_position);
+  if (voxel_ptr && voxel_ptr->observed) {
+    *distance = voxel_ptr->distance;
+    return true;
+  }
+  return false;
+}
+
+bool VoxgraphGlobalEsdfCache::getSubmapDistance(
+    const voxgraph::VoxgraphSubmap& submap,
+    const CompactSubmapLayer* compact_layer, const Point& t_submap_position,
+    FloatingPoint* distance) const {
+  if (compact_layer) {
+    return compact_layer->getDistance(t_submap_position, distance,
+                                      /* interpolate */ false);
+  }
+  const EsdfVoxel* voxel_ptr =
+      submap.getEsdfMap().getEsdfLayer().getVoxelPtrByCoordinates(
+          t_submap_position);
+  if (voxel_ptr && voxel_ptr->observed) {
+    *distance = voxel_ptr->distance;
+    return true;
+  }
+  return false;
+}
+
+void VoxgraphGlobalEsdfCache::computeBlock(
+    const voxblox::BlockIndex& block_index,
+    const voxgraph::VoxgraphSubmapCollection& submap_collection,
+    const VoxgraphSpatialHash& spatial_submap_id_hash) {
+  voxblox::Block<EsdfVoxel>::Ptr block_ptr =
+      cache_layer_.allocateBlockPtrByIndex(block_index);
+
+  // Find the submaps that could overlap with the block
+  const FloatingPoint block_size = cache_layer_.block_size();
+  const Point t_F_block_center =
+      voxblox::getCenterPointFromGridIndex(block_index, block_size);
+  const FloatingPoint block_half_diagonal = 0.5f * std::sqrt(3.f) * block_size;
+  const std::vector<SubmapId> overlapping_submap_ids =
+      spatial_submap_id_hash.getSubmapsNearPosition(
+          fixed_frame_transformer_.transformFromFixedToOdomFrame(
+              t_F_block_center),
+          block_half_diagonal);
+
+  // NOTE: The submap poses and compact layers are only looked up once per
+  //       block instead of once per voxel.
+  struct OverlappingSubmap {
+    voxgraph::VoxgraphSubmap::ConstPtr submap_ptr;
+    CompactSubmapLayer::ConstPtr compact_layer;
+    Transformation T_submap_F;
+  };
+  std::vector<OverlappingSubmap> overlapping_submaps;
+  CacheBlockInfo& block_info = cache_block_infos_[block_index];
+  lru_cache_blocks_.push_front(block_index);
+  block_info.lru_it = lru_cache_blocks_.begin();
+  for (const SubmapId submap_id : overlapping_submap_ids) {
+    voxgraph::VoxgraphSubmap::ConstPtr submap_ptr =
+        submap_collection.getSubmapConstPtr(submap_id);
+    if (submap_ptr) {
+      const Transformation T_submap_F =
+          fixed_frame_transformer_
+              .transformFromOdomToFixedFrame(submap_ptr->getPose())
+              .inverse();
+      CompactSubmapLayer::ConstPtr compact_layer =
+          compact_submap_store_ ? compact_submap_store_->getLayer(submap_id)
+                                : nullptr;
+      overlapping_submaps.push_back(
+          {std::move(submap_ptr), std::move(compact_layer), T_submap_F});
+      submap_cache_blocks_[submap_id].insert(block_index);
+      block_info.submap_ids.push_back(submap_id);
+    }
+  }
+
+  // Compute the minimum distance over all submaps for each voxel
+  // NOTE: Each submap contributes the distance of its voxel that is nearest to
+  //       the cache voxel, s.t. queries only interpolate once, in the cache.
+  for (size_t linear_index = 0u; linear_index < block_ptr->num_voxels();
+       ++linear_index) {
+    EsdfVoxel& voxel = block_ptr->getVoxelByLinearIndex(linear_index);
+    const Point t_F_voxel =
+        block_ptr->computeCoordinatesFromLinearIndex(linear_index);
+    voxel.observed = false;
+    voxel.distance = std::numeric_limits<FloatingPoint>::max();
+    for (const OverlappingSubmap& overlapping_submap : overlapping_submaps) {
+      const Point t_submap_voxel = overlapping_submap.T_submap_F * t_F_voxel;
+      FloatingPoint submap_esdf_distance = 0.f;
+      if (getSubmapDistance(*overlapping_submap.submap_ptr,
+                            overlapping_submap.compact_layer.get(),
+                            t_submap_voxel, &submap_esdf_distance)) {
+        voxel.distance = std::min(voxel.distance, submap_esdf_distance);
+        voxel.observed = true;
+      }
+    }
+  }
+  block_ptr->has_data() = true;
+}
+
+void VoxgraphGlobalEsdfCache::removeCacheBlock(
+    const voxblox::BlockIndex& block_index) {
+  cache_layer_.removeBlock(block_index);
+  auto block_info_it = cache_block_infos_.find(block_index);
+  if (block_info_it == cache_block_infos_.end()) {
+    return;
+  }
+  lru_cache_blocks_.erase(block_info_it->second.lru_it);
+  for (const SubmapId submap_id : block_info_it->second.submap_ids) {
+    auto cache_blocks_it = submap_cache_blocks_.find(submap_id);
+    if (cache_blocks_it != submap_cache_blocks_.end()) {
+      cache_blocks_it->second.erase(block_index);
+      if (cache_blocks_it->second.empty()) {
+        submap_cache_blocks_.erase(cache_blocks_it);
+      }
+    }
+  }
+  cache_block_infos_.erase(block_info_it);
+}
+
+void VoxgraphGlobalEsdfCache::evictLeastRecentlyUsedBlocks() {
+  while (max_num_cached_blocks_ < lru_cache_blocks_.size()) {
+    // NOTE: The index is copied since removing the block erases it.
+    const voxblox::BlockIndex block_index = lru_cache_blocks_.back();
+    removeCacheBlock(block_index);
+  }
+}
+
+void VoxgraphGlobalEsdfCache::invalidateBlocksInFootprint(
+    const Transformation& T_F_submap,
+    const SubmapFootprint& submap_footprint) {
+  if (cache_layer_.getNumberOfAllocatedBlocks() == 0u) {
+    return;
+  }
+  const FloatingPoint submap_block_size = submap_footprint.block_size;
+  const Point submap_block_half_diagonal =
+      Point::Constant(0.5f * std::sqrt(3.f) * submap_block_size);
+
+  for (const voxblox::BlockIndex& submap_block_index :
+       submap_footprint.blocks) {
+    const Point t_F_submap_block_center =
+        T_F_submap * voxblox::getCenterPointFromGridIndex(submap_block_index,
+                                                          submap_block_size);
+    const auto min_block_index =
+        voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+            t_F_submap_block_center - submap_block_half_diagonal,
+            cache_layer_.block_size_inv());
+    const auto max_block_index =
+        voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+            t_F_submap_block_center + submap_block_half_diagonal,
+            cache_layer_.block_size_inv());
+    voxblox::BlockIndex block_index;
+    for (block_index.x() = min_block_index.x();
+         block_index.x() <= max_block_index.x(); ++block_index.x()) {
+      for (block_index.y() = min_block_index.y();
+           block_index.y() <= max_block_index.y(); ++block_index.y()) {
+        for (block_index.z() = min_block_index.z();
+             block_index.z() <= max_block_index.z(); ++block_index.z()) {
+          removeCacheBlock(block_index);
+        }
+      }
+    }
+  }
+}
+
+bool VoxgraphGlobalEsdfCache::submapPoseChanged(
+    const Transformation& T_F_submap_old,
+    const Transformation& T_F_submap_new) const {
+  const Transformation pose_delta = T_F_submap_old.inverse() * T_F_submap_new;
+  const FloatingPoint angle_delta = pose_delta.log().tail<3>().norm();
+  const FloatingPoint translation_delta = pose_delta.log().head<3>().norm();
+  const FloatingPoint translation_threshold = cache_layer_.voxel_size();
+
+  return (translation_threshold < translation_delta ||
+          submap_pose_rotation_threshold_ < angle_delta);
+}
+
+}  // namespace glocal_exploration
@@ -1,11 +1,21 @@
 #include "glocal_exploration_ros/mapping/voxgraph_local_area.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include <pcl/conversions.h>
 #include <pcl/point_types.h>
 #include <pcl_conversions/pcl_conversions.h>
+#include <voxblox/interpolator/interpolator.h>
 #include <voxblox/utils/evaluation_utils.h>
 #include <voxblox_ros/ptcloud_vis.h>
 
+#include <glocal_exploration/utils/morton_order.h>
 #include <glocal_exploration/utils/set_utils.h>
 
 namespace glocal_exploration {
@@ -13,7 +23,8 @@ namespace glocal_exploration {
 void VoxgraphLocalArea::update(
     const voxgraph::VoxgraphSubmapCollection& submap_collection,
     const VoxgraphSpatialHash& spatial_submap_id_hash,
-    const voxblox::EsdfMap& local_map) {
+    const voxblox::BlockIndexList& local_map_block_list,
+    const FloatingPoint local_map_block_size) {
   // Update the transform from the odom to a fixed (non-robocentric) frame
   if (submap_collection.empty()) {
     return;
@@ -22,17 +33,25 @@ void VoxgraphLocalArea::update(
       submap_collection.getSubmap(submap_collection.getFirstSubmapId())
           .getPose());
 
-  // Find the submaps that currently overlap with the local map
+  // Find the submaps that currently overlap with the local map, and the local
+  // area blocks that cover it
+  // NOTE: The spatial hash only covers observed space, so we look up all
+  //       submaps that could overlap with any part of each block.
   SubmapIdSet current_neighboring_submaps;
-  voxblox::BlockIndexList local_map_block_list;
-  local_map.getEsdfLayer().getAllAllocatedBlocks(&local_map_block_list);
+  voxblox::IndexSet new_footprint;
+  const FloatingPoint block_half_diagonal =
+      0.5f * std::sqrt(3.f) * local_map_block_size;
   for (const voxblox::BlockIndex& block_index : local_map_block_list) {
     const voxblox::Point t_O_block = voxblox::getCenterPointFromGridIndex(
-        block_index, local_map.block_size());
+        block_index, local_map_block_size);
     for (const voxgraph::SubmapID submap_id :
-         spatial_submap_id_hash.getSubmapsAtPosition(t_O_block)) {
+         spatial_submap_id_hash.getSubmapsNearPosition(t_O_block,
+                                                       block_half_diagonal)) {
       current_neighboring_submaps.insert(submap_id);
     }
+    addBlocksInBox(
+        fixed_frame_transformer_.transformFromOdomToFixedFrame(t_O_block),
+        Point::Constant(block_half_diagonal), &new_footprint);
   }
 
   // Get the submaps that used to overlap with the local area
@@ -67,56 +86,83 @@ void VoxgraphLocalArea::update(
   }
 
   // Deintegrate submaps (at old pose)
-  for (const SubmapId& submap_id : submaps_to_deintegrate) {
-    const voxblox::Layer<TsdfVoxel>& submap_tsdf =
-        submap_collection.getSubmap(submap_id).getTsdfMap().getTsdfLayer();
-    deintegrateSubmap(submap_id, submap_tsdf);
+  deintegrateSubmaps(submaps_to_deintegrate);
+
+  // Drop the blocks that left the local map's footprint
+  size_t num_exited_blocks = 0u;
+  for (const voxblox::BlockIndex& block_index : footprint_) {
+    if (!new_footprint.count(block_index)) {
+      local_area_layer_.removeBlock(block_index);
+      observed_voxel_counts_.erase(block_index);
+      changed_blocks_.insert(block_index);
+      for (auto& submap_kv : submaps_in_local_area_) {
+        submap_kv.second.resampled_tsdf->removeBlock(block_index);
+      }
+      ++num_exited_blocks;
+    }
+  }
+
+  // Extend the submaps that remain in the local area to the blocks that
+  // entered the local map's footprint
+  voxblox::IndexSet entered_blocks;
+  for (const voxblox::BlockIndex& block_index : new_footprint) {
+    if (!footprint_.count(block_index)) {
+      entered_blocks.insert(block_index);
+    }
+  }
+  footprint_ = std::move(new_footprint);
+  IntegrationJobs integration_jobs;
+  if (!entered_blocks.empty()) {
+    for (const auto& submap_kv : submaps_in_local_area_) {
+      addIntegrationJobs(
+          submap_kv.first, submap_kv.second.T_F_submap,
+          submap_collection.getSubmap(submap_kv.first)
+              .getTsdfMap()
+              .getTsdfLayer(),
+          entered_blocks, &integration_jobs);
+    }
   }
 
-  // Integrate submaps (at new pose)
-  for (const SubmapId& submap_id : submaps_to_integrate) {
+  // Integrate submaps (at new pose) over the whole footprint
+  for (const SubmapId submap_id : submaps_to_integrate) {
     const voxgraph::VoxgraphSubmap& submap =
         submap_collection.getSubmap(submap_id);
-    const Transformation T_F_submap =
-        fixed_frame_transformer_.transformFromOdomToFixedFrame(
-            submap.getPose());
     const voxblox::Layer<TsdfVoxel>& submap_tsdf =
         submap.getTsdfMap().getTsdfLayer();
-    integrateSubmap(submap_id, T_F_submap, submap_tsdf);
+    IntegratedSubmap& integrated_submap = submaps_in_local_area_[submap_id];
+    integrated_submap.T_F_submap =
+        fixed_frame_transformer_.transformFromOdomToFixedFrame(
+            submap.getPose());
+    integrated_submap.resampled_tsdf =
+        std::make_unique<voxblox::Layer<TsdfVoxel>>(
+            local_area_layer_.voxel_size(),
+            local_area_layer_.voxels_per_side());
+    addIntegrationJobs(submap_id, integrated_submap.T_F_submap, submap_tsdf,
+                       footprint_, &integration_jobs);
   }
-}
-
-void VoxgraphLocalArea::prune() {
-  size_t num_pruned_blocks = 0u;
-  voxblox::BlockIndexList blocks_indices;
-  local_area_layer_.getAllAllocatedBlocks(&blocks_indices);
-  for (const voxblox::BlockIndex& block_index : blocks_indices) {
-    const voxblox::Block<TsdfVoxel>& block =
-        local_area_layer_.getBlockByIndex(block_index);
-    bool block_contains_observed_voxels = false;
-    for (size_t linear_index = 0u; linear_index < block.num_voxels();
-         ++linear_index) {
-      const voxblox::TsdfVoxel& voxel =
-          block.getVoxelByLinearIndex(linear_index);
-      if (kTsdfObservedWeight < voxel.weight) {
-        block_contains_observed_voxels = true;
-        break;
-      }
-    }
-    if (!block_contains_observed_voxels) {
-      ++num_pruned_blocks;
-      local_area_layer_.removeBlock(block_index);
-    }
+  integrateSubmaps(submap_collection, integration_jobs);
+  if (use_voxel_state_layer_) {
+    updateVoxelStates();
+  } else {
+    changed_blocks_.clear();
   }
 
-  VLOG(3) << "Pruned " << num_pruned_blocks << " local area blocks";
+  if (!submaps_to_integrate.empty() || !submaps_to_deintegrate.empty()) {
+    VLOG(2) << "Local area: Deintegrated " << submaps_to_deintegrate.size()
+            << " and integrated " << submaps_to_integrate.size()
+            << " submaps, updated " << integration_jobs.size()
+            << " blocks and dropped " << num_exited_blocks << " blocks.";
+  }
 }
 
 VoxgraphLocalArea::VoxelState VoxgraphLocalArea::getVoxelStateAtPosition(
-    const Point& position) {
+    const Point& position) const {
   const voxblox::Point t_F_position =
       fixed_frame_transformer_.transformFromOdomToFixedFrame(position);
-  TsdfVoxel* voxel_ptr =
+  if (use_voxel_state_layer_) {
+    return voxel_states_.getVoxelState(t_F_position);
+  }
+  const TsdfVoxel* voxel_ptr =
       local_area_layer_.getVoxelPtrByCoordinates(t_F_position);
   if (voxel_ptr) {
     if (voxel_ptr->weight > kTsdfObservedWeight) {
@@ -130,23 +176,28 @@ VoxgraphLocalArea::VoxelState VoxgraphLocalArea::getVoxelStateAtPosition(
   return VoxelState::kUnknown;
 }
 
-bool VoxgraphLocalArea::isObserved(const Point& position) {
+bool VoxgraphLocalArea::isObserved(const Point& position) const {
   const voxblox::Point t_F_position =
       fixed_frame_transformer_.transformFromOdomToFixedFrame(position);
-  TsdfVoxel* voxel_ptr =
+  const TsdfVoxel* voxel_ptr =
       local_area_layer_.getVoxelPtrByCoordinates(t_F_position);
   return voxel_ptr && voxblox::utils::isObservedVoxel(*voxel_ptr);
 }
 
-void VoxgraphLocalArea::publishLocalArea(ros::Publisher local_area_pub) {
+void VoxgraphLocalArea::publishLocalArea(ros::Publisher local_area_pub) const {
   pcl::PointCloud<pcl::PointXYZI> local_area_pointcloud_msg;
   local_area_pointcloud_msg.header.stamp = ros::Time::now().toNSec() / 1000ull;
   local_area_pointcloud_msg.header.frame_id =
       fixed_frame_transformer_.getFixedFrameId();
 
-  voxblox::BlockIndexList block_indices;
-  local_area_layer_.getAllAllocatedBlocks(&block_indices);
-  for (const voxblox::BlockIndex& block_index : block_indices) {
+  // NOTE: Only blocks that contain observed voxels are kept allocated.
+  size_t num_observed_voxels = 0u;
+  for (const auto& count_kv : observed_voxel_counts_) {
+    num_observed_voxels += count_kv.second;
+  }
+  local_area_pointcloud_msg.reserve(num_observed_voxels);
+  for (const voxblox::BlockIndex& block_index :
+       morton_order::getAllAllocatedBlocks(local_area_layer_)) {
     const voxblox::Block<TsdfVoxel>& block =
         local_area_layer_.getBlockByIndex(block_index);
     for (voxblox::IndexElement linear_voxel_index = 0;
@@ -168,69 +219,312 @@ void VoxgraphLocalArea::publishLocalArea(ros::Publisher local_area_pub) {
   local_area_pub.publish(local_area_pointcloud_msg);
 }
 
-void VoxgraphLocalArea::deintegrateSubmap(
-    const SubmapId submap_id, const voxblox::Layer<TsdfVoxel>& submap_tsdf) {
-  const auto& submap_it = submaps_in_local_area_.find(submap_id);
-  CHECK(submap_it != submaps_in_local_area_.end())
-      << "Could not find submap with ID: " << submap_id;
-  const Transformation& T_F_submap_old = submap_it->second;
-  integrateSubmap(submap_id, T_F_submap_old, submap_tsdf, true);
+void VoxgraphLocalArea::addIntegrationJobs(
+    const SubmapId submap_id, const Transformation& T_F_submap,
+    const voxblox::Layer<TsdfVoxel>& submap_tsdf,
+    const voxblox::IndexSet& target_blocks,
+    IntegrationJobs* integration_jobs) const {
+  CHECK_NOTNULL(integration_jobs);
+  // Find the local area blocks that overlap with the submap's blocks
+  const Point submap_block_half_extent =
+      Point::Constant(0.5f * submap_tsdf.block_size());
+  const Point aabb_half_extent =
+      T_F_submap.getRotationMatrix().cwiseAbs() * submap_block_half_extent;
+  voxblox::IndexSet overlapping_blocks;
+  for (const voxblox::BlockIndex& submap_block_index :
+       morton_order::getAllAllocatedBlocks(submap_tsdf)) {
+    const Point t_F_submap_block_center =
+        T_F_submap * voxblox::getCenterPointFromGridIndex(
+                         submap_block_index, submap_tsdf.block_size());
+    addBlocksInBox(t_F_submap_block_center, aabb_half_extent,
+                   &overlapping_blocks);
+  }
+
+  for (const voxblox::BlockIndex& block_index : overlapping_blocks) {
+    if (target_blocks.count(block_index)) {
+      (*integration_jobs)[block_index].push_back(submap_id);
+    }
+  }
 }
 
-void VoxgraphLocalArea::integrateSubmap(
-    const SubmapId submap_id,
-    const VoxgraphLocalArea::Transformation& T_F_submap,
-    const voxblox::Layer<TsdfVoxel>& submap_tsdf, const bool deintegrate) {
-  LOG(INFO) << "Local area: " << (deintegrate ? "Deintegrating" : "Integrating")
-            << " submap " << submap_id;
-
-  voxblox::Layer<TsdfVoxel> world_frame_submap_tsdf(
-      submap_tsdf.voxel_size(), submap_tsdf.voxels_per_side());
-  voxblox::transformLayer(submap_tsdf, T_F_submap, &world_frame_submap_tsdf);
-
-  voxblox::BlockIndexList submap_blocks;
-  world_frame_submap_tsdf.getAllAllocatedBlocks(&submap_blocks);
-  for (const voxblox::BlockIndex& submap_block_index : submap_blocks) {
-    const voxblox::Block<TsdfVoxel>& submap_block =
-        world_frame_submap_tsdf.getBlockByIndex(submap_block_index);
-    voxblox::Block<TsdfVoxel>::Ptr local_area_block =
-        local_area_layer_.allocateBlockPtrByIndex(submap_block_index);
-    CHECK(local_area_block) << "Local area block allocation failed";
+void VoxgraphLocalArea::integrateSubmaps(
+    const voxgraph::VoxgraphSubmapCollection& submap_collection,
+    const IntegrationJobs& integration_jobs) {
+  struct SubmapContribution {
+    SubmapId submap_id;
+    const voxblox::Layer<TsdfVoxel>* submap_tsdf;
+    Transformation T_submap_F;
+    voxblox::Block<TsdfVoxel>::Ptr resampled_block;
+    bool resampled_block_is_empty = false;
+  };
+  struct BlockJob {
+    voxblox::BlockIndex block_index;
+    voxblox::Block<TsdfVoxel>::Ptr local_area_block;
+    std::vector<SubmapContribution> contributions;
+    int observed_voxel_delta = 0;
+  };
 
-    for (voxblox::IndexElement linear_voxel_index = 0;
-         linear_voxel_index < submap_block.num_voxels(); ++linear_voxel_index) {
-      TsdfVoxel& local_area_voxel =
-          local_area_block->getVoxelByLinearIndex(linear_voxel_index);
-      const TsdfVoxel& submap_voxel =
-          submap_block.getVoxelByLinearIndex(linear_voxel_index);
-
-      float signed_submap_voxel_weight;
-      if (deintegrate) {
-        signed_submap_voxel_weight = -submap_voxel.weight;
-      } else {
-        signed_submap_voxel_weight = submap_voxel.weight;
+  // Allocate all blocks up front, since voxblox layers are not thread-safe.
+  // Each job then exclusively owns its local area and resampled blocks.
+  // NOTE: Jobs are created in Morton order, s.t. neighboring blocks are
+  //       allocated and processed close together.
+  voxblox::BlockIndexList job_block_indices;
+  job_block_indices.reserve(integration_jobs.size());
+  for (const auto& job_kv : integration_jobs) {
+    job_block_indices.push_back(job_kv.first);
+  }
+  morton_order::sort(&job_block_indices);
+  std::vector<BlockJob> block_jobs;
+  block_jobs.reserve(integration_jobs.size());
+  for (const voxblox::BlockIndex& block_index : job_block_indices) {
+    BlockJob block_job;
+    block_job.block_index = block_index;
+    block_job.local_area_block =
+        local_area_layer_.allocateBlockPtrByIndex(block_index);
+    CHECK(block_job.local_area_block) << "Local area block allocation failed";
+    for (const SubmapId submap_id : integration_jobs.at(block_index)) {
+      IntegratedSubmap& integrated_submap = submaps_in_local_area_[submap_id];
+      SubmapContribution contribution;
+      contribution.submap_id = submap_id;
+      contribution.submap_tsdf =
+          &submap_collection.getSubmap(submap_id).getTsdfMap().getTsdfLayer();
+      contribution.T_submap_F = integrated_submap.T_F_submap.inverse();
+      contribution.resampled_block =
+          integrated_submap.resampled_tsdf->allocateBlockPtrByIndex(
+              block_index);
+      block_job.contributions.emplace_back(std::move(contribution));
+    }
+    block_jobs.emplace_back(std::move(block_job));
+  }
+
+  // Resample the submaps into the fixed frame and merge them, in parallel
+  parallelFor(block_jobs.size(), [&](size_t job_index) {
+    BlockJob& block_job = block_jobs[job_index];
+    for (SubmapContribution& contribution : block_job.contributions) {
+      const voxblox::Interpolator<TsdfVoxel> interpolator(
+          contribution.submap_tsdf);
+      voxblox::Block<TsdfVoxel>& resampled_block =
+          *contribution.resampled_block;
+      size_t num_observed_voxels = 0u;
+      for (size_t linear_index = 0u;
+           linear_index < resampled_block.num_voxels(); ++linear_index) {
+        const Point t_submap_voxel =
+            contribution.T_submap_F *
+            resampled_block.computeCoordinatesFromLinearIndex(linear_index);
+        TsdfVoxel& resampled_voxel =
+            resampled_block.getVoxelByLinearIndex(linear_index);
+        if (!interpolator.getVoxel(t_submap_voxel, &resampled_voxel, true)) {
+          resampled_voxel = TsdfVoxel();
+        } else if (kTsdfObservedWeight < resampled_voxel.weight) {
+          ++num_observed_voxels;
+        }
+      }
+      if (num_observed_voxels == 0u) {
+        contribution.resampled_block_is_empty = true;
+        continue;
       }
+      resampled_block.has_data() = true;
+      block_job.observed_voxel_delta += mergeBlock(
+          resampled_block, false, block_job.local_area_block.get());
+    }
+  });
 
-      float combined_weight =
-          local_area_voxel.weight + signed_submap_voxel_weight;
-      if (combined_weight > kTsdfObservedWeight) {
-        local_area_voxel.distance =
-            (submap_voxel.distance * signed_submap_voxel_weight +
-             local_area_voxel.distance * local_area_voxel.weight) /
-            combined_weight;
-        local_area_voxel.weight = combined_weight;
-      } else {
-        local_area_voxel.distance = 0.f;
-        local_area_voxel.weight = 0.f;
+  // Release the blocks that turned out to be empty
+  for (const BlockJob& block_job : block_jobs) {
+    for (const SubmapContribution& contribution : block_job.contributions) {
+      if (contribution.resampled_block_is_empty) {
+        submaps_in_local_area_[contribution.submap_id]
+            .resampled_tsdf->removeBlock(block_job.block_index);
       }
     }
+    updateObservedVoxelCount(block_job.block_index,
+                             block_job.observed_voxel_delta);
+  }
+}
+
+void VoxgraphLocalArea::deintegrateSubmaps(const SubmapIdSet& submap_ids) {
+  // Group the cached resampled blocks by the local area block they were merged
+  // into, s.t. each job exclusively owns its local area block
+  using BlockPtrList = std::vector<voxblox::Block<TsdfVoxel>::Ptr>;
+  voxblox::AnyIndexHashMapType<BlockPtrList>::type resampled_blocks_by_index;
+  for (const SubmapId submap_id : submap_ids) {
+    const auto submap_it = submaps_in_local_area_.find(submap_id);
+    CHECK(submap_it != submaps_in_local_area_.end())
+        << "Could not find submap with ID: " << submap_id;
+    voxblox::BlockIndexList resampled_block_indices;
+    submap_it->second.resampled_tsdf->getAllAllocatedBlocks(
+        &resampled_block_indices);
+    for (const voxblox::BlockIndex& block_index : resampled_block_indices) {
+      resampled_blocks_by_index[block_index].push_back(
+          submap_it->second.resampled_tsdf->getBlockPtrByIndex(block_index));
+    }
+  }
+
+  struct BlockJob {
+    voxblox::BlockIndex block_index;
+    voxblox::Block<TsdfVoxel>::Ptr local_area_block;
+    const BlockPtrList* resampled_blocks;
+    int observed_voxel_delta = 0;
+  };
+  std::vector<BlockJob> block_jobs;
+  for (const auto& resampled_blocks_kv : resampled_blocks_by_index) {
+    BlockJob block_job;
+    block_job.block_index = resampled_blocks_kv.first;
+    block_job.local_area_block =
+        local_area_layer_.getBlockPtrByIndex(resampled_blocks_kv.first);
+    block_job.resampled_blocks = &resampled_blocks_kv.second;
+    if (block_job.local_area_block) {
+      block_jobs.emplace_back(std::move(block_job));
+    }
+  }
+  std::sort(block_jobs.begin(), block_jobs.end(),
+            [](const BlockJob& lhs, const BlockJob& rhs) {
+              return morton_order::encode(lhs.block_index) <
+                     morton_order::encode(rhs.block_index);
+            });
+  parallelFor(block_jobs.size(), [&](size_t job_index) {
+    BlockJob& block_job = block_jobs[job_index];
+    for (const voxblox::Block<TsdfVoxel>::Ptr& resampled_block :
+         *block_job.resampled_blocks) {
+      block_job.observed_voxel_delta += mergeBlock(
+          *resampled_block, true, block_job.local_area_block.get());
+    }
+  });
+
+  // Release the local area blocks that no longer contain observed voxels
+  for (const BlockJob& block_job : block_jobs) {
+    updateObservedVoxelCount(block_job.block_index,
+                             block_job.observed_voxel_delta);
   }
 
   // Update the record of what submaps currently are in the local area
-  if (deintegrate) {
+  for (const SubmapId submap_id : submap_ids) {
     submaps_in_local_area_.erase(submap_id);
-  } else {
-    submaps_in_local_area_.emplace(submap_id, T_F_submap);
+  }
+}
+
+void VoxgraphLocalArea::updateObservedVoxelCount(
+    const voxblox::BlockIndex& block_index, const int observed_voxel_delta) {
+  changed_blocks_.insert(block_index);
+  int& observed_voxel_count = observed_voxel_counts_[block_index];
+  observed_voxel_count += observed_voxel_delta;
+  CHECK_GE(observed_voxel_count, 0)
+      << "Observed voxel count of local area block became negative.";
+  if (observed_voxel_count == 0) {
+    observed_voxel_counts_.erase(block_index);
+    local_area_layer_.removeBlock(block_index);
+  }
+}
+
+void VoxgraphLocalArea::updateVoxelStates() {
+  const voxblox::BlockIndexList changed_blocks =
+      morton_order::getSortedBlockIndices(changed_blocks_);
+  changed_blocks_.clear();
+  std::vector<VoxelStateLayer::PackedBlockConstPtr> packed_blocks(
+      changed_blocks.size());
+  parallelFor(changed_blocks.size(), [&](size_t job_index) {
+    const auto block_ptr =
+        local_area_layer_.getBlockPtrByIndex(changed_blocks[job_index]);
+    if (block_ptr) {
+      packed_blocks[job_index] = VoxelStateLayer::packBlock(
+          *block_ptr, local_area_layer_.voxel_size(), kTsdfObservedWeight);
+    }
+  });
+  for (size_t i = 0u; i < changed_blocks.size(); ++i) {
+    if (packed_blocks[i]) {
+      voxel_states_.setBlock(changed_blocks[i], std::move(packed_blocks[i]));
+    } else {
+      voxel_states_.removeBlock(changed_blocks[i]);
+    }
+  }
+}
+
+int VoxgraphLocalArea::mergeBlock(
+    const voxblox::Block<TsdfVoxel>& submap_block, const bool deintegrate,
+    voxblox::Block<TsdfVoxel>* local_area_block) {
+  CHECK_NOTNULL(local_area_block);
+  int observed_voxel_delta = 0;
+  for (size_t linear_voxel_index = 0u;
+       linear_voxel_index < submap_block.num_voxels(); ++linear_voxel_index) {
+    TsdfVoxel& local_area_voxel =
+        local_area_block->getVoxelByLinearIndex(linear_voxel_index);
+    const TsdfVoxel& submap_voxel =
+        submap_block.getVoxelByLinearIndex(linear_voxel_index);
+    const bool was_observed = kTsdfObservedWeight < local_area_voxel.weight;
+
+    float signed_submap_voxel_weight;
+    if (deintegrate) {
+      signed_submap_voxel_weight = -submap_voxel.weight;
+    } else {
+      signed_submap_voxel_weight = submap_voxel.weight;
+    }
+
+    float combined_weight =
+        local_area_voxel.weight + signed_submap_voxel_weight;
+    if (combined_weight > kTsdfObservedWeight) {
+      local_area_voxel.distance =
+          (submap_voxel.distance * signed_submap_voxel_weight +
+           local_area_voxel.distance * local_area_voxel.weight) /
+          combined_weight;
+      local_area_voxel.weight = combined_weight;
+      observed_voxel_delta += was_observed ? 0 : 1;
+    } else {
+      local_area_voxel.distance = 0.f;
+      local_area_voxel.weight = 0.f;
+      observed_voxel_delta -= was_observed ? 1 : 0;
+    }
+  }
+  return observed_voxel_delta;
+}
+
+void VoxgraphLocalArea::addBlocksInBox(
+    const Point& t_F_box_center, const Point& aabb_half_extent,
+    voxblox::IndexSet* block_indices) const {
+  CHECK_NOTNULL(block_indices);
+  const auto min_block_index =
+      voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+          t_F_box_center - aabb_half_extent,
+          local_area_layer_.block_size_inv());
+  const auto max_block_index =
+      voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+          t_F_box_center + aabb_half_extent,
+          local_area_layer_.block_size_inv());
+  voxblox::BlockIndex block_index;
+  for (block_index.x() = min_block_index.x();
+       block_index.x() <= max_block_index.x(); ++block_index.x()) {
+    for (block_index.y() = min_block_index.y();
+         block_index.y() <= max_block_index.y(); ++block_index.y()) {
+      for (block_index.z() = min_block_index.z();
+           block_index.z() <= max_block_index.z(); ++block_index.z()) {
+        block_indices->insert(block_index);
+      }
+    }
+  }
+}
+
+void VoxgraphLocalArea::parallelFor(
+    size_t num_jobs, const std::function<void(size_t)>& job) const {
+  std::atomic<size_t> next_job_index(0u);
+  auto worker = [&]() {
+    for (size_t job_index = next_job_index++; job_index < num_jobs;
+         job_index = next_job_index++) {
+      job(job_index);
+    }
+  };
+  // NOTE: The calling thread also works instead of just waiting.
+  size_t num_helpers = 0u;
+  if (integration_thread_pool_ && 1u < num_jobs) {
+    num_helpers =
+        std::min(num_jobs - 1u, integration_thread_pool_->getNumThreads());
+  }
+  std::vector<std::future<void>> helpers;
+  helpers.reserve(num_helpers);
+  for (size_t helper_idx = 0u; helper_idx < num_helpers; ++helper_idx) {
+    helpers.emplace_back(integration_thread_pool_->submit(worker));
+  }
+  worker();
+  for (std::future<void>& helper : helpers) {
+    helper.wait();
   }
 }
 
@@ -243,16 +537,15 @@ bool VoxgraphLocalArea::submapPoseChanged(
                     "yet been integrated. This should never happen.";
     return false;
   }
-  const Transformation& T_F_submap_old = submap_old_it->second;
+  const Transformation& T_F_submap_old = submap_old_it->second.T_F_submap;
 
   const Transformation pose_delta = T_F_submap_old.inverse() * T_F_submap_new;
   const FloatingPoint angle_delta = pose_delta.log().tail<3>().norm();
   const FloatingPoint translation_delta = pose_delta.log().head<3>().norm();
-  constexpr FloatingPoint kAngleThresholdRad = 0.0523599f;  // 3 degrees
   const FloatingPoint translation_threshold = local_area_layer_.voxel_size();
 
   return (translation_threshold < translation_delta ||
-          kAngleThresholdRad < angle_delta);
+          submap_pose_rotation_threshold_ < angle_delta);
 }
 
 }  // namespace glocal_exploration
@@ -1,8 +1,11 @@
 #include "glocal_exploration_ros/mapping/voxgraph_map.h"
 
 #include <algorithm>
+#include <cmath>
+#include <future>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -10,6 +13,7 @@
 #include <pcl/point_types.h>
 #include <voxblox_ros/ptcloud_vis.h>
 
+#include <glocal_exploration/mapping/esdf_interpolator.h>
 #include <glocal_exploration/planning/global/submap_frontier_evaluator.h>
 #include <glocal_exploration/state/communicator.h>
 
@@ -21,11 +25,33 @@ VoxgraphMap::Config::Config() { setConfigName("VoxgraphMap"); }
 
 void VoxgraphMap::Config::checkParams() const {
   checkParamGT(traversability_radius, 0.f, "traversability_radius");
+  checkParamGT(spatial_hash_resolution, 0.f, "spatial_hash_resolution");
+  checkParamGT(local_area_num_threads, 0, "local_area_num_threads");
+  checkParamGT(global_query_num_threads, 0, "global_query_num_threads");
+  // NOTE: A single query can touch up to 8 cache blocks.
+  checkParamGE(global_esdf_cache_max_num_blocks, 8,
+               "global_esdf_cache_max_num_blocks");
+  checkParamGT(compact_submap_max_distance, 0.f,
+               "compact_submap_max_distance");
+  checkParamGE(submap_pose_rotation_threshold, 0.f,
+               "submap_pose_rotation_threshold");
 }
 
 void VoxgraphMap::Config::fromRosParam() {
   rosParam("traversability_radius", &traversability_radius);
   rosParam("clearing_radius", &clearing_radius);
+  rosParam("spatial_hash_resolution", &spatial_hash_resolution);
+  rosParam("use_global_esdf_cache", &use_global_esdf_cache);
+  rosParam("global_esdf_cache_max_num_blocks",
+           &global_esdf_cache_max_num_blocks);
+  rosParam("use_compact_submap_layers", &use_compact_submap_layers);
+  rosParam("compact_submap_max_distance", &compact_submap_max_distance);
+  rosParam("local_area_num_threads", &local_area_num_threads);
+  rosParam("global_query_num_threads", &global_query_num_threads);
+  rosParam("use_block_summaries", &use_block_summaries);
+  rosParam("use_voxel_state_layer", &use_voxel_state_layer);
+  rosParam("use_frontier_tracking", &use_frontier_tracking);
+  rosParam("submap_pose_rotation_threshold", &submap_pose_rotation_threshold);
   rosParam("verbosity", &verbosity);
   nh_private_namespace = rosParamNameSpace();
 }
@@ -34,6 +60,18 @@ void VoxgraphMap::Config::printFields() const {
   printField("verbosity", verbosity);
   printField("clearing_radius", clearing_radius);
   printField("traversability_radius", traversability_radius);
+  printField("spatial_hash_resolution", spatial_hash_resolution);
+  printField("use_global_esdf_cache", use_global_esdf_cache);
+  printField("global_esdf_cache_max_num_blocks",
+             global_esdf_cache_max_num_blocks);
+  printField("use_compact_submap_layers", use_compact_submap_layers);
+  printField("compact_submap_max_distance", compact_submap_max_distance);
+  printField("local_area_num_threads", local_area_num_threads);
+  printField("global_query_num_threads", global_query_num_threads);
+  printField("use_block_summaries", use_block_summaries);
+  printField("use_voxel_state_layer", use_voxel_state_layer);
+  printField("use_frontier_tracking", use_frontier_tracking);
+  printField("submap_pose_rotation_threshold", submap_pose_rotation_threshold);
   printField("nh_private_namespace", nh_private_namespace);
 }
 
@@ -41,30 +79,83 @@ VoxgraphMap::VoxgraphMap(const Config& config,
                          const std::shared_ptr<Communicator>& communicator)
     : MapBase(communicator),
       config_(config.checkValid()),
-      local_area_needs_update_(false) {
+      local_area_needs_update_(false),
+      shutdown_local_area_worker_(false),
+      voxgraph_spatial_hash_(config_.spatial_hash_resolution) {
   LOG_IF(INFO, config_.verbosity >= 1) << "\n" + config_.toString();
   // Launch the sliding window local map and global map servers
   ros::NodeHandle nh(ros::names::parentNamespace(config_.nh_private_namespace));
   ros::NodeHandle nh_private(config_.nh_private_namespace);
   voxblox_server_ = std::make_unique<ThreadsafeVoxbloxServer>(nh, nh_private);
   voxgraph_server_ = std::make_unique<ThreadsafeVoxgraphServer>(nh, nh_private);
+  if (config_.use_block_summaries) {
+    voxblox_server_->enableBlockSummaries();
+  }
+  if (config_.use_voxel_state_layer) {
+    voxblox_server_->enableVoxelStateLayer();
+  }
+  if (config_.use_frontier_tracking) {
+    voxblox_server_->enableFrontierTracking();
+  }
 
-  // Setup the local area
-  local_area_ = std::make_unique<VoxgraphLocalArea>(
-      voxblox::getTsdfMapConfigFromRosParam(nh_private));
-  voxblox_server_->setExternalNewEsdfCallback(
-      [&] { local_area_needs_update_ = true; });
+  // Setup the double buffered local area
+  // NOTE: The local area worker thread also integrates, so the pool only
+  //       provides the remaining threads.
+  if (1 < config_.local_area_num_threads) {
+    local_area_thread_pool_ =
+        std::make_unique<ThreadPool>(config_.local_area_num_threads - 1);
+  }
+  const voxblox::TsdfMap::Config local_area_config =
+      voxblox::getTsdfMapConfigFromRosParam(nh_private);
+  local_area_.publish(std::make_unique<VoxgraphLocalArea>(
+      local_area_config, local_area_thread_pool_.get(),
+      config_.submap_pose_rotation_threshold, config_.use_voxel_state_layer));
+  local_area_back_buffer_ = std::make_unique<VoxgraphLocalArea>(
+      local_area_config, local_area_thread_pool_.get(),
+      config_.submap_pose_rotation_threshold, config_.use_voxel_state_layer);
+  voxblox_server_->setExternalNewEsdfCallback([&] {
+    // NOTE: This callback runs on the voxblox server's ESDF thread right after
+    //       the ESDF snapshot got refreshed.
+    voxblox::BlockIndexList local_map_blocks;
+    voxblox_server_->getEsdfMapSnapshot()
+        ->getEsdfLayer()
+        .getAllAllocatedBlocks(&local_map_blocks);
+    {
+      std::lock_guard<std::mutex> worker_lock(local_area_worker_mutex_);
+      local_map_blocks_ = std::move(local_map_blocks);
+      local_area_needs_update_ = true;
+    }
+    local_area_worker_cv_.notify_one();
+  });
   local_area_pub_ = nh_private.advertise<pcl::PointCloud<pcl::PointXYZI>>(
       "local_area", 1, true);
-  local_area_pruning_timer_ = nh_private.createTimer(
-      ros::Duration(local_area_pruning_period_s_),
-      std::bind(&VoxgraphLocalArea::prune, local_area_.get()));
 
   // Setup the spatial hash
   voxgraph_spatial_hash_pub_ =
       nh_private.advertise<visualization_msgs::MarkerArray>("spatial_hash", 1,
                                                             true);
 
+  // Setup the compact copies of the finished submaps
+  if (config_.use_compact_submap_layers) {
+    compact_submap_store_ = std::make_unique<VoxgraphCompactSubmapStore>(
+        config_.compact_submap_max_distance);
+  }
+
+  // Setup the workers for batched global map queries
+  if (1 < config_.global_query_num_threads) {
+    global_query_thread_pool_ =
+        std::make_unique<ThreadPool>(config_.global_query_num_threads);
+  }
+
+  // Setup the global ESDF cache
+  if (config_.use_global_esdf_cache) {
+    global_esdf_cache_ = std::make_unique<VoxgraphGlobalEsdfCache>(
+        voxblox::getEsdfMapConfigFromRosParam(nh_private),
+        config_.submap_pose_rotation_threshold,
+        static_cast<size_t>(config_.global_esdf_cache_max_num_blocks),
+        compact_submap_store_.get());
+  }
+
   // Setup the new voxgraph submap callback
   voxgraph_server_->setExternalNewSubmapCallback([&] {
     // Update the spatial submap ID hash
@@ -73,6 +164,20 @@ VoxgraphMap::VoxgraphMap(const Config& config,
       voxgraph_spatial_hash_.publishSpatialHash(voxgraph_spatial_hash_pub_);
     }
 
+    // Compact the new submap for the global planner
+    if (compact_submap_store_) {
+      compact_submap_store_->update(voxgraph_server_->getSubmapCollection());
+    }
+    if (config_.use_block_summaries) {
+      updateSubmapBlockSummaries();
+    }
+
+    // Invalidate the cached global ESDF blocks affected by new or moved submaps
+    if (global_esdf_cache_) {
+      global_esdf_cache_->update(voxgraph_server_->getSubmapCollection());
+    }
+    reportMovedSubmaps();
+
     // If the global planner is a frontier based planner we compute the frontier
     // candidates every time a submap is finished to reduce overhead when
     // switching to global planning.
@@ -81,13 +186,12 @@ VoxgraphMap::VoxgraphMap(const Config& config,
     if (frontier_evaluator) {
       SubmapData datum;
       datum.id = voxgraph_server_->getSubmapCollection().getLastSubmapId();
-      // Copy construct the submap s.t. the local are
-      datum.tsdf_layer =
-          std::make_shared<const voxblox::Layer<voxblox::TsdfVoxel>>(
-              voxgraph_server_->getSubmapCollection()
-                  .getSubmap(datum.id)
-                  .getTsdfMap()
-                  .getTsdfLayer());
+      datum.tsdf_layer = getTsdfLayerHandle(
+          voxgraph_server_->getSubmapCollection().getSubmapConstPtr(datum.id));
+      if (compact_submap_store_) {
+        datum.compact_layer = compact_submap_store_->getLayer(datum.id);
+      }
+      datum.block_summary = getSubmapBlockSummary(datum.id);
       Point initial_point(0.0, 0.0, 0.0);  // The origin is always free space.
       frontier_evaluator->computeFrontiersForSubmap(datum, initial_point);
     }
@@ -111,6 +215,9 @@ VoxgraphMap::VoxgraphMap(const Config& config,
   // Cached params
   c_voxel_size_ = voxblox_server_->getEsdfMapPtr()->voxel_size();
   c_block_size_ = voxblox_server_->getEsdfMapPtr()->block_size();
+
+  // Start maintaining the local area in the background
+  local_area_worker_ = std::thread(&VoxgraphMap::localAreaWorkerLoop, this);
 }
 
 bool VoxgraphMap::isTraversableInActiveSubmap(
@@ -144,8 +251,18 @@ MapBase::VoxelState VoxgraphMap::getVoxelStateInLocalArea(
   //       pointcloud comes in (e.g. at 10Hz).
 
   // Start by checking the state in active submap
+  // NOTE: The packed layer looks up the nearest voxel instead of interpolating
+  //       the ESDF, which is accurate enough for the gain computation.
+  const VoxelStateLayer::ConstPtr voxel_states =
+      config_.use_voxel_state_layer ? voxblox_server_->getVoxelStateLayer()
+                                    : nullptr;
   FloatingPoint distance;
-  if (getDistanceInActiveSubmap(position, &distance)) {
+  if (voxel_states) {
+    const VoxelState state = voxel_states->getVoxelState(position);
+    if (state != VoxelState::kUnknown) {
+      return state;
+    }
+  } else if (getDistanceInActiveSubmap(position, &distance)) {
     // If getDistanceAtPosition(...) returns true, the voxel is observed
     if (distance > c_voxel_size_) {
       return VoxelState::kFree;
@@ -153,46 +270,79 @@ MapBase::VoxelState VoxgraphMap::getVoxelStateInLocalArea(
     return VoxelState::kOccupied;
   }
 
-  updateLocalAreaIfNeeded();
-  return local_area_->getVoxelStateAtPosition(position);
+  return local_area_.read()->getVoxelStateAtPosition(position);
 }
 
-void VoxgraphMap::updateLocalAreaIfNeeded() {
-  if (local_area_needs_update_) {
-    CHECK_NOTNULL(local_area_);
+VoxgraphMap::~VoxgraphMap() {
+  {
+    std::lock_guard<std::mutex> worker_lock(local_area_worker_mutex_);
+    shutdown_local_area_worker_ = true;
+  }
+  local_area_worker_cv_.notify_one();
+  if (local_area_worker_.joinable()) {
+    local_area_worker_.join();
+  }
+}
 
-    local_area_->update(voxgraph_server_->getSubmapCollection(),
-                        voxgraph_spatial_hash_,
-                        *voxblox_server_->getEsdfMapPtr());
-    local_area_needs_update_ = false;
+void VoxgraphMap::localAreaWorkerLoop() {
+  while (true) {
+    // Wait until the local map changed
+    voxblox::BlockIndexList local_map_blocks;
+    {
+      std::unique_lock<std::mutex> worker_lock(local_area_worker_mutex_);
+      local_area_worker_cv_.wait(worker_lock, [&] {
+        return local_area_needs_update_ || shutdown_local_area_worker_;
+      });
+      if (shutdown_local_area_worker_) {
+        return;
+      }
+      local_map_blocks = std::move(local_map_blocks_);
+      local_area_needs_update_ = false;
+    }
+
+    // Bring the back buffer up to date while the planners keep reading the
+    // front buffer
+    {
+      const auto submap_lock = lockSubmaps();
+      local_area_back_buffer_->update(voxgraph_server_->getSubmapCollection(),
+                                      voxgraph_spatial_hash_, local_map_blocks,
+                                      c_block_size_);
+    }
+
+    // Swap the buffers
+    // NOTE: The previous front buffer becomes the new back buffer. It is one
+    //       version behind, which the next update will catch up on.
+    local_area_back_buffer_ =
+        local_area_.exchange(std::move(local_area_back_buffer_));
 
     if (0 < local_area_pub_.getNumSubscribers()) {
-      local_area_->publishLocalArea(local_area_pub_);
+      local_area_.read()->publishLocalArea(local_area_pub_);
     }
   }
 }
 
 bool VoxgraphMap::isObservedInGlobalMap(const Point& position) {
   // Start by checking the state in active submap
-  if (voxblox_server_->getEsdfMapPtr()->isObserved(position.cast<double>())) {
+  const auto esdf_layer = voxblox_server_->getEsdfLayerSnapshot();
+  if (esdf_layer && EsdfInterpolator(*esdf_layer).isObserved(position)) {
     return true;
   }
 
   // Then fall back to local area
-  updateLocalAreaIfNeeded();
-  if (local_area_->isObserved(position)) {
+  if (local_area_.read()->isObserved(position)) {
     return true;
   }
 
   // As a last resort, check the submaps in the global map that overlap with
   // the queried position
+  const auto submap_lock = lockSubmaps();
   for (const voxgraph::SubmapID submap_id :
        voxgraph_spatial_hash_.getSubmapsAtPosition(position)) {
     voxgraph::VoxgraphSubmap::ConstPtr submap_ptr =
         voxgraph_server_->getSubmapCollection().getSubmapConstPtr(submap_id);
     if (submap_ptr) {
       Point local_position = submap_ptr->getPose().inverse() * position;
-      if (submap_ptr->getEsdfMap().isObserved(local_position.cast<double>())) {
+      if (isObservedInSubmap(*submap_ptr, local_position)) {
         return true;
       }
     }
@@ -200,6 +350,151 @@ bool VoxgraphMap::isObservedInGlobalMap(const Point& position) {
   return false;
 }
 
+void VoxgraphMap::reportMovedSubmaps() {
+  // NOTE: The space observed in new submaps was already observed in the active
+  //       submap, so only moved submaps change the global map's observed space.
+  bool submaps_moved = false;
+  for (const voxgraph::VoxgraphSubmap::ConstPtr& submap_ptr :
+       voxgraph_server_->getSubmapCollection().getSubmapConstPtrs()) {
+    const Transformation& T_M_S_new = submap_ptr->getPose();
+    auto it = observed_space_submap_poses_.find(submap_ptr->getID());
+    if (it == observed_space_submap_poses_.end()) {
+      observed_space_submap_poses_.emplace(submap_ptr->getID(), T_M_S_new);
+      continue;
+    }
+    const Transformation pose_delta = it->second.inverse() * T_M_S_new;
+    if (c_voxel_size_ < pose_delta.log().head<3>().norm() ||
+        config_.submap_pose_rotation_threshold <
+            pose_delta.log().tail<3>().norm()) {
+      it->second = T_M_S_new;
+      submaps_moved = true;
+    }
+  }
+  if (submaps_moved) {
+    voxblox_server_->markEverythingChanged();
+  }
+}
+
+void VoxgraphMap::areObservedInGlobalMap(const std::vector<Point>& positions,
+                                         std::vector<bool>* is_observed) {
+  CHECK_NOTNULL(is_observed);
+  // Group the positions by mission frame block
+  voxblox::AnyIndexHashMapType<std::vector<size_t>>::type position_groups;
+  const FloatingPoint block_size_inv = 1.f / c_block_size_;
+  for (size_t i = 0u; i < positions.size(); ++i) {
+    position_groups[voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+                        positions[i], block_size_inv)]
+        .emplace_back(i);
+  }
+  std::vector<std::pair<voxblox::BlockIndex, std::vector<size_t>>> blocks(
+      position_groups.begin(), position_groups.end());
+
+  // Check the blocks, in parallel if enabled
+  // NOTE: Each block only writes the results of its own positions, which are
+  //       stored as bytes since std::vector<bool> packs them into shared words.
+  std::vector<uint8_t> is_observed_bytes(positions.size(), 0u);
+  const auto esdf_layer = voxblox_server_->getEsdfLayerSnapshot();
+  std::unique_ptr<EsdfInterpolator> active_submap_esdf;
+  if (esdf_layer) {
+    active_submap_esdf = std::make_unique<EsdfInterpolator>(*esdf_layer);
+  }
+  const auto check_blocks = [&](const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      areObservedInGlobalMapBlock(blocks[i].first, blocks[i].second, positions,
+                                  active_submap_esdf.get(), &is_observed_bytes);
+    }
+  };
+  if (global_query_thread_pool_ && 1u < blocks.size()) {
+    const size_t num_chunks = std::min(
+        blocks.size(), 4u * global_query_thread_pool_->getNumThreads());
+    std::vector<std::future<void>> chunks;
+    chunks.reserve(num_chunks);
+    for (size_t chunk = 0u; chunk < num_chunks; ++chunk) {
+      chunks.emplace_back(global_query_thread_pool_->submit(
+          [&check_blocks, &blocks, chunk, num_chunks] {
+            check_blocks(chunk * blocks.size() / num_chunks,
+                         (chunk + 1u) * blocks.size() / num_chunks);
+          }));
+    }
+    for (std::future<void>& chunk : chunks) {
+      chunk.wait();
+    }
+  } else {
+    check_blocks(0u, blocks.size());
+  }
+  is_observed->assign(is_observed_bytes.begin(), is_observed_bytes.end());
+}
+
+void VoxgraphMap::areObservedInGlobalMapBlock(
+    const voxblox::BlockIndex& block_index,
+    const std::vector<size_t>& position_indices,
+    const std::vector<Point>& positions,
+    const EsdfInterpolator* active_submap_esdf,
+    std::vector<uint8_t>* is_observed) {
+  CHECK_NOTNULL(is_observed);
+  // Same order as isObservedInGlobalMap(...), but every source is only
+  // resolved once for all positions in the block
+  std::vector<size_t> unobserved_indices;
+  unobserved_indices.reserve(position_indices.size());
+  for (const size_t i : position_indices) {
+    if (active_submap_esdf && active_submap_esdf->isObserved(positions[i])) {
+      (*is_observed)[i] = 1u;
+    } else {
+      unobserved_indices.emplace_back(i);
+    }
+  }
+  const auto mark_observed_if = [&](auto is_observed_at) {
+    unobserved_indices.erase(
+        std::remove_if(unobserved_indices.begin(), unobserved_indices.end(),
+                       [&](const size_t i) {
+                         if (is_observed_at(positions[i])) {
+                           (*is_observed)[i] = 1u;
+                           return true;
+                         }
+                         return false;
+                       }),
+        unobserved_indices.end());
+    return unobserved_indices.empty();
+  };
+  {
+    const auto local_area = local_area_.read();
+    if (unobserved_indices.empty() ||
+        mark_observed_if([&local_area](const Point& position) {
+          return local_area->isObserved(position);
+        })) {
+      return;
+    }
+  }
+
+  // Resolve the overlapping submaps, their poses and layers once per block
+  const auto submap_lock = lockSubmaps();
+  const Point block_center =
+      voxblox::getCenterPointFromGridIndex(block_index, c_block_size_);
+  const FloatingPoint block_half_diagonal =
+      0.5f * std::sqrt(3.f) * c_block_size_;
+  for (const voxgraph::SubmapID submap_id :
+       voxgraph_spatial_hash_.getSubmapsNearPosition(block_center,
+                                                     block_half_diagonal)) {
+    voxgraph::VoxgraphSubmap::ConstPtr submap_ptr =
+        voxgraph_server_->getSubmapCollection().getSubmapConstPtr(submap_id);
+    if (!submap_ptr) {
+      continue;
+    }
+    const Transformation T_S_M = submap_ptr->getPose().inverse();
+    const CompactSubmapLayer::ConstPtr compact_layer =
+        compact_submap_store_ ? compact_submap_store_->getLayer(submap_id)
+                              : nullptr;
+    const bool all_observed = mark_observed_if([&](const Point& position) {
+      const Point local_position = T_S_M * position;
+      return compact_layer ? compact_layer->isObserved(local_position)
+                           : isObservedInSubmap(*submap_ptr, local_position);
+    });
+    if (all_observed) {
+      return;
+    }
+  }
+}
+
 bool VoxgraphMap::isTraversableInGlobalMap(
     const Point& position, const FloatingPoint traversability_radius) {
   if (!comm_->regionOfInterest()->contains(position)) {
@@ -207,29 +502,41 @@ bool VoxgraphMap::isTraversableInGlobalMap(
   }
 
   // Discard early if the point isn't traversable in the local area.
-  // NOTE: It's not worth it to update the local area just for this. So only
-  //       do it if it already happens to be ready.
-  if (!local_area_needs_update_) {
-    // NOTE: We can only check whether the local area is not occupied. Since the
-    //       local area only consists of a TSDF (no ESDF) and the traversability
-    //       radius generally exceeds the TSDF truncation distance.
-    if (local_area_->getVoxelStateAtPosition(position) ==
-        VoxelState::kOccupied) {
-      return false;
+  // NOTE: We can only check whether the local area is not occupied. Since the
+  //       local area only consists of a TSDF (no ESDF) and the traversability
+  //       radius generally exceeds the TSDF truncation distance.
+  if (local_area_.read()->getVoxelStateAtPosition(position) ==
+      VoxelState::kOccupied) {
+    return false;
+  }
+
+  const bool within_clear_sphere =
+      (position - comm_->currentPose().position).norm() <=
+      config_.clearing_radius;
+
+  // Look up the merged distance in the global ESDF cache if available
+  const auto submap_lock = lockSubmaps();
+  if (global_esdf_cache_) {
+    FloatingPoint distance = 0.f;
+    if (global_esdf_cache_->getDistanceAtPosition(
+            position, voxgraph_server_->getSubmapCollection(),
+            voxgraph_spatial_hash_, &distance)) {
+      // This means the voxel is observed.
+      return traversability_radius <= distance;
     }
+    return within_clear_sphere;
   }
 
   // Check the submaps that overlap with the queried position
   bool traversable_anywhere = false;
   for (const voxgraph::SubmapID submap_id :
        voxgraph_spatial_hash_.getSubmapsAtPosition(position)) {
-    double distance = 0.0;
+    FloatingPoint distance = 0.f;
     voxgraph::VoxgraphSubmap::ConstPtr submap_ptr =
         voxgraph_server_->getSubmapCollection().getSubmapConstPtr(submap_id);
     if (submap_ptr) {
       Point local_position = submap_ptr->getPose().inverse() * position;
-      if (submap_ptr->getEsdfMap().getDistanceAtPosition(
-              local_position.cast<double>(), &distance)) {
+      if (getDistanceInSubmap(*submap_ptr, local_position, &distance)) {
         // This means the voxel is observed.
         if (distance < traversability_radius) {
           return false;
@@ -240,26 +547,110 @@ bool VoxgraphMap::isTraversableInGlobalMap(
     }
   }
 
-  const bool within_clear_sphere =
-      (position - comm_->currentPose().position).norm() <=
-      config_.clearing_radius;
   return traversable_anywhere || within_clear_sphere;
 }
 
+bool VoxgraphMap::getDistanceInSubmap(const voxgraph::VoxgraphSubmap& submap,
+                                      const Point& t_submap_position,
+                                      FloatingPoint* distance) const {
+  CHECK_NOTNULL(distance);
+  if (compact_submap_store_) {
+    const CompactSubmapLayer::ConstPtr compact_layer =
+        compact_submap_store_->getLayer(submap.getID());
+    if (compact_layer) {
+      return compact_layer->getDistance(t_submap_position, distance);
+    }
+  }
+  return EsdfInterpolator(submap.getEsdfMap().getEsdfLayer())
+      .getDistance(t_submap_position, distance);
+}
+
+bool VoxgraphMap::isObservedInSubmap(const voxgraph::VoxgraphSubmap& submap,
+                                     const Point& t_submap_position) const {
+  if (compact_submap_store_) {
+    const CompactSubmapLayer::ConstPtr compact_layer =
+        compact_submap_store_->getLayer(submap.getID());
+    if (compact_layer) {
+      return compact_layer->isObserved(t_submap_position);
+    }
+  }
+  return EsdfInterpolator(submap.getEsdfMap().getEsdfLayer())
+      .isObserved(t_submap_position);
+}
+
+void VoxgraphMap::updateSubmapBlockSummaries() {
+  // Copy the current version, which only shares the summaries themselves
+  std::unique_ptr<SubmapBlockSummaries> new_summaries;
+  {
+    const auto summaries = submap_block_summaries_.read();
+    new_summaries = summaries
+                        ? std::make_unique<SubmapBlockSummaries>(*summaries)
+                        : std::make_unique<SubmapBlockSummaries>();
+  }
+  // NOTE: Finished submaps are frozen, so their summaries never change.
+  for (const voxgraph::VoxgraphSubmap::ConstPtr& submap_ptr :
+       voxgraph_server_->getSubmapCollection().getSubmapConstPtrs()) {
+    if (!new_summaries->count(submap_ptr->getID())) {
+      new_summaries->emplace(submap_ptr->getID(),
+                             std::make_shared<const BlockSummaryLayer>(
+                                 submap_ptr->getEsdfMap().getEsdfLayer()));
+    }
+  }
+  submap_block_summaries_.publish(std::move(new_summaries));
+}
+
+BlockSummaryLayer::ConstPtr VoxgraphMap::getSubmapBlockSummary(
+    const voxgraph::SubmapID submap_id) const {
+  const auto summaries = submap_block_summaries_.read();
+  if (!summaries) {
+    return nullptr;
+  }
+  const auto summary_it = summaries->find(submap_id);
+  return summary_it != summaries->end() ? summary_it->second : nullptr;
+}
+
+MapBase::TsdfLayerConstPtr VoxgraphMap::getTsdfLayerHandle(
+    const voxgraph::VoxgraphSubmap::ConstPtr& submap_ptr) {
+  if (!submap_ptr) {
+    return nullptr;
+  }
+  // Use shared_ptr's aliasing constructor, s.t. the handle points to the TSDF
+  // layer but shares ownership of (and thus keeps alive) the whole submap.
+  return TsdfLayerConstPtr(submap_ptr,
+                           &submap_ptr->getTsdfMap().getTsdfLayer());
+}
+
 std::vector<MapBase::SubmapData> VoxgraphMap::getAllSubmapData() {
   // Add all submap pointers and poses data for global frontier computation.
   // Since the submaps are frozen after insertion to the collection we can
   // directly use them by returning a pointer.
   std::vector<SubmapData> data;
+  const auto submap_lock = lockSubmaps();
   auto submaps = voxgraph_server_->getSubmapCollection().getSubmapConstPtrs();
   for (const auto& submap : submaps) {
     SubmapData datum;
     datum.id = submap->getID();
     datum.T_M_S = submap->getPose();
-    datum.tsdf_layer = std::make_shared<voxblox::Layer<voxblox::TsdfVoxel>>(
-        submap->getTsdfMap().getTsdfLayer());
+    datum.tsdf_layer = getTsdfLayerHandle(submap);
+    if (compact_submap_store_) {
+      datum.compact_layer = compact_submap_store_->getLayer(datum.id);
+    }
+    datum.block_summary = getSubmapBlockSummary(datum.id);
     data.push_back(datum);
   }
+
+  // Add the frontiers tracked in the active submap, s.t. the most recently
+  // explored space is considered before the submap is finished.
+  // NOTE: The active submap is queried in mission frame everywhere else too.
+  if (config_.use_frontier_tracking) {
+    SubmapData datum;
+    datum.id = kActiveSubmapId;
+    datum.T_M_S.setIdentity();
+    datum.frontier_candidates = voxblox_server_->getFrontierCandidates();
+    if (datum.frontier_candidates) {
+      data.push_back(datum);
+    }
+  }
   return data;
 }
 
@@ -364,14 +755,9 @@ bool VoxgraphMap::lineIntersectsSurfaceInActiveSubmap(const Point& start_point,
 bool VoxgraphMap::getDistanceInActiveSubmap(const Point& position,
                                             FloatingPoint* distance) const {
   CHECK_NOTNULL(distance);
-  double distance_tmp;
-  if (voxblox_server_->getEsdfMapPtr()->getDistanceAtPosition(
-          position.cast<double>(), &distance_tmp)) {
-    *distance = static_cast<FloatingPoint>(distance_tmp);
-    return true;
-  } else {
-    return false;
-  }
+  const auto esdf_layer = voxblox_server_->getEsdfLayerSnapshot();
+  return esdf_layer &&
+         EsdfInterpolator(*esdf_layer).getDistance(position, distance);
 }
 
 bool VoxgraphMap::getDistanceAndGradientInActiveSubmap(const Point& position,
@@ -379,16 +765,10 @@ bool VoxgraphMap::getDistanceAndGradientInActiveSubmap(const Point& position,
                                                        Point* gradient) const {
   CHECK_NOTNULL(distance);
   CHECK_NOTNULL(gradient);
-  double distance_tmp;
-  Eigen::Vector3d gradient_tmp;
-  if (voxblox_server_->getEsdfMapPtr()->getDistanceAndGradientAtPosition(
-          position.cast<double>(), &distance_tmp, &gradient_tmp)) {
-    *distance = static_cast<FloatingPoint>(distance_tmp);
-    *gradient = gradient_tmp.cast<FloatingPoint>();
-    return true;
-  } else {
-    return false;
-  }
+  const auto esdf_layer = voxblox_server_->getEsdfLayerSnapshot();
+  return esdf_layer &&
+         EsdfInterpolator(*esdf_layer)
+             .getDistanceAndGradient(position, distance, gradient);
 }
 
 bool VoxgraphMap::isLineTraversableInGlobalMap(
@@ -492,6 +872,14 @@ bool VoxgraphMap::getDistanceInGlobalMap(const Point& position,
     return false;
   }
 
+  // Look up the merged distance in the global ESDF cache if available
+  const auto submap_lock = lockSubmaps();
+  if (global_esdf_cache_) {
+    return global_esdf_cache_->getDistanceAtPosition(
+        position, voxgraph_server_->getSubmapCollection(),
+        voxgraph_spatial_hash_, min_esdf_distance);
+  }
+
   // Check the submaps that overlap with the queried position
   bool distance_available_anywhere = false;
   *min_esdf_distance = std::numeric_limits<FloatingPoint>::max();
@@ -501,13 +889,11 @@ bool VoxgraphMap::getDistanceInGlobalMap(const Point& position,
         voxgraph_server_->getSubmapCollection().getSubmapConstPtr(submap_id);
     if (submap_ptr) {
       Point local_position = submap_ptr->getPose().inverse() * position;
-      double submap_esdf_distance = 0.0;
-      if (submap_ptr->getEsdfMap().getDistanceAtPosition(
-              local_position.cast<double>(), &submap_esdf_distance)) {
+      FloatingPoint submap_esdf_distance = 0.f;
+      if (getDistanceInSubmap(*submap_ptr, local_position,
+                              &submap_esdf_distance)) {
         // This means the voxel is observed.
-        *min_esdf_distance =
-            std::min(*min_esdf_distance,
-                     static_cast<FloatingPoint>(submap_esdf_distance));
+        *min_esdf_distance = std::min(*min_esdf_distance, submap_esdf_distance);
         distance_available_anywhere = true;
       }
     }
@@ -519,8 +905,12 @@ bool VoxgraphMap::getDistanceInGlobalMap(const Point& position,
 std::vector<WayPoint> VoxgraphMap::getPoseHistory() const {
   std::vector<WayPoint> past_poses;
   // Add the optimized pose history from voxgraph's submap collection.
-  const std::vector<geometry_msgs::PoseStamped> past_voxgraph_poses =
-      voxgraph_server_->getSubmapCollection().getPoseHistory();
+  std::vector<geometry_msgs::PoseStamped> past_voxgraph_poses;
+  {
+    const auto submap_lock = lockSubmaps();
+    past_voxgraph_poses =
+        voxgraph_server_->getSubmapCollection().getPoseHistory();
+  }
   for (const geometry_msgs::PoseStamped& past_pose_msg : past_voxgraph_poses) {
     kindr::minimal::QuatTransformation past_pose;
     tf::poseMsgToKindr(past_pose_msg.pose, &past_pose);
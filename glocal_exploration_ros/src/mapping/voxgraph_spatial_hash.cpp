@@ -1,5 +1,8 @@
 #include "glocal_exploration_ros/mapping/voxgraph_spatial_hash.h"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -7,6 +10,9 @@
 #include <pcl_conversions/pcl_conversions.h>
 #include <visualization_msgs/MarkerArray.h>
 #include <voxblox/utils/color_maps.h>
+#include <voxblox/utils/evaluation_utils.h>
+
+#include <glocal_exploration/utils/morton_order.h>
 
 namespace glocal_exploration {
 
@@ -36,16 +42,17 @@ void VoxgraphSpatialHash::update(
   // Add the new submaps to the spatial hash
   SubmapIdSet submaps_to_add = set_utils::setDifference(
       submap_ids_in_submap_collection, submap_ids_in_spatial_hash);
+  bool hash_changed = !submaps_to_add.empty();
   for (const voxgraph::SubmapID submap_id : submaps_to_add) {
     const voxgraph::VoxgraphSubmap& submap =
         submap_collection.getSubmap(submap_id);
     const voxgraph::Transformation T_F_submap =
         fixed_frame_transformer_.transformFromOdomToFixedFrame(
             submap.getPose());
-    const voxblox::Layer<voxblox::TsdfVoxel>& submap_tsdf =
-        submap.getTsdfMap().getTsdfLayer();
+    submap_observed_boxes_[submap_id] =
+        computeObservedBoxes(submap.getTsdfMap().getTsdfLayer());
     //    ROS_INFO_STREAM("Adding submap: " << submap_id);
-    addSubmap(submap_id, T_F_submap, submap_tsdf);
+    addSubmap(submap_id, T_F_submap);
   }
 
   // NOTE: Submaps are currently never deleted from the submap collection,
@@ -62,13 +69,134 @@ void VoxgraphSpatialHash::update(
         fixed_frame_transformer_.transformFromOdomToFixedFrame(
             submap.getPose());
     if (submapPoseChanged(submap_id, T_F_submap_new)) {
-      const voxblox::Layer<voxblox::TsdfVoxel>& submap_tsdf =
-          submap.getTsdfMap().getTsdfLayer();
       //      ROS_INFO_STREAM("Moving submap: " << submap_id);
-      removeSubmap(submap_id, submap_tsdf);
-      addSubmap(submap_id, T_F_submap_new, submap_tsdf);
+      removeSubmap(submap_id);
+      addSubmap(submap_id, T_F_submap_new);
+      hash_changed = true;
+    }
+  }
+
+  // Share the new version of the hash with the readers
+  if (hash_changed) {
+    publishSnapshot();
+    const uint64_t num_queries = num_queries_;
+    VLOG(2) << "Spatial hash: " << spatial_submap_id_hash_.size()
+            << " cells at " << block_grid_size_ << "m resolution. Queries "
+            << "returned " << getAverageCandidatesPerQuery()
+            << " candidate submaps on average (" << num_queries
+            << " queries).";
+  }
+}
+
+void VoxgraphSpatialHash::publishSnapshot() {
+  // Start from the previous version, which shares all of its chunks
+  auto snapshot = std::make_unique<Snapshot>(fixed_frame_transformer_);
+  {
+    const auto previous_snapshot = snapshot_.read();
+    if (previous_snapshot) {
+      snapshot->chunks = previous_snapshot->chunks;
+    }
+  }
+
+  // Only copy the chunks that contain changed cells, and rebuild these cells
+  voxblox::AnyIndexHashMapType<voxblox::BlockIndexList>::type changed_chunks;
+  for (const voxblox::BlockIndex& cell_index : changed_cells_) {
+    changed_chunks[getChunkIndex(cell_index)].push_back(cell_index);
+  }
+  changed_cells_.clear();
+  std::vector<voxgraph::SubmapID> sorted_submap_ids;
+  for (const auto& chunk_kv : changed_chunks) {
+    auto chunk_it = snapshot->chunks.find(chunk_kv.first);
+    auto chunk = chunk_it != snapshot->chunks.end()
+                     ? std::make_shared<Chunk>(*chunk_it->second)
+                     : std::make_shared<Chunk>();
+    for (const voxblox::BlockIndex& cell_index : chunk_kv.second) {
+      const auto cell_it = spatial_submap_id_hash_.find(cell_index);
+      if (cell_it == spatial_submap_id_hash_.end() || cell_it->second.empty()) {
+        chunk->erase(cell_index);
+        continue;
+      }
+      sorted_submap_ids.assign(cell_it->second.begin(), cell_it->second.end());
+      std::sort(sorted_submap_ids.begin(), sorted_submap_ids.end());
+      auto submap_id_list = std::make_shared<SubmapIdList>();
+      for (const voxgraph::SubmapID submap_id : sorted_submap_ids) {
+        submap_id_list->push_back(submap_id);
+      }
+      (*chunk)[cell_index] = std::move(submap_id_list);
+    }
+    if (chunk->empty()) {
+      snapshot->chunks.erase(chunk_kv.first);
+    } else {
+      snapshot->chunks[chunk_kv.first] = std::move(chunk);
+    }
+  }
+  VLOG(3) << "Spatial hash: Published a version with " << changed_chunks.size()
+          << " changed out of " << snapshot->chunks.size() << " chunks.";
+
+  // NOTE: This blocks until all readers released the previous version, which
+  //       they only hold while looking up a cell.
+  snapshot_.publish(std::move(snapshot));
+}
+
+const VoxgraphSpatialHash::CellPtr* VoxgraphSpatialHash::Snapshot::findCell(
+    const voxblox::BlockIndex& cell_index) const {
+  const auto chunk_it = chunks.find(getChunkIndex(cell_index));
+  if (chunk_it == chunks.end()) {
+    return nullptr;
+  }
+  const auto cell_it = chunk_it->second->find(cell_index);
+  return cell_it != chunk_it->second->end() ? &cell_it->second : nullptr;
+}
+
+voxblox::BlockIndex VoxgraphSpatialHash::getChunkIndex(
+    const voxblox::BlockIndex& cell_index) {
+  // NOTE: Rounds towards negative infinity, unlike the integer division.
+  voxblox::BlockIndex chunk_index;
+  for (int i = 0; i < 3; ++i) {
+    chunk_index[i] = 0 <= cell_index[i]
+                         ? cell_index[i] / kChunkSize
+                         : (cell_index[i] + 1) / kChunkSize - 1;
+  }
+  return chunk_index;
+}
+
+std::vector<voxgraph::SubmapID> VoxgraphSpatialHash::getSubmapsNearPosition(
+    const Point& position, const FloatingPoint radius) const {
+  const auto snapshot = snapshot_.read();
+  if (!snapshot) {
+    return std::vector<voxgraph::SubmapID>();
+  }
+  const voxblox::Point t_F_position =
+      snapshot->fixed_frame_transformer.transformFromOdomToFixedFrame(position);
+  const auto min_block_index =
+      voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+          t_F_position - voxblox::Point::Constant(radius),
+          block_grid_size_inv_);
+  const auto max_block_index =
+      voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+          t_F_position + voxblox::Point::Constant(radius),
+          block_grid_size_inv_);
+
+  std::vector<voxgraph::SubmapID> submap_ids;
+  voxblox::BlockIndex block_index;
+  for (block_index.x() = min_block_index.x();
+       block_index.x() <= max_block_index.x(); ++block_index.x()) {
+    for (block_index.y() = min_block_index.y();
+         block_index.y() <= max_block_index.y(); ++block_index.y()) {
+      for (block_index.z() = min_block_index.z();
+           block_index.z() <= max_block_index.z(); ++block_index.z()) {
+        const CellPtr* cell = snapshot->findCell(block_index);
+        if (cell) {
+          submap_ids.insert(submap_ids.end(), (*cell)->begin(),
+                            (*cell)->end());
+        }
+      }
     }
   }
+  std::sort(submap_ids.begin(), submap_ids.end());
+  submap_ids.erase(std::unique(submap_ids.begin(), submap_ids.end()),
+                   submap_ids.end());
+  return submap_ids;
 }
 
 void VoxgraphSpatialHash::publishSpatialHash(ros::Publisher spatial_hash_pub) {
@@ -116,21 +244,18 @@ void VoxgraphSpatialHash::publishSpatialHash(ros::Publisher spatial_hash_pub) {
   spatial_hash_pub.publish(marker_array);
 }
 
-void VoxgraphSpatialHash::removeSubmap(
-    const voxgraph::SubmapID submap_id,
-    const voxblox::Layer<voxblox::TsdfVoxel>& submap_tsdf) {
+void VoxgraphSpatialHash::removeSubmap(const voxgraph::SubmapID submap_id) {
   const auto& submap_it = submaps_in_spatial_hash_.find(submap_id);
   CHECK(submap_it != submaps_in_spatial_hash_.end());
-  const voxgraph::Transformation& T_F_submap_old = submap_it->second;
-  addSubmap(submap_id, T_F_submap_old, submap_tsdf, true);
+  const voxgraph::Transformation T_F_submap_old = submap_it->second;
+  addSubmap(submap_id, T_F_submap_old, true);
 }
 
-void VoxgraphSpatialHash::addSubmap(
-    const voxgraph::SubmapID submap_id,
-    const voxgraph::Transformation& T_F_submap,
-    const voxblox::Layer<voxblox::TsdfVoxel>& submap_tsdf, const bool remove) {
-  LOG(INFO) << "Spatial hash: " << (remove ? "Removing" : "Adding")
-            << " submap " << submap_id;
+void VoxgraphSpatialHash::addSubmap(const voxgraph::SubmapID submap_id,
+                                    const voxgraph::Transformation& T_F_submap,
+                                    const bool remove) {
+  VLOG(3) << "Spatial hash: " << (remove ? "Removing" : "Adding")
+          << " submap " << submap_id;
   if (remove) {
     if (!submaps_in_spatial_hash_.count(submap_id)) {
       LOG(ERROR) << "Spatial hash: Tried to remove submap that currently isn't "
@@ -145,82 +270,64 @@ void VoxgraphSpatialHash::addSubmap(
     }
   }
 
-  // Precompute the overlapping indices based on the AABB
-  std::vector<voxblox::BlockIndex> colliding_index_offsets;
-  {
-    voxblox::Point aabb_min = voxblox::Point::Constant(INFINITY);
-    voxblox::Point aabb_max = voxblox::Point::Constant(-INFINITY);
-    for (int idx_x = 0; idx_x < 2; ++idx_x) {
-      for (int idx_y = 0; idx_y < 2; ++idx_y) {
-        for (int idx_z = 0; idx_z < 2; ++idx_z) {
-          voxblox::Point unit_cube_vertex = voxblox::Point::Zero();
-          if (idx_x) unit_cube_vertex.x() += 1.f;
-          if (idx_y) unit_cube_vertex.y() += 1.f;
-          if (idx_z) unit_cube_vertex.z() += 1.f;
-
-          const voxblox::Point rotated_unit_cube_vertex =
-              T_F_submap.getRotation().rotate(unit_cube_vertex);
-
-          aabb_min = aabb_min.cwiseMin(rotated_unit_cube_vertex);
-          aabb_max = aabb_max.cwiseMax(rotated_unit_cube_vertex);
-        }
-      }
-    }
-    const voxblox::BlockIndex aabb_min_idx =
-        aabb_min.array().floor().cast<voxblox::IndexElement>();
-    const voxblox::BlockIndex aabb_max_idx =
-        aabb_max.array().floor().cast<voxblox::IndexElement>();
-
-    // Check if the AABB is sensible
-    CHECK((aabb_min_idx.array() <= 0).all() &&
-          (0 <= aabb_max_idx.array()).all() &&
-          ((aabb_max_idx.array() - aabb_min_idx.array()) <= 3).all())
-        << "Faulty index offsets for submap " << submap_id << "\nAABB min "
-        << aabb_min.x() << ", " << aabb_min.y() << ", " << aabb_min.z()
-        << "; AABB max " << aabb_max.x() << ", " << aabb_max.y() << ", "
-        << aabb_max.z() << "\nAABB idx min " << aabb_min_idx.x() << ", "
-        << aabb_min_idx.y() << ", " << aabb_min_idx.z() << "; AABB idx max "
-        << aabb_max_idx.x() << ", " << aabb_max_idx.y() << ", "
-        << aabb_max_idx.z() << "\nat submap rotation rpy:\n"
-        << T_F_submap.getRotation().log().x() << ", "
-        << T_F_submap.getRotation().log().y() << ", "
-        << T_F_submap.getRotation().log().z();
-
-    for (int idx_x = aabb_min_idx.x(); idx_x <= aabb_max_idx.x(); ++idx_x) {
-      for (int idx_y = aabb_min_idx.y(); idx_y <= aabb_max_idx.y(); ++idx_y) {
-        for (int idx_z = aabb_min_idx.z(); idx_z <= aabb_max_idx.z(); ++idx_z) {
-          colliding_index_offsets.emplace_back(idx_x, idx_y, idx_z);
-        }
-      }
-    }
-  }
-  ROS_INFO_STREAM("Spatial hash block index offset count for submap "
-                  << submap_id << ": " << colliding_index_offsets.size());
+  // Index the cells that overlap with the observed part of each submap block,
+  // using its exact oriented bounding box in the fixed frame
+  const auto observed_boxes_it = submap_observed_boxes_.find(submap_id);
+  CHECK(observed_boxes_it != submap_observed_boxes_.end());
+  const Eigen::Matrix<FloatingPoint, 3, 3> R_F_submap =
+      T_F_submap.getRotationMatrix();
+  const Eigen::Matrix<FloatingPoint, 3, 3> R_F_submap_abs =
+      R_F_submap.cwiseAbs();
+  size_t num_cells = 0u;
 
-  voxblox::BlockIndexList submap_blocks;
-  submap_tsdf.getAllAllocatedBlocks(&submap_blocks);
-  std::lock_guard<std::mutex> spatial_hash_lock(spatial_hash_mutex_);
-  for (const voxblox::BlockIndex& submap_block_index : submap_blocks) {
-    const voxblox::Point t_submap_block_center =
-        voxblox::getCenterPointFromGridIndex(submap_block_index,
-                                             block_grid_size_);
-    const voxblox::Point t_mission_block_center =
-        T_F_submap * t_submap_block_center;
-    const auto mission_block_index =
+  for (const ObservedBox& observed_box : observed_boxes_it->second) {
+    const voxblox::Point box_half_extent =
+        0.5f * (observed_box.t_submap_max - observed_box.t_submap_min);
+    const voxblox::Point t_F_box_center =
+        T_F_submap *
+        (0.5f * (observed_box.t_submap_min + observed_box.t_submap_max));
+    const voxblox::Point aabb_half_extent = R_F_submap_abs * box_half_extent;
+    const auto min_cell_index =
         voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
-            t_mission_block_center, block_grid_size_inv_);
-
-    for (const voxblox::BlockIndex& colliding_index_offset :
-         colliding_index_offsets) {
-      UnorderedSubmapIdSet& submap_id_set =
-          spatial_submap_id_hash_[mission_block_index + colliding_index_offset];
-      if (remove) {
-        submap_id_set.erase(submap_id);
-      } else {
-        submap_id_set.insert(submap_id);
+            t_F_box_center - aabb_half_extent, block_grid_size_inv_);
+    const auto max_cell_index =
+        voxblox::getGridIndexFromPoint<voxblox::BlockIndex>(
+            t_F_box_center + aabb_half_extent, block_grid_size_inv_);
+
+    voxblox::BlockIndex cell_index;
+    for (cell_index.x() = min_cell_index.x();
+         cell_index.x() <= max_cell_index.x(); ++cell_index.x()) {
+      for (cell_index.y() = min_cell_index.y();
+           cell_index.y() <= max_cell_index.y(); ++cell_index.y()) {
+        for (cell_index.z() = min_cell_index.z();
+             cell_index.z() <= max_cell_index.z(); ++cell_index.z()) {
+          const voxblox::Point t_F_cell_center =
+              voxblox::getCenterPointFromGridIndex(cell_index,
+                                                   block_grid_size_);
+          if (!orientedBoxOverlapsCell(t_F_box_center, box_half_extent,
+                                       R_F_submap, t_F_cell_center)) {
+            continue;
+          }
+          ++num_cells;
+          changed_cells_.insert(cell_index);
+          if (remove) {
+            auto cell_it = spatial_submap_id_hash_.find(cell_index);
+            if (cell_it != spatial_submap_id_hash_.end()) {
+              cell_it->second.erase(submap_id);
+              if (cell_it->second.empty()) {
+                spatial_submap_id_hash_.erase(cell_it);
+              }
+            }
+          } else {
+            spatial_submap_id_hash_[cell_index].insert(submap_id);
+          }
+        }
       }
     }
   }
+  VLOG(3) << "Spatial hash: Submap " << submap_id << " has "
+          << observed_boxes_it->second.size() << " observed blocks, covering "
+          << num_cells << " cell overlaps.";
 
   // Update the record of what submaps currently are in the spatial hash
   if (remove) {
@@ -230,6 +337,94 @@ void VoxgraphSpatialHash::addSubmap(
   }
 }
 
+std::vector<VoxgraphSpatialHash::ObservedBox>
+VoxgraphSpatialHash::computeObservedBoxes(
+    const voxblox::Layer<voxblox::TsdfVoxel>& submap_tsdf) {
+  // NOTE: The boxes are padded by half a voxel, s.t. they enclose the observed
+  //       voxels instead of only their centers.
+  const voxblox::Point half_voxel =
+      voxblox::Point::Constant(0.5f * submap_tsdf.voxel_size());
+  std::vector<ObservedBox> observed_boxes;
+  const voxblox::BlockIndexList submap_blocks =
+      morton_order::getAllAllocatedBlocks(submap_tsdf);
+  observed_boxes.reserve(submap_blocks.size());
+  for (const voxblox::BlockIndex& submap_block_index : submap_blocks) {
+    voxblox::Point t_submap_observed_min;
+    voxblox::Point t_submap_observed_max;
+    if (getObservedBoundingBox(submap_tsdf.getBlockByIndex(submap_block_index),
+                               &t_submap_observed_min,
+                               &t_submap_observed_max)) {
+      observed_boxes.push_back({t_submap_observed_min - half_voxel,
+                                t_submap_observed_max + half_voxel});
+    }
+  }
+  return observed_boxes;
+}
+
+bool VoxgraphSpatialHash::getObservedBoundingBox(
+    const voxblox::Block<voxblox::TsdfVoxel>& block,
+    voxblox::Point* t_submap_observed_min,
+    voxblox::Point* t_submap_observed_max) {
+  CHECK_NOTNULL(t_submap_observed_min);
+  CHECK_NOTNULL(t_submap_observed_max);
+  *t_submap_observed_min = voxblox::Point::Constant(INFINITY);
+  *t_submap_observed_max = voxblox::Point::Constant(-INFINITY);
+  bool block_contains_observed_voxels = false;
+  for (size_t linear_index = 0u; linear_index < block.num_voxels();
+       ++linear_index) {
+    if (voxblox::utils::isObservedVoxel(
+            block.getVoxelByLinearIndex(linear_index))) {
+      const voxblox::Point t_submap_voxel =
+          block.computeCoordinatesFromLinearIndex(linear_index);
+      *t_submap_observed_min = t_submap_observed_min->cwiseMin(t_submap_voxel);
+      *t_submap_observed_max = t_submap_observed_max->cwiseMax(t_submap_voxel);
+      block_contains_observed_voxels = true;
+    }
+  }
+  return block_contains_observed_voxels;
+}
+
+bool VoxgraphSpatialHash::orientedBoxOverlapsCell(
+    const voxblox::Point& t_F_box_center,
+    const voxblox::Point& box_half_extent,
+    const Eigen::Matrix<FloatingPoint, 3, 3>& R_F_box,
+    const voxblox::Point& t_F_cell_center) const {
+  // Separating axis test between the oriented box and the axis aligned cell.
+  // The candidate axes are the 3 cell axes, the 3 box axes and their 9 cross
+  // products.
+  const voxblox::Point cell_half_extent =
+      voxblox::Point::Constant(0.5f * block_grid_size_);
+  const voxblox::Point t_F_box_cell = t_F_cell_center - t_F_box_center;
+  constexpr FloatingPoint kEpsilon = 1e-6f;
+  auto isSeparatingAxis = [&](const voxblox::Point& axis) {
+    if (axis.squaredNorm() < kEpsilon) {
+      // Degenerate cross product of (nearly) parallel axes
+      return false;
+    }
+    const FloatingPoint box_radius =
+        box_half_extent.dot((R_F_box.transpose() * axis).cwiseAbs());
+    const FloatingPoint cell_radius = cell_half_extent.dot(axis.cwiseAbs());
+    return box_radius + cell_radius + kEpsilon <
+           std::abs(t_F_box_cell.dot(axis));
+  };
+
+  for (int i = 0; i < 3; ++i) {
+    const voxblox::Point cell_axis = voxblox::Point::Unit(i);
+    const voxblox::Point box_axis = R_F_box.col(i);
+    if (isSeparatingAxis(cell_axis) || isSeparatingAxis(box_axis)) {
+      return false;
+    }
+  }
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      if (isSeparatingAxis(voxblox::Point::Unit(i).cross(R_F_box.col(j)))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 bool VoxgraphSpatialHash::submapPoseChanged(
     const voxgraph::SubmapID submap_id,
     const voxgraph::Transformation& T_F_submap_new) {
@@ -18,6 +18,9 @@ void SkeletonPlanner::Config::checkParams() const {
   checkParamGT(max_replan_attempts_to_chosen_frontier, 0,
                "max_replan_attempts_to_chosen_frontier");
   checkParamGT(sensor_vertical_fov_rad, 0.f, "sensor_vertical_fov_rad");
+  if (sensor_max_range_m != -1.f) {
+    checkParamGT(sensor_max_range_m, 0.f, "sensor_max_range_m");
+  }
 }
 
 void SkeletonPlanner::Config::fromRosParam() {
@@ -35,6 +38,7 @@ void SkeletonPlanner::Config::fromRosParam() {
   rosParam("max_closest_frontier_search_time_sec",
            &max_closest_frontier_search_time_sec);
   rosParam("sensor_vertical_fov_rad", &sensor_vertical_fov_rad);
+  rosParam("sensor_max_range_m", &sensor_max_range_m);
   rosParam("backtracking_distance_m", &backtracking_distance_m);
   nh_private_namespace = rosParamNameSpace() + "/skeleton";
 }
@@ -55,6 +59,7 @@ void SkeletonPlanner::Config::printFields() const {
   printField("max_replan_attempts_to_chosen_frontier",
              max_replan_attempts_to_chosen_frontier);
   printField("sensor_vertical_fov_rad", sensor_vertical_fov_rad);
+  printField("sensor_max_range_m", sensor_max_range_m);
   printField("backtracking_distance_m", backtracking_distance_m);
 }
 
@@ -177,6 +182,7 @@ bool SkeletonPlanner::computeFrontiers() {
 
 bool SkeletonPlanner::computeGoalPoint() {
   is_backtracking_ = false;
+  skeleton_a_star_.updateSubmapPoses();
 
   // Compute the frontier with the shortest path to it.
   auto t_start = std::chrono::high_resolution_clock::now();
@@ -191,8 +197,8 @@ bool SkeletonPlanner::computeGoalPoint() {
       data.num_points++;
     }
     data.centroid /= data.num_points;
-    // NOTE(schmluk): Currently copy the frontiers since it's not that many.
     data.frontier_points = frontier;
+    data.frontier_id = frontier_data_.size() - 1u;
   }
   if (frontier_data_.empty()) {
     LOG(WARNING) << "No active frontiers found to compute goal points from.";
@@ -201,8 +207,16 @@ bool SkeletonPlanner::computeGoalPoint() {
   }
 
   // Frontier clustering.
+  const FrontierIndex* frontier_index = &getActiveFrontierIndex();
   if (config_.use_centroid_clustering) {
     clusterFrontiers();
+    std::vector<Point> clustered_centroids;
+    clustered_centroids.reserve(frontier_data_.size());
+    for (const FrontierSearchData& frontier : frontier_data_) {
+      clustered_centroids.emplace_back(frontier.centroid);
+    }
+    clustered_frontier_index_.build(std::move(clustered_centroids));
+    frontier_index = &clustered_frontier_index_;
   }
 
   // Search the closest reachable frontier.
@@ -214,45 +228,59 @@ bool SkeletonPlanner::computeGoalPoint() {
   bool found_a_valid_path = false;
   std::vector<GlobalVertexId> start_vertex_candidates;
   if (searchSkeletonStartVertices(&start_point, &start_vertex_candidates)) {
-    // Sort the frontiers by euclidean distance.
     for (auto& frontier : frontier_data_) {
       frontier.euclidean_distance =
           (current_robot_position - frontier.centroid).norm();
+      frontier.path_distance = std::numeric_limits<FloatingPoint>::max();
+      frontier.reachability = FrontierSearchData::kUnchecked;
     }
-    std::sort(frontier_data_.begin(), frontier_data_.end(),
-              [](const FrontierSearchData& lhs, const FrontierSearchData& rhs) {
-                return lhs.euclidean_distance < rhs.euclidean_distance;
-              });
 
     // Compute paths to frontiers to determine the closest reachable one. Start
     // with closest and use euclidean distance as lower bound to prune
-    // candidates.
+    // candidates. The frontiers are fetched from the spatial index in batches
+    // of growing size, s.t. the pruned ones never need to be ordered.
     FloatingPoint shortest_path = std::numeric_limits<FloatingPoint>::max();
-    bool time_exceeded = false;
-    for (auto& candidate : frontier_data_) {
-      if (!time_exceeded &&
-          config_.max_closest_frontier_search_time_sec <
-              std::chrono::duration_cast<std::chrono::seconds>(
-                  std::chrono::high_resolution_clock::now() - t_start)
-                  .count()) {
-        LOG_IF(INFO, config_.verbosity >= 1)
-            << "Maximum closest frontier searching time exceeded. Will "
-               "continue with the frontiers we found so far.";
-        time_exceeded = true;
-      }
+    std::vector<bool> is_visited(frontier_data_.size(), false);
+    size_t num_nearest = 0u;
+    size_t batch_size = 16u;
+    bool search_finished = false;
+    while (!search_finished && num_nearest < frontier_data_.size()) {
+      num_nearest += batch_size;
+      batch_size *= 2u;
+      // NOTE: Frontiers at equal distance can switch places between batches,
+      //       so the visited ones are tracked explicitly.
+      for (const FrontierIndex::FrontierDistance& nearest :
+           frontier_index->getNearestFrontiers(current_robot_position,
+                                               num_nearest)) {
+        if (is_visited[nearest.first]) {
+          continue;
+        }
+        is_visited[nearest.first] = true;
+        if (config_.max_closest_frontier_search_time_sec <
+            std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::high_resolution_clock::now() - t_start)
+                .count()) {
+          LOG_IF(INFO, config_.verbosity >= 1)
+              << "Maximum closest frontier searching time exceeded. Will "
+                 "continue with the frontiers we found so far.";
+          search_finished = true;
+          break;
+        }
+        if (shortest_path <= nearest.second) {
+          // The remaining frontiers can never be closer than what we already
+          // have.
+          search_finished = true;
+          break;
+        }
 
-      if (time_exceeded || candidate.euclidean_distance >= shortest_path) {
-        // These points can never be closer than what we already have.
-        candidate.path_distance = std::numeric_limits<FloatingPoint>::max();
-        candidate.reachability = FrontierSearchData::kUnchecked;
-      } else {
         // Try to find a path via linked skeleton planning.
+        FrontierSearchData& candidate = frontier_data_[nearest.first];
         path_counter++;
         std::vector<RelativeWayPoint> way_points;
         bool frontier_is_observable = false;
         if (computePathToFrontier(start_point, start_vertex_candidates,
-                                  candidate.centroid, candidate.frontier_points,
-                                  &way_points, &frontier_is_observable)) {
+                                  candidate, &way_points,
+                                  &frontier_is_observable)) {
           // Frontier is reachable, save path and compute path length.
           candidate.way_points = way_points;
           candidate.path_distance =
@@ -266,15 +294,12 @@ bool SkeletonPlanner::computeGoalPoint() {
           shortest_path = std::min(shortest_path, candidate.path_distance);
           candidate.reachability = FrontierSearchData::kReachable;
           found_a_valid_path = true;
-        } else {
+        } else if (frontier_is_observable) {
           // Inaccessible frontier.
-          candidate.path_distance = std::numeric_limits<FloatingPoint>::max();
-          if (frontier_is_observable) {
-            candidate.reachability = FrontierSearchData::kUnreachable;
-          } else {
-            ++unobservable_frontier_counter;
-            candidate.reachability = FrontierSearchData::kInvalidGoal;
-          }
+          candidate.reachability = FrontierSearchData::kUnreachable;
+        } else {
+          ++unobservable_frontier_counter;
+          candidate.reachability = FrontierSearchData::kInvalidGoal;
         }
       }
     }
@@ -320,7 +345,7 @@ bool SkeletonPlanner::computeGoalPoint() {
             config_.backtracking_distance_m) {
           if (min_offset <
               (t_odom_current_crumb - t_odom_previous_crumb).norm()) {
-            const std::vector<SubmapId> overlapping_submaps =
+            const SubmapIdListView overlapping_submaps =
                 comm_->map()->getSubmapIdsAtPosition(t_odom_current_crumb);
             SubmapId youngest_submap_id = *std::max_element(
                 overlapping_submaps.begin(), overlapping_submaps.end());
@@ -403,28 +428,49 @@ bool SkeletonPlanner::computeGoalPoint() {
 }
 
 void SkeletonPlanner::clusterFrontiers() {
-  // Search all frontiers for nearby centroids and merge incrementally until all
-  // centroids are further than 'centroid_clustering_radius' apart.
+  // Merge all frontiers whose centroids are within 'centroid_clustering_radius'
+  // of a frontier into it, visiting them in order. The nearby centroids are
+  // looked up in the frontier evaluator's spatial index, whose ids are still
+  // the positions in frontier_data_.
+  const FrontierIndex& frontier_index = getActiveFrontierIndex();
+  CHECK_EQ(frontier_index.size(), frontier_data_.size());
   const int num_frontiers = frontier_data_.size();
-  for (auto it = frontier_data_.begin(); it != frontier_data_.end(); ++it) {
-    auto it2 = it;
-    it2++;
-    while (it2 != frontier_data_.end()) {
-      if ((it2->centroid - it->centroid).norm() <=
-          config_.centroid_clustering_radius) {
-        // Nearby frontier centroids are merged by weight.
-        it->centroid =
-            it->centroid * static_cast<FloatingPoint>(it->num_points) +
-            it2->centroid * static_cast<FloatingPoint>(it2->num_points);
-        it->num_points += it2->num_points;
-        it->centroid /= static_cast<FloatingPoint>(it->num_points);
-        it->clusters++;
-        it2 = frontier_data_.erase(it2);
-      } else {
-        it2++;
+  std::vector<bool> is_merged(num_frontiers, false);
+  for (int i = 0; i < num_frontiers; ++i) {
+    if (is_merged[i]) {
+      continue;
+    }
+    FrontierSearchData& cluster = frontier_data_[i];
+    for (const FrontierIndex::FrontierDistance& neighbor :
+         frontier_index.getFrontiersWithinRadius(
+             frontier_index.getCentroid(i),
+             config_.centroid_clustering_radius)) {
+      const int j = neighbor.first;
+      if (j <= i || is_merged[j]) {
+        continue;
       }
+      // Nearby frontier centroids are merged by weight.
+      const FrontierSearchData& other = frontier_data_[j];
+      cluster.centroid =
+          cluster.centroid * static_cast<FloatingPoint>(cluster.num_points) +
+          other.centroid * static_cast<FloatingPoint>(other.num_points);
+      cluster.num_points += other.num_points;
+      cluster.centroid /= static_cast<FloatingPoint>(cluster.num_points);
+      cluster.clusters++;
+      is_merged[j] = true;
     }
   }
+  int num_clusters = 0;
+  for (int i = 0; i < num_frontiers; ++i) {
+    if (!is_merged[i]) {
+      if (num_clusters != i) {
+        frontier_data_[num_clusters] = std::move(frontier_data_[i]);
+      }
+      ++num_clusters;
+    }
+  }
+  frontier_data_.resize(num_clusters);
+
   // Logging.
   LOG_IF(INFO, config_.verbosity >= 3)
       << "Clustered " << num_frontiers - frontier_data_.size()
@@ -647,12 +693,29 @@ bool SkeletonPlanner::searchSkeletonStartVertices(
   return true;
 }
 
+template <typename PointRange>
+bool SkeletonPlanner::hasEnoughVisibleFrontierPoints(
+    const PointRange& frontier_points, const Point& skeleton_vertex_point) {
+  int num_visible_frontier_points = 0;
+  for (const Point& frontier_point : frontier_points) {
+    if (isFrontierPointObservableFromPosition(frontier_point,
+                                              skeleton_vertex_point)) {
+      if (SubmapFrontierEvaluator::config_.min_num_visible_frontier_points <
+          ++num_visible_frontier_points) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 bool SkeletonPlanner::computePathToFrontier(
     const Point& start_point,
     const std::vector<GlobalVertexId>& start_vertex_candidates,
-    const Point& frontier_centroid, const std::vector<Point>& frontier_points,
+    const FrontierSearchData& frontier,
     std::vector<RelativeWayPoint>* way_points, bool* frontier_is_observable) {
   CHECK_NOTNULL(way_points);
+  const Point& frontier_centroid = frontier.centroid;
 
   // Search the N skeleton vertices that are closest to the frontier centroid,
   // and from which at least M frontier points can be observed.
@@ -661,18 +724,16 @@ bool SkeletonPlanner::computePathToFrontier(
           frontier_centroid,
           skeleton_a_star_.getConfig().max_num_end_vertex_candidates,
           [&](const Point& point, const Point& skeleton_vertex_point) {
-            int num_visible_frontier_points = 0;
-            for (const Point& frontier_point : frontier_points) {
-              if (isFrontierPointObservableFromPosition(
-                      frontier_point, skeleton_vertex_point)) {
-                if (SubmapFrontierEvaluator::config_
-                        .min_num_visible_frontier_points <
-                    ++num_visible_frontier_points) {
-                  return true;
-                }
-              }
+            // Only the frontier points within sensor range are considered.
+            if (0.f < config_.sensor_max_range_m) {
+              return hasEnoughVisibleFrontierPoints(
+                  getActiveFrontierIndex().getFrontierPointsWithinRadius(
+                      skeleton_vertex_point, config_.sensor_max_range_m,
+                      frontier.frontier_id),
+                  skeleton_vertex_point);
             }
-            return false;
+            return hasEnoughVisibleFrontierPoints(frontier.frontier_points,
+                                                  skeleton_vertex_point);
           });
   if (end_vertex_candidates.empty()) {
     LOG(INFO) << "Could not find any skeleton vertices from which the frontier "